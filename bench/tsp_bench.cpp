@@ -0,0 +1,344 @@
+#include <benchmark/benchmark.h>
+#include <tsp/tsp.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace tsp;
+
+namespace {
+std::atomic<uint64_t> num_allocations{0};
+
+// Kept out of line so that the compiler can't pair the malloc and free inside with new and delete expressions
+__attribute__((noinline)) auto CountedAlloc(std::size_t size, std::size_t alignment) noexcept -> void * {
+    num_allocations.fetch_add(1, std::memory_order_relaxed);
+    size = size == 0 ? 1 : size;
+    if (alignment <= alignof(std::max_align_t)) {
+        return std::malloc(size);
+    }
+    // aligned_alloc requires the size to be a multiple of the alignment
+    return std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+}
+
+__attribute__((noinline)) void CountedFree(void *ptr) noexcept {
+    std::free(ptr);
+}
+
+auto CountedAllocOrThrow(std::size_t size, std::size_t alignment) -> void * {
+    if (void *ptr = CountedAlloc(size, alignment)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+}    // namespace
+
+// Count every heap allocation so that each benchmark can report allocations per operation. The whole family of
+// global allocation functions is replaced, so that array, aligned and nothrow allocations are counted as well.
+auto operator new(std::size_t size) -> void * {
+    return CountedAllocOrThrow(size, 0);
+}
+auto operator new[](std::size_t size) -> void * {
+    return CountedAllocOrThrow(size, 0);
+}
+auto operator new(std::size_t size, std::align_val_t alignment) -> void * {
+    return CountedAllocOrThrow(size, static_cast<std::size_t>(alignment));
+}
+auto operator new[](std::size_t size, std::align_val_t alignment) -> void * {
+    return CountedAllocOrThrow(size, static_cast<std::size_t>(alignment));
+}
+auto operator new(std::size_t size, const std::nothrow_t &) noexcept -> void * {
+    return CountedAlloc(size, 0);
+}
+auto operator new[](std::size_t size, const std::nothrow_t &) noexcept -> void * {
+    return CountedAlloc(size, 0);
+}
+auto operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept -> void * {
+    return CountedAlloc(size, static_cast<std::size_t>(alignment));
+}
+auto operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept -> void * {
+    return CountedAlloc(size, static_cast<std::size_t>(alignment));
+}
+void operator delete(void *ptr) noexcept {
+    CountedFree(ptr);
+}
+void operator delete[](void *ptr) noexcept {
+    CountedFree(ptr);
+}
+void operator delete(void *ptr, std::size_t) noexcept {
+    CountedFree(ptr);
+}
+void operator delete[](void *ptr, std::size_t) noexcept {
+    CountedFree(ptr);
+}
+void operator delete(void *ptr, std::align_val_t) noexcept {
+    CountedFree(ptr);
+}
+void operator delete[](void *ptr, std::align_val_t) noexcept {
+    CountedFree(ptr);
+}
+void operator delete(void *ptr, std::size_t, std::align_val_t) noexcept {
+    CountedFree(ptr);
+}
+void operator delete[](void *ptr, std::size_t, std::align_val_t) noexcept {
+    CountedFree(ptr);
+}
+void operator delete(void *ptr, const std::nothrow_t &) noexcept {
+    CountedFree(ptr);
+}
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept {
+    CountedFree(ptr);
+}
+void operator delete(void *ptr, std::align_val_t, const std::nothrow_t &) noexcept {
+    CountedFree(ptr);
+}
+void operator delete[](void *ptr, std::align_val_t, const std::nothrow_t &) noexcept {
+    CountedFree(ptr);
+}
+
+namespace {
+constexpr int NUM_WALK_STEPS = 64;
+constexpr int NUM_ACTIONS = 1024;
+constexpr int MAX_IMAGE_BOARD_SIZE = 64;
+constexpr int NUM_ROLLOUTS = 4096;
+constexpr int ROLLOUT_STEPS = 200;
+constexpr int NUM_SIMULATIONS = 4096;
+
+// Boards have the same layout as scripts/generate_levelset.py, with the same seed for every run
+auto get_board(const benchmark::State &state) -> std::string {
+    const GeneratorOptions options{.map_size = static_cast<int>(state.range(0)),
+                                   .num_cities = static_cast<int>(state.range(1)),
+                                   .add_walls = true};
+    return generate_board_str(options, 0);
+}
+
+// A state part way through an episode, so that some cities are visited
+auto get_mid_episode_state(const benchmark::State &state) -> TSPGameState {
+    TSPGameState game_state(get_board(state));
+    std::mt19937 rng(0);
+    for (int i = 0; i < NUM_WALK_STEPS * static_cast<int>(state.range(0)); ++i) {
+        game_state.apply_action(static_cast<Action>(rng() % kNumActions));
+    }
+    return game_state;
+}
+
+// Report the heap allocations made per iteration since construction
+class AllocationCounter {
+public:
+    explicit AllocationCounter(benchmark::State &state_)
+        : state(state_), start(num_allocations.load(std::memory_order_relaxed)) {}
+    AllocationCounter(const AllocationCounter &) = delete;
+    AllocationCounter(AllocationCounter &&) = delete;
+    auto operator=(const AllocationCounter &) -> AllocationCounter & = delete;
+    auto operator=(AllocationCounter &&) -> AllocationCounter & = delete;
+    ~AllocationCounter() {
+        const auto allocations = num_allocations.load(std::memory_order_relaxed) - start;
+        state.counters["allocs_per_op"] =
+            benchmark::Counter(static_cast<double>(allocations), benchmark::Counter::kAvgIterations);
+        state.counters["cells"] = static_cast<double>(state.range(0) * state.range(0));
+    }
+
+private:
+    benchmark::State &state;
+    uint64_t start;
+};
+
+void AddBoardArgs(benchmark::internal::Benchmark *bench, int max_size) {
+    bench->ArgNames({"size", "cities"});
+    // City counts of the shipped train (10x10) and test (16x16) level sets
+    bench->Args({10, 2});
+    bench->Args({16, 8});
+    for (const int size : {32, 64, 128, 256}) {
+        for (const int num_cities : {4, 16, 64}) {
+            if (size <= max_size) {
+                bench->Args({size, num_cities});
+            }
+        }
+    }
+}
+
+void BoardArgs(benchmark::internal::Benchmark *bench) {
+    AddBoardArgs(bench, std::numeric_limits<int>::max());
+}
+
+// Full resolution images of larger boards are hundreds of megabytes
+void ImageBoardArgs(benchmark::internal::Benchmark *bench) {
+    AddBoardArgs(bench, MAX_IMAGE_BOARD_SIZE);
+}
+
+void BM_Construct(benchmark::State &state) {
+    const auto board_str = get_board(state);
+    AllocationCounter counter(state);
+    for (auto _ : state) {
+        TSPGameState game_state(board_str);
+        benchmark::DoNotOptimize(game_state);
+    }
+}
+BENCHMARK(BM_Construct)->Apply(BoardArgs);
+
+void BM_Copy(benchmark::State &state) {
+    const auto game_state = get_mid_episode_state(state);
+    AllocationCounter counter(state);
+    for (auto _ : state) {
+        auto copy = game_state;
+        benchmark::DoNotOptimize(copy);
+    }
+}
+BENCHMARK(BM_Copy)->Apply(BoardArgs);
+
+void BM_ApplyAction(benchmark::State &state) {
+    auto game_state = get_mid_episode_state(state);
+    std::mt19937 rng(0);
+    std::vector<Action> actions(NUM_ACTIONS);
+    for (auto &action : actions) {
+        action = static_cast<Action>(rng() % kNumActions);
+    }
+    std::size_t i = 0;
+    AllocationCounter counter(state);
+    for (auto _ : state) {
+        game_state.apply_action(actions[i++ % NUM_ACTIONS]);
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_ApplyAction)->Apply(BoardArgs);
+
+void BM_GetHash(benchmark::State &state) {
+    const auto game_state = get_mid_episode_state(state);
+    AllocationCounter counter(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(game_state.get_hash());
+    }
+}
+BENCHMARK(BM_GetHash)->Apply(BoardArgs);
+
+void BM_GetObservation(benchmark::State &state) {
+    const auto game_state = get_mid_episode_state(state);
+    AllocationCounter counter(state);
+    for (auto _ : state) {
+        auto obs = game_state.get_observation();
+        benchmark::DoNotOptimize(obs.data());
+    }
+}
+BENCHMARK(BM_GetObservation)->Apply(BoardArgs);
+
+void BM_GetObservationBuffer(benchmark::State &state) {
+    const auto game_state = get_mid_episode_state(state);
+    std::vector<float> obs(static_cast<std::size_t>(kNumChannels * game_state.get_level()->get_num_cells()));
+    AllocationCounter counter(state);
+    for (auto _ : state) {
+        game_state.get_observation(obs.data());
+        benchmark::DoNotOptimize(obs.data());
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_GetObservationBuffer)->Apply(BoardArgs);
+
+void BM_ToImage(benchmark::State &state) {
+    const auto game_state = get_mid_episode_state(state);
+    AllocationCounter counter(state);
+    for (auto _ : state) {
+        auto img = game_state.to_image();
+        benchmark::DoNotOptimize(img.data());
+    }
+}
+BENCHMARK(BM_ToImage)->Apply(ImageBoardArgs);
+
+void BM_RenderPixels(benchmark::State &state) {
+    const auto game_state = get_mid_episode_state(state);
+    const Renderer renderer;
+    std::vector<uint8_t> img(static_cast<std::size_t>(3 * game_state.get_level()->get_num_cells()));
+    AllocationCounter counter(state);
+    for (auto _ : state) {
+        renderer.render(game_state, img.data());
+        benchmark::DoNotOptimize(img.data());
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_RenderPixels)->Apply(BoardArgs);
+
+void BM_GetUnvisitedCityIndices(benchmark::State &state) {
+    const auto game_state = get_mid_episode_state(state);
+    AllocationCounter counter(state);
+    for (auto _ : state) {
+        auto indices = game_state.get_unvisited_city_indices();
+        benchmark::DoNotOptimize(indices.data());
+    }
+}
+BENCHMARK(BM_GetUnvisitedCityIndices)->Apply(BoardArgs);
+
+void BM_GetVisitedCityIndices(benchmark::State &state) {
+    const auto game_state = get_mid_episode_state(state);
+    AllocationCounter counter(state);
+    for (auto _ : state) {
+        auto indices = game_state.get_visited_city_indices();
+        benchmark::DoNotOptimize(indices.data());
+    }
+}
+BENCHMARK(BM_GetVisitedCityIndices)->Apply(BoardArgs);
+
+void BM_IsSolution(benchmark::State &state) {
+    const auto game_state = get_mid_episode_state(state);
+    AllocationCounter counter(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(game_state.is_solution());
+    }
+}
+BENCHMARK(BM_IsSolution)->Apply(BoardArgs);
+
+void ThreadArgs(benchmark::internal::Benchmark *bench) {
+    bench->ArgName("threads")->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
+}
+
+// Random rollouts on a shipped 10x10 level, to measure scaling with the number of threads
+void BM_Rollouts(benchmark::State &state) {
+    const LevelSet level_set(std::string(TSP_LEVEL_DIR) + "/train.txt");
+    const std::vector<TSPGameState> states(NUM_ROLLOUTS, TSPGameState(std::string(level_set.get_board_str(0))));
+    const RolloutOptions options{.max_steps = ROLLOUT_STEPS, .num_threads = static_cast<int>(state.range(0))};
+    for (auto _ : state) {
+        const auto batch = run_rollouts(states, options);
+        benchmark::DoNotOptimize(batch.total_steps);
+    }
+    state.counters["rollouts_per_second"] =
+        benchmark::Counter(static_cast<double>(state.iterations() * NUM_ROLLOUTS), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_Rollouts)->Apply(ThreadArgs);
+
+void BM_MCTS(benchmark::State &state) {
+    const LevelSet level_set(std::string(TSP_LEVEL_DIR) + "/train.txt");
+    const TSPGameState game_state{std::string(level_set.get_board_str(0))};
+    const MCTSOptions options{.num_simulations = NUM_SIMULATIONS, .num_threads = static_cast<int>(state.range(0))};
+    for (auto _ : state) {
+        const auto result = search_mcts(game_state, options);
+        benchmark::DoNotOptimize(result.action);
+    }
+    state.counters["simulations_per_second"] =
+        benchmark::Counter(static_cast<double>(state.iterations() * NUM_SIMULATIONS), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_MCTS)->Apply(ThreadArgs);
+}    // namespace
+
+int main(int argc, char **argv) {
+    // Recorded in the JSON context, so that runs with and without instrumentation can be compared
+    benchmark::AddCustomContext("tsp_instrumentation",
+                                kInstrumentationTimersEnabled ? "timers"
+                                : kInstrumentationEnabled     ? "counters"
+                                                              : "off");
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    // The context is written before the run, so the counts and cycles gathered over the run are reported after it
+    if constexpr (kInstrumentationEnabled) {
+        std::cerr << "tsp_instrumentation snapshot:\n" << get_instrumentation_snapshot().to_string() << std::flush;
+    }
+    benchmark::Shutdown();
+    return 0;
+}
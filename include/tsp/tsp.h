@@ -1,6 +1,21 @@
 #ifndef TSP_H_
 #define TSP_H_
 
+#include "../../src/distance_cache.h"
+#include "../../src/held_karp.h"
+#include "../../src/heuristic.h"
+#include "../../src/instrumentation.h"
+#include "../../src/level_generator.h"
+#include "../../src/level_set.h"
+#include "../../src/mcts.h"
+#include "../../src/observation.h"
+#include "../../src/renderer.h"
+#include "../../src/rollout.h"
+#include "../../src/serialization.h"
+#include "../../src/solver.h"
+#include "../../src/state_arena.h"
+#include "../../src/symmetry.h"
 #include "../../src/tsp_base.h"
+#include "../../src/tsp_vector_env.h"
 
 #endif    // TSP_H_
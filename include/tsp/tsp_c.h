@@ -0,0 +1,183 @@
+#ifndef TSP_C_H_
+#define TSP_C_H_
+
+/**
+ * Stable C API of the tsp_c shared library, for use through FFI (ctypes, cffi, Rust, Julia, ...).
+ *
+ * Environments are opaque handles, and the batched calls step or reset an array of handles in one call, writing their
+ * outputs straight into buffers owned by the caller. Functions return a tsp_status, and on failure the message of the
+ * last error on the calling thread is available from tsp_last_error(). Batched calls validate all of their inputs
+ * before touching any environment, so a call which fails on invalid input leaves every environment unchanged.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#if defined(TSP_C_BUILD)
+#define TSP_C_API __declspec(dllexport)
+#else
+#define TSP_C_API __declspec(dllimport)
+#endif
+#else
+#define TSP_C_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Incremented whenever a function signature or the meaning of an argument changes */
+#define TSP_C_API_VERSION 1
+
+/* Number of observation channels, and of actions (up, right, down, left) */
+#define TSP_NUM_CHANNELS 8
+#define TSP_NUM_ACTIONS 4
+
+typedef enum tsp_status {
+    TSP_OK = 0,
+    TSP_ERROR_INVALID_ARGUMENT = 1,
+    TSP_ERROR_IO = 2,
+    TSP_ERROR_OUT_OF_MEMORY = 3,
+    TSP_ERROR_INTERNAL = 4,
+} tsp_status;
+
+/* Flags of tsp_step() */
+typedef enum tsp_step_flags {
+    /* Reset environments which reach the solution. Their reward, done flag and hash describe the solving step, while
+       their observation is of the next level */
+    TSP_STEP_AUTO_RESET = 1,
+    /* The observation buffer holds the previous observation of each environment, as written by the last tsp_step() or
+       tsp_reset() of the same batch, so only the cells which changed are rewritten */
+    TSP_STEP_INCREMENTAL_OBSERVATIONS = 2,
+} tsp_step_flags;
+
+/* A single environment, which plays a sequence of levels */
+typedef struct tsp_env tsp_env;
+
+/* Thread pool for the batched calls */
+typedef struct tsp_pool tsp_pool;
+
+/**
+ * Get the API version the library was built with
+ * @return TSP_C_API_VERSION of the library
+ */
+TSP_C_API int tsp_api_version(void);
+
+/**
+ * Get the message of the last error on the calling thread
+ * @return The message, valid until the next failing call on this thread, or an empty string if there was none
+ */
+TSP_C_API const char *tsp_last_error(void);
+
+/**
+ * Create a thread pool for the batched calls.
+ * A pool must not be used by more than one batched call at a time.
+ * @param num_threads Number of threads including the caller, or <= 0 to use the hardware concurrency
+ * @param pool Set to the new pool
+ * @return TSP_OK on success
+ */
+TSP_C_API tsp_status tsp_pool_create(int num_threads, tsp_pool **pool);
+
+/**
+ * Destroy a thread pool
+ * @param pool The pool, which may be NULL
+ */
+TSP_C_API void tsp_pool_destroy(tsp_pool *pool);
+
+/**
+ * Create an environment from a level string.
+ * The environment replays the same level on each reset.
+ * @param board_str The level string, e.g. "5|5|03|00|..."
+ * @param env Set to the new environment
+ * @return TSP_OK on success
+ */
+TSP_C_API tsp_status tsp_env_create(const char *board_str, tsp_env **env);
+
+/**
+ * Create a batch of environments over the levels of a binary level file (see write_levels()), sharing the levels.
+ * Environment i starts on level i % num_levels, and each reset moves it num_envs levels forward.
+ * @param path Path to the binary level file
+ * @param num_envs Number of environments
+ * @param envs Array of num_envs handles to set to the new environments
+ * @return TSP_OK on success, in which case every handle is set, and otherwise none are
+ */
+TSP_C_API tsp_status tsp_env_create_from_file(const char *path, int num_envs, tsp_env **envs);
+
+/**
+ * Create a batch of environments over a list of level strings, sharing the levels.
+ * Environment i starts on level i % num_levels, and each reset moves it num_envs levels forward.
+ * @param board_strs Array of num_levels level strings
+ * @param num_levels Number of levels
+ * @param num_envs Number of environments
+ * @param envs Array of num_envs handles to set to the new environments
+ * @return TSP_OK on success, in which case every handle is set, and otherwise none are
+ */
+TSP_C_API tsp_status tsp_env_create_batch(const char *const *board_strs, int num_levels, int num_envs,
+                                          tsp_env **envs);
+
+/**
+ * Destroy an environment
+ * @param env The environment, which may be NULL
+ */
+TSP_C_API void tsp_env_destroy(tsp_env *env);
+
+/**
+ * Destroy a batch of environments
+ * @param envs Array of num_envs environments, any of which may be NULL
+ * @param num_envs Number of environments
+ */
+TSP_C_API void tsp_env_destroy_batch(tsp_env *const *envs, int num_envs);
+
+/**
+ * Get the observation shape of an environment
+ * @param env The environment
+ * @param shape Set to the observation channels, rows and cols
+ * @return TSP_OK on success
+ */
+TSP_C_API tsp_status tsp_env_observation_shape(const tsp_env *env, int shape[3]);
+
+/**
+ * Get the legal actions of an environment
+ * @param env The environment
+ * @param mask Set to a mask with bit a set if action a moves the agent
+ * @return TSP_OK on success
+ */
+TSP_C_API tsp_status tsp_env_legal_action_mask(const tsp_env *env, uint8_t *mask);
+
+/**
+ * Reset a batch of environments to the next level in their sequence.
+ * The first reset of an environment keeps it on the level it was created on, so a new batch starts with a reset.
+ * Every output buffer is indexed by position in envs, and may be NULL to skip that output.
+ * @param pool The pool to run on, or NULL to run on the calling thread
+ * @param envs Array of num_envs distinct environments, which must all have the same board size if observations is set
+ * @param num_envs Number of environments
+ * @param observations Buffer of num_envs observations laid out as tsp_env_observation_shape(), stacked as NCHW
+ * @param hashes Buffer of num_envs state hashes
+ * @return TSP_OK on success
+ */
+TSP_C_API tsp_status tsp_reset(tsp_pool *pool, tsp_env *const *envs, int num_envs, float *observations,
+                               uint64_t *hashes);
+
+/**
+ * Apply one action to each environment of a batch.
+ * Every output buffer is indexed by position in envs, and may be NULL to skip that output.
+ * @param pool The pool to run on, or NULL to run on the calling thread
+ * @param envs Array of num_envs distinct environments, which must all have the same board size if observations is set
+ * @param num_envs Number of environments
+ * @param actions Array of num_envs actions in [0, TSP_NUM_ACTIONS)
+ * @param flags Bitwise or of tsp_step_flags
+ * @param observations Buffer of num_envs observations laid out as tsp_env_observation_shape(), stacked as NCHW
+ * @param rewards Buffer of num_envs reward signals of the step
+ * @param dones Buffer of num_envs flags, set to 1 if the step reached the solution and 0 otherwise
+ * @param hashes Buffer of num_envs state hashes after the step (before any auto reset)
+ * @return TSP_OK on success
+ */
+TSP_C_API tsp_status tsp_step(tsp_pool *pool, tsp_env *const *envs, int num_envs, const int32_t *actions,
+                              uint32_t flags, float *observations, float *rewards, uint8_t *dones, uint64_t *hashes);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif    // TSP_C_H_
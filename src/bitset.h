@@ -0,0 +1,195 @@
+#ifndef TSP_BITSET_H_
+#define TSP_BITSET_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Number of board cells which are stored inline (without heap allocation) by the board bitsets.
+// Boards larger than this fall back to heap storage.
+#ifndef TSP_INLINE_BOARD_CELLS
+#define TSP_INLINE_BOARD_CELLS 256
+#endif
+
+// Number of cities whose visited flags are stored inline by each state.
+// Levels with more cities fall back to heap storage.
+#ifndef TSP_INLINE_CITIES
+#define TSP_INLINE_CITIES 128
+#endif
+
+namespace tsp {
+
+constexpr std::size_t kBitsPerWord = 64;
+
+/**
+ * Dynamically sized bitset backed by uint64_t words, which keeps up to InlineWords words inline.
+ * Copies of bitsets which fit in the inline buffer never touch the heap.
+ * Bits past size() are always kept zero so that comparisons can be done word by word.
+ */
+template <std::size_t InlineWords>
+class SmallBitset {
+public:
+    SmallBitset() = default;
+    SmallBitset(std::size_t bits, bool value = false) : num_bits(bits) {
+        if (num_words() > InlineWords) {
+            heap_words.resize(num_words(), 0);
+        }
+        if (value) {
+            set_all();
+        }
+    }
+
+    bool operator==(const SmallBitset &other) const noexcept {
+        if (num_bits != other.num_bits) {
+            return false;
+        }
+        const uint64_t *lhs = data();
+        const uint64_t *rhs = other.data();
+        for (std::size_t i = 0; i < num_words(); ++i) {
+            if (lhs[i] != rhs[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+    bool operator!=(const SmallBitset &other) const noexcept {
+        return !(*this == other);
+    }
+
+    /**
+     * Get the number of bits in the bitset
+     * @return Number of bits
+     */
+    [[nodiscard]] auto size() const noexcept -> std::size_t {
+        return num_bits;
+    }
+
+    /**
+     * Get the number of words used to store the bits
+     * @return Number of words
+     */
+    [[nodiscard]] auto num_words() const noexcept -> std::size_t {
+        return (num_bits + kBitsPerWord - 1) / kBitsPerWord;
+    }
+
+    /**
+     * Get the underlying words, with bit i stored at bit (i % 64) of word (i / 64)
+     * @return Pointer to the first word
+     */
+    [[nodiscard]] auto data() const noexcept -> const uint64_t * {
+        return is_inline() ? inline_words.data() : heap_words.data();
+    }
+    [[nodiscard]] auto data() noexcept -> uint64_t * {
+        return is_inline() ? inline_words.data() : heap_words.data();
+    }
+
+    /**
+     * Check if the bit at the given position is set
+     * @param pos The bit position
+     * @return True if set
+     */
+    [[nodiscard]] auto test(std::size_t pos) const noexcept -> bool {
+        return (data()[pos / kBitsPerWord] >> (pos % kBitsPerWord)) & 1;
+    }
+
+    void set(std::size_t pos) noexcept {
+        data()[pos / kBitsPerWord] |= (uint64_t{1} << (pos % kBitsPerWord));
+    }
+
+    void reset(std::size_t pos) noexcept {
+        data()[pos / kBitsPerWord] &= ~(uint64_t{1} << (pos % kBitsPerWord));
+    }
+
+    void assign(std::size_t pos, bool value) noexcept {
+        value ? set(pos) : reset(pos);
+    }
+
+    /**
+     * Set all bits in the bitset
+     */
+    void set_all() noexcept {
+        uint64_t *words = data();
+        for (std::size_t i = 0; i < num_words(); ++i) {
+            words[i] = ~uint64_t{0};
+        }
+        // Keep bits past the end cleared
+        if (num_bits % kBitsPerWord != 0) {
+            words[num_words() - 1] &= (uint64_t{1} << (num_bits % kBitsPerWord)) - 1;
+        }
+    }
+
+    /**
+     * Count the number of set bits
+     * @return Number of set bits
+     */
+    [[nodiscard]] auto count() const noexcept -> std::size_t {
+        std::size_t result = 0;
+        const uint64_t *words = data();
+        for (std::size_t i = 0; i < num_words(); ++i) {
+            result += static_cast<std::size_t>(__builtin_popcountll(words[i]));
+        }
+        return result;
+    }
+
+    /**
+     * Check if the bitset is stored without a heap allocation
+     * @return True if stored inline
+     */
+    [[nodiscard]] auto is_inline() const noexcept -> bool {
+        return num_words() <= InlineWords;
+    }
+
+private:
+    std::size_t num_bits = 0;
+    std::array<uint64_t, InlineWords> inline_words{};
+    std::vector<uint64_t> heap_words;
+};
+
+/**
+ * Call func(pos) for each bit position where (lhs_word ^ lhs_flip) & (rhs_word ^ rhs_flip) is set, in increasing order.
+ * Flips should be 0 or ~0 to select a layer or its complement, and at least one flip should be 0 so that bits past
+ * the end stay cleared.
+ */
+template <typename BitsetT, typename Func>
+void for_each_set_bit(const BitsetT &lhs, uint64_t lhs_flip, const BitsetT &rhs, uint64_t rhs_flip, Func &&func) {
+    const uint64_t *lhs_words = lhs.data();
+    const uint64_t *rhs_words = rhs.data();
+    for (std::size_t i = 0; i < lhs.num_words(); ++i) {
+        uint64_t word = (lhs_words[i] ^ lhs_flip) & (rhs_words[i] ^ rhs_flip);
+        while (word != 0) {
+            const auto bit = static_cast<std::size_t>(__builtin_ctzll(word));
+            func(static_cast<int>(i * kBitsPerWord + bit));
+            word &= word - 1;
+        }
+    }
+}
+
+/**
+ * Call func(pos) for each bit position below size() which is not set, in increasing order.
+ */
+template <typename BitsetT, typename Func>
+void for_each_clear_bit(const BitsetT &bits, Func &&func) {
+    const uint64_t *words = bits.data();
+    for (std::size_t i = 0; i < bits.num_words(); ++i) {
+        uint64_t word = ~words[i];
+        if (i + 1 == bits.num_words() && bits.size() % kBitsPerWord != 0) {
+            word &= (uint64_t{1} << (bits.size() % kBitsPerWord)) - 1;
+        }
+        while (word != 0) {
+            const auto bit = static_cast<std::size_t>(__builtin_ctzll(word));
+            func(static_cast<int>(i * kBitsPerWord + bit));
+            word &= word - 1;
+        }
+    }
+}
+
+constexpr std::size_t kInlineBoardWords = (TSP_INLINE_BOARD_CELLS + kBitsPerWord - 1) / kBitsPerWord;
+using BoardBitset = SmallBitset<kInlineBoardWords>;
+
+constexpr std::size_t kInlineCityWords = (TSP_INLINE_CITIES + kBitsPerWord - 1) / kBitsPerWord;
+using CityBitset = SmallBitset<kInlineCityWords>;
+
+}    // namespace tsp
+
+#endif    // TSP_BITSET_H_
@@ -0,0 +1,109 @@
+#include "distance_cache.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include "thread_pool.h"
+#include "tsp_level.h"
+
+namespace tsp {
+
+void compute_distances(const TSPLevel& level, int source, uint16_t* distances) {
+    const auto num_cells = static_cast<std::size_t>(level.get_num_cells());
+    std::fill_n(distances, num_cells, static_cast<uint16_t>(kUnreachable));
+    if (level.is_wall(source)) {
+        return;
+    }
+    std::vector<int> queue;
+    queue.reserve(num_cells);
+    queue.push_back(source);
+    distances[source] = 0;
+    for (std::size_t head = 0; head < queue.size(); ++head) {
+        const int idx = queue[head];
+        const int next_distance = distances[idx] + 1;
+        for (int a = 0; a < kNumActions; ++a) {
+            const int neighbor = level.get_neighbor(idx, static_cast<Action>(a));
+            if (neighbor != kNoNeighbor && distances[neighbor] == kUnreachable) {
+                if (next_distance >= kUnreachable) {
+                    throw std::invalid_argument("Board has shortest paths too long to store as 16 bit distances.");
+                }
+                distances[neighbor] = static_cast<uint16_t>(next_distance);
+                queue.push_back(neighbor);
+            }
+        }
+    }
+}
+
+DistanceCache::DistanceCache(const TSPLevel& level, const DistanceCacheOptions& options)
+    : level(&level), num_cells(level.get_num_cells()) {
+    const auto row_bytes = static_cast<std::size_t>(num_cells) * sizeof(uint16_t);
+    int num_free_cells = 0;
+    for (int i = 0; i < num_cells; ++i) {
+        num_free_cells += !level.is_wall(i);
+    }
+    all_pairs = static_cast<std::size_t>(num_free_cells) * row_bytes <= options.max_bytes;
+
+    // Assign a row to each source, cities always get one
+    std::vector<int> sources;
+    source_rows.resize(static_cast<std::size_t>(num_cells), -1);
+    for (int i = 0; i < num_cells; ++i) {
+        if (level.is_city(i) || (all_pairs && !level.is_wall(i))) {
+            source_rows[static_cast<std::size_t>(i)] = static_cast<int>(sources.size());
+            sources.push_back(i);
+        }
+    }
+    table.resize(sources.size() * static_cast<std::size_t>(num_cells));
+
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    ThreadPool pool(options.num_threads);
+    pool.parallel_for(static_cast<int>(sources.size()), [&](int begin, int end) {
+        try {
+            for (int row = begin; row < end; ++row) {
+                const auto offset = static_cast<std::size_t>(row) * static_cast<std::size_t>(num_cells);
+                compute_distances(level, sources[static_cast<std::size_t>(row)], &table[offset]);
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            error = std::current_exception();
+        }
+    });
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+auto DistanceCache::distance(int from_idx, int to_idx) const -> int {
+    // Moves are reversible, so the table is symmetric and either endpoint's row can be used
+    if (const auto* row = get_row(from_idx); row != nullptr) {
+        return row[to_idx];
+    }
+    if (const auto* row = get_row(to_idx); row != nullptr) {
+        return row[from_idx];
+    }
+    if (level->is_wall(from_idx) || level->is_wall(to_idx)) {
+        return kUnreachable;
+    }
+    std::vector<uint16_t> distances(static_cast<std::size_t>(num_cells));
+    compute_distances(*level, from_idx, distances.data());
+    return distances[static_cast<std::size_t>(to_idx)];
+}
+
+auto DistanceCache::get_row(int source) const noexcept -> const uint16_t* {
+    const int row = source_rows[static_cast<std::size_t>(source)];
+    return row < 0 ? nullptr : &table[static_cast<std::size_t>(row) * static_cast<std::size_t>(num_cells)];
+}
+
+auto DistanceCache::has_all_pairs() const noexcept -> bool {
+    return all_pairs;
+}
+
+auto DistanceCache::memory_bytes() const noexcept -> std::size_t {
+    return (table.size() * sizeof(uint16_t)) + (source_rows.size() * sizeof(int));
+}
+
+}    // namespace tsp
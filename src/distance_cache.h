@@ -0,0 +1,89 @@
+#ifndef TSP_DISTANCE_CACHE_H_
+#define TSP_DISTANCE_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace tsp {
+
+class TSPLevel;
+
+// Distance reported between cells which cannot reach each other (or when either cell is a wall)
+constexpr int kUnreachable = std::numeric_limits<uint16_t>::max();
+
+struct DistanceCacheOptions {
+    // Memory budget for the all-pairs table. Rows for city sources are always stored, and rows for the remaining free
+    // cells are only stored if the full table fits in the budget.
+    std::size_t max_bytes = std::size_t{64} << 20;
+    // Number of threads to build with, or <= 0 to use the hardware concurrency. Defaults to the calling thread, since
+    // TSPLevel::get_distances() builds its cache lazily, often from a thread of another pool.
+    int num_threads = 1;
+};
+
+/**
+ * Write the wall-aware shortest path distance from the source cell to every cell of the level.
+ * @param level The level to search over
+ * @param source The source cell index
+ * @param distances Output array of level.get_num_cells() entries, set to kUnreachable for cells which can't be reached
+ * @throws std::invalid_argument if a reachable cell is kUnreachable or more moves away, which needs more than 65535
+ * free cells
+ */
+void compute_distances(const TSPLevel &level, int source, uint16_t *distances);
+
+/**
+ * Table of shortest path distances between cells of a level, built with one BFS per source cell.
+ * The table holds a pointer to the level, so it must not outlive it.
+ */
+class DistanceCache {
+public:
+    DistanceCache() = delete;
+
+    /**
+     * @param level The level to build the table for
+     * @param options The build options
+     * @throws std::invalid_argument if a stored row has a distance which doesn't fit below kUnreachable
+     */
+    DistanceCache(const TSPLevel &level, const DistanceCacheOptions &options = DistanceCacheOptions());
+
+    /**
+     * Get the shortest path distance between two cells.
+     * This is a table lookup when either cell is a city or the full table fits in the memory budget, otherwise a BFS
+     * is run from the source cell.
+     * @param from_idx The source cell index
+     * @param to_idx The target cell index
+     * @return Number of moves, or kUnreachable if there is no path
+     */
+    [[nodiscard]] auto distance(int from_idx, int to_idx) const -> int;
+
+    /**
+     * Get the stored distances from a source cell to every cell
+     * @param source The source cell index
+     * @return Pointer to get_num_cells() distances, or nullptr if the row for this source is not stored
+     */
+    [[nodiscard]] auto get_row(int source) const noexcept -> const uint16_t *;
+
+    /**
+     * Check if rows for every free cell are stored, so that all queries are table lookups
+     * @return True if the full table is stored
+     */
+    [[nodiscard]] auto has_all_pairs() const noexcept -> bool;
+
+    /**
+     * Get the memory used by the stored rows
+     * @return Number of bytes
+     */
+    [[nodiscard]] auto memory_bytes() const noexcept -> std::size_t;
+
+private:
+    const TSPLevel *level;
+    int num_cells;
+    bool all_pairs = false;
+    std::vector<int> source_rows;
+    std::vector<uint16_t> table;
+};
+
+}    // namespace tsp
+
+#endif    // TSP_DISTANCE_CACHE_H_
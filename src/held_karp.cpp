@@ -0,0 +1,272 @@
+#include "held_karp.h"
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <optional>
+
+#include "thread_pool.h"
+
+namespace tsp {
+
+namespace {
+constexpr uint32_t kInfCost = std::numeric_limits<uint32_t>::max();
+// Subsets are stored as 32 bit masks
+constexpr int kMaxNodes = 31;
+// Layers with fewer subsets than this are run on the calling thread, as splitting them costs more than it saves
+constexpr std::size_t kMinParallelLayer = 4096;
+
+// Shortest path from a source through every node to a sink, where all distances are finite
+struct PathProblem {
+    int num_nodes = 0;
+    uint32_t source_to_sink = 0;
+    std::vector<uint32_t> from_source;
+    std::vector<uint32_t> to_sink;
+    std::vector<uint32_t> between;
+};
+
+struct PathSolution {
+    bool solved = false;
+    uint32_t cost = 0;
+    // Node visit order
+    std::vector<int> order;
+    std::size_t memory_bytes = 0;
+};
+
+auto SolvePath(const PathProblem& problem, const TourSolverOptions& options) -> PathSolution {
+    const int m = problem.num_nodes;
+    if (m == 0) {
+        return {true, problem.source_to_sink, {}, 0};
+    }
+    const auto num_nodes = static_cast<std::size_t>(m);
+    const std::size_t num_subsets = std::size_t{1} << std::min(m, kMaxNodes);
+    const std::size_t memory_bytes = (num_subsets * num_nodes * sizeof(uint32_t)) + (num_subsets * sizeof(uint32_t));
+    if (m > kMaxNodes || memory_bytes > options.max_bytes) {
+        return {false, 0, {}, 0};
+    }
+
+    // Order the subsets by size, so that each layer only depends on the one before it
+    std::vector<std::size_t> layer_begin(num_nodes + 2, 0);
+    for (std::size_t subset = 0; subset < num_subsets; ++subset) {
+        ++layer_begin[static_cast<std::size_t>(__builtin_popcountll(subset)) + 1];
+    }
+    for (std::size_t k = 1; k < layer_begin.size(); ++k) {
+        layer_begin[k] += layer_begin[k - 1];
+    }
+    std::vector<uint32_t> subsets(num_subsets);
+    {
+        std::vector<std::size_t> next = layer_begin;
+        for (std::size_t subset = 0; subset < num_subsets; ++subset) {
+            subsets[next[static_cast<std::size_t>(__builtin_popcountll(subset))]++] = static_cast<uint32_t>(subset);
+        }
+    }
+
+    // dp[subset * m + j] is the shortest path from the source through the subset, ending at node j of the subset
+    std::vector<uint32_t> dp(num_subsets * num_nodes, kInfCost);
+    for (std::size_t j = 0; j < num_nodes; ++j) {
+        dp[((std::size_t{1} << j) * num_nodes) + j] = problem.from_source[j];
+    }
+    const auto solve_subsets = [&](const uint32_t* layer, std::size_t count) {
+        for (std::size_t idx = 0; idx < count; ++idx) {
+            const uint32_t subset = layer[idx];
+            for (uint32_t ends = subset; ends != 0; ends &= ends - 1) {
+                const auto j = static_cast<std::size_t>(__builtin_ctz(ends));
+                const uint32_t prev = subset ^ (uint32_t{1} << j);
+                const uint32_t* prev_costs = &dp[prev * num_nodes];
+                uint32_t best = kInfCost;
+                for (uint32_t mids = prev; mids != 0; mids &= mids - 1) {
+                    const auto i = static_cast<std::size_t>(__builtin_ctz(mids));
+                    best = std::min(best, prev_costs[i] + problem.between[(i * num_nodes) + j]);
+                }
+                dp[(subset * num_nodes) + j] = best;
+            }
+        }
+    };
+    std::optional<ThreadPool> pool;
+    for (std::size_t k = 2; k <= num_nodes; ++k) {
+        const uint32_t* layer = &subsets[layer_begin[k]];
+        const std::size_t layer_size = layer_begin[k + 1] - layer_begin[k];
+        if (layer_size < kMinParallelLayer || options.num_threads == 1) {
+            solve_subsets(layer, layer_size);
+            continue;
+        }
+        if (!pool) {
+            pool.emplace(options.num_threads);
+        }
+        pool->parallel_for(static_cast<int>(layer_size), [&](int begin, int end) {
+            solve_subsets(layer + begin, static_cast<std::size_t>(end - begin));
+        });
+    }
+
+    // Close the path at the sink, then walk back through the table to recover the order
+    PathSolution solution{true, kInfCost, std::vector<int>(num_nodes), memory_bytes};
+    const uint32_t full = static_cast<uint32_t>(num_subsets - 1);
+    std::size_t last = 0;
+    for (std::size_t j = 0; j < num_nodes; ++j) {
+        const uint32_t cost = dp[(full * num_nodes) + j] + problem.to_sink[j];
+        if (cost < solution.cost) {
+            solution.cost = cost;
+            last = j;
+        }
+    }
+    uint32_t subset = full;
+    for (std::size_t pos = num_nodes; pos-- > 0;) {
+        solution.order[pos] = static_cast<int>(last);
+        const uint32_t cost = dp[(subset * num_nodes) + last];
+        subset ^= uint32_t{1} << last;
+        for (uint32_t mids = subset; mids != 0; mids &= mids - 1) {
+            const auto i = static_cast<std::size_t>(__builtin_ctz(mids));
+            if (dp[(subset * num_nodes) + i] + problem.between[(i * num_nodes) + last] == cost) {
+                last = i;
+                break;
+            }
+        }
+    }
+    return solution;
+}
+
+// Build the path problem between entries of a distance matrix over num_cells cells
+auto MakePathProblem(const std::vector<uint16_t>& distances, std::size_t num_cells, std::size_t source,
+                     std::size_t sink, const std::vector<std::size_t>& nodes) -> PathProblem {
+    PathProblem problem;
+    const std::size_t m = nodes.size();
+    problem.num_nodes = static_cast<int>(m);
+    problem.source_to_sink = distances[(source * num_cells) + sink];
+    problem.from_source.resize(m);
+    problem.to_sink.resize(m);
+    problem.between.resize(m * m);
+    for (std::size_t i = 0; i < m; ++i) {
+        problem.from_source[i] = distances[(source * num_cells) + nodes[i]];
+        problem.to_sink[i] = distances[(nodes[i] * num_cells) + sink];
+        for (std::size_t j = 0; j < m; ++j) {
+            problem.between[(i * m) + j] = distances[(nodes[i] * num_cells) + nodes[j]];
+        }
+    }
+    return problem;
+}
+
+auto SolveTour(const TSPGameState& state, const TourSolverOptions& options) -> TourResult {
+    const auto& level = *state.get_level();
+    const int agent_idx = state.get_agent_index();
+    const int start_city_idx = state.get_start_city_index();
+    TourResult result;
+
+    if (start_city_idx != -1) {
+        // Path from the agent through the unvisited cities, back to the start city
+        std::vector<int> cells{agent_idx, start_city_idx};
+        state.for_each_unvisited_city([&](int city) { cells.push_back(city); });
+        const auto distances = get_distance_matrix(level, cells);
+        result.memory_bytes = distances.size() * sizeof(uint16_t);
+        if (std::any_of(distances.begin(), distances.begin() + static_cast<std::ptrdiff_t>(cells.size()),
+                        [](uint16_t d) { return d == kUnreachable; })) {
+            return result;
+        }
+        std::vector<std::size_t> nodes(cells.size() - 2);
+        std::iota(nodes.begin(), nodes.end(), 2);
+        const auto solution = SolvePath(MakePathProblem(distances, cells.size(), 0, 1, nodes), options);
+        result.memory_bytes += solution.memory_bytes;
+        if (!solution.solved) {
+            return result;
+        }
+        for (const int node : solution.order) {
+            result.tour.push_back(cells[nodes[static_cast<std::size_t>(node)]]);
+        }
+        result.tour.push_back(start_city_idx);
+        result.cost = static_cast<int>(solution.cost);
+        result.solved = true;
+        return result;
+    }
+
+    // No city has been visited yet. The first city reached is the nearest one, as any city along the way would be
+    // nearer, and the rest of the solution is a closed tour over all cities which can be rotated to start anywhere.
+    const auto& cities = level.get_city_indices();
+    if (cities.empty()) {
+        return result;
+    }
+    std::vector<int> cells = cities;
+    cells.push_back(agent_idx);
+    const auto distances = get_distance_matrix(level, cells);
+    result.memory_bytes = distances.size() * sizeof(uint16_t);
+    const uint16_t* agent_row = &distances[cities.size() * cells.size()];
+    if (std::any_of(agent_row, agent_row + cells.size(), [](uint16_t d) { return d == kUnreachable; })) {
+        return result;
+    }
+    std::size_t nearest = 0;
+    for (std::size_t i = 0; i < cities.size(); ++i) {
+        nearest = agent_row[i] < agent_row[nearest] ? i : nearest;
+    }
+
+    // Cycle from the first city through the others and back, so the first city is both the source and the sink
+    std::vector<std::size_t> nodes(cities.size() - 1);
+    std::iota(nodes.begin(), nodes.end(), 1);
+    const auto solution = SolvePath(MakePathProblem(distances, cells.size(), 0, 0, nodes), options);
+    result.memory_bytes += solution.memory_bytes;
+    if (!solution.solved) {
+        return result;
+    }
+    std::vector<int> cycle{cities[0]};
+    for (const int node : solution.order) {
+        cycle.push_back(cities[nodes[static_cast<std::size_t>(node)]]);
+    }
+    std::rotate(cycle.begin(), std::find(cycle.begin(), cycle.end(), cities[nearest]), cycle.end());
+    cycle.push_back(cycle.front());
+    result.tour = std::move(cycle);
+    result.cost = static_cast<int>(agent_row[nearest] + solution.cost);
+    result.solved = true;
+    return result;
+}
+}    // namespace
+
+auto get_distance_matrix(const TSPLevel& level, const std::vector<int>& cells) -> std::vector<uint16_t> {
+    const std::size_t n = cells.size();
+    std::vector<uint16_t> matrix(n * n);
+    std::vector<uint16_t> distances(static_cast<std::size_t>(level.get_num_cells()));
+    for (std::size_t i = 0; i < n; ++i) {
+        compute_distances(level, cells[i], distances.data());
+        for (std::size_t j = 0; j < n; ++j) {
+            matrix[(i * n) + j] = distances[static_cast<std::size_t>(cells[j])];
+        }
+    }
+    return matrix;
+}
+
+auto solve_tour(const TSPGameState& state, const TourSolverOptions& options) -> TourResult {
+    const auto start_time = std::chrono::steady_clock::now();
+    auto result = SolveTour(state, options);
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time;
+    result.seconds = elapsed.count();
+    return result;
+}
+
+auto solve_tour(const std::string& board_str, const TourSolverOptions& options) -> TourResult {
+    return solve_tour(TSPGameState(board_str), options);
+}
+
+auto solve_tour_levels(const std::vector<std::string>& board_strs, const TourSolverOptions& options)
+    -> std::vector<TourResult> {
+    std::vector<TourResult> results(board_strs.size());
+    auto single_options = options;
+    single_options.num_threads = 1;
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    ThreadPool pool(options.num_threads);
+    pool.parallel_for(static_cast<int>(board_strs.size()), [&](int begin, int end) {
+        try {
+            for (auto i = static_cast<std::size_t>(begin); i < static_cast<std::size_t>(end); ++i) {
+                results[i] = solve_tour(board_strs[i], single_options);
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            error = std::current_exception();
+        }
+    });
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    return results;
+}
+
+}    // namespace tsp
@@ -0,0 +1,72 @@
+#ifndef TSP_HELD_KARP_H_
+#define TSP_HELD_KARP_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "tsp_base.h"
+
+namespace tsp {
+
+struct TourSolverOptions {
+    // Memory budget for the DP table, the solve fails once more would be needed (about 2^n * n * 4 bytes for n cities)
+    std::size_t max_bytes = std::size_t{1} << 30;
+    // Number of threads each DP layer is split across, or <= 0 to use the hardware concurrency
+    int num_threads = 1;
+};
+
+struct TourResult {
+    bool solved = false;
+    // Number of moves in the optimal solution, or -1 if not solved
+    int cost = -1;
+    // Cell indices of the cities to move to in order (e.g. with TSPGameState::apply_path), ending at the start city
+    std::vector<int> tour;
+    double seconds = 0;
+    std::size_t memory_bytes = 0;
+};
+
+/**
+ * Get the wall-aware shortest path distances between cells, with one BFS per cell.
+ * @param level The level to search over
+ * @param cells The cell indices
+ * @return Row major matrix of cells.size() * cells.size() distances, kUnreachable if there is no path
+ */
+[[nodiscard]] auto get_distance_matrix(const TSPLevel &level, const std::vector<int> &cells) -> std::vector<uint16_t>;
+
+/**
+ * Find the optimal solution cost of a state with a bitmask Held-Karp DP over the city distance matrix.
+ * If the start city is set, the DP finds the shortest path from the agent through every unvisited city to the start
+ * city. Otherwise the first city reached is always the nearest one, so the cost is the distance to the nearest city
+ * plus the optimal tour over all cities.
+ * Each DP layer (subsets of the same size) is split across threads.
+ * @param state The state to solve from
+ * @param options The solver options
+ * @return The optimal cost and tour, which is not solved if a city can't be reached or the table exceeds the budget
+ */
+[[nodiscard]] auto solve_tour(const TSPGameState &state, const TourSolverOptions &options = TourSolverOptions())
+    -> TourResult;
+
+/**
+ * Find the optimal solution cost of the initial state of a board string.
+ * @param board_str The board string
+ * @param options The solver options
+ * @return The optimal cost and tour
+ */
+[[nodiscard]] auto solve_tour(const std::string &board_str, const TourSolverOptions &options = TourSolverOptions())
+    -> TourResult;
+
+/**
+ * Find the optimal solution cost of a set of boards, distributing whole boards across threads with each board solved
+ * on a single thread.
+ * @param board_strs The board strings
+ * @param options The solver options, where num_threads is the number of boards solved at once
+ * @return The result for each board, in input order
+ */
+[[nodiscard]] auto solve_tour_levels(const std::vector<std::string> &board_strs,
+                                     const TourSolverOptions &options = TourSolverOptions()) -> std::vector<TourResult>;
+
+}    // namespace tsp
+
+#endif    // TSP_HELD_KARP_H_
@@ -0,0 +1,126 @@
+#include "heuristic.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+
+#include "distance_cache.h"
+
+namespace tsp {
+
+TSPHeuristic::TSPHeuristic(HeuristicType type) : type(type) {}
+
+auto TSPHeuristic::compute(const TSPGameState& state) -> HeuristicInfo {
+    if (type == HeuristicType::kZero) {
+        return {};
+    }
+    return compute(state, state.get_level()->get_distances());
+}
+
+auto TSPHeuristic::compute(const TSPGameState& state, const DistanceCache& distances) -> HeuristicInfo {
+    if (type == HeuristicType::kZero) {
+        return {};
+    }
+    CollectCities(state);
+    const int city_mst = type == HeuristicType::kFarthestCity ? 0 : CityMST(distances);
+    return {Evaluate(state, distances, city_mst), city_mst};
+}
+
+auto TSPHeuristic::update(const HeuristicInfo& parent_info, const TSPGameState& child) -> HeuristicInfo {
+    if (type == HeuristicType::kZero) {
+        return {};
+    }
+    // The set of cities only changes if the move visited a new city
+    CollectCities(child);
+    const bool reuse_mst = child.get_reward_signal() == 0 || type == HeuristicType::kFarthestCity;
+    const auto& distances = child.get_level()->get_distances();
+    const int city_mst = reuse_mst ? parent_info.city_mst : CityMST(distances);
+    return {Evaluate(child, distances, city_mst), city_mst};
+}
+
+auto TSPHeuristic::get_type() const noexcept -> HeuristicType {
+    return type;
+}
+
+// ---------------------------------------------------------------------------
+
+void TSPHeuristic::CollectCities(const TSPGameState& state) {
+    cities.clear();
+    state.for_each_unvisited_city([&](int idx) { cities.push_back(idx); });
+    if (state.get_start_city_index() != -1) {
+        cities.push_back(state.get_start_city_index());
+    }
+}
+
+auto TSPHeuristic::CityMST(const DistanceCache& distances) -> int {
+    // Prim's algorithm over the complete graph of cities
+    const auto num_cities = cities.size();
+    if (num_cities <= 1) {
+        return 0;
+    }
+    min_edge.assign(num_cities, std::numeric_limits<int>::max());
+    in_tree.assign(num_cities, 0);
+    min_edge[0] = 0;
+    int weight = 0;
+    for (std::size_t iter = 0; iter < num_cities; ++iter) {
+        std::size_t next = num_cities;
+        for (std::size_t i = 0; i < num_cities; ++i) {
+            if (!in_tree[i] && (next == num_cities || min_edge[i] < min_edge[next])) {
+                next = i;
+            }
+        }
+        in_tree[next] = 1;
+        weight += min_edge[next];
+        const uint16_t* row = distances.get_row(cities[next]);
+        for (std::size_t i = 0; i < num_cities; ++i) {
+            if (!in_tree[i]) {
+                min_edge[i] = std::min(min_edge[i], static_cast<int>(row[cities[i]]));
+            }
+        }
+    }
+    return weight;
+}
+
+auto TSPHeuristic::Evaluate(const TSPGameState& state, const DistanceCache& distances, int city_mst) const -> int {
+    if (cities.empty()) {
+        // Only possible on levels without cities, which can never be solved
+        return kUnreachable;
+    }
+    const int agent_idx = state.get_agent_index();
+    const int start_idx = state.get_start_city_index();
+    const uint16_t* start_row = start_idx == -1 ? nullptr : distances.get_row(start_idx);
+
+    int nearest = std::numeric_limits<int>::max();
+    int farthest = 0;
+    for (const int city : cities) {
+        const uint16_t* row = distances.get_row(city);
+        const int to_city = row[agent_idx];
+        nearest = std::min(nearest, to_city);
+        if (type == HeuristicType::kMST) {
+            continue;
+        }
+        // Once visited the agent still needs to get back to the start city. If the start is unknown then the tour
+        // still has to travel between this city and another one
+        int back_to_start = 0;
+        if (start_row != nullptr) {
+            back_to_start = start_row[city];
+        } else if (cities.size() > 1) {
+            back_to_start = std::numeric_limits<int>::max();
+            for (const int other : cities) {
+                back_to_start = other == city ? back_to_start : std::min(back_to_start, static_cast<int>(row[other]));
+            }
+        }
+        farthest = std::max(farthest, to_city + back_to_start);
+    }
+
+    switch (type) {
+        case HeuristicType::kFarthestCity:
+            return farthest;
+        case HeuristicType::kMST:
+            return nearest + city_mst;
+        default:
+            return std::max(farthest, nearest + city_mst);
+    }
+}
+
+}    // namespace tsp
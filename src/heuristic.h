@@ -0,0 +1,80 @@
+#ifndef TSP_HEURISTIC_H_
+#define TSP_HEURISTIC_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "tsp_base.h"
+
+namespace tsp {
+
+// Admissible lower bounds on the number of moves needed to reach the solution
+enum class HeuristicType : int {
+    kZero = 0,             // Always 0
+    kFarthestCity = 1,     // Farthest unvisited city, plus the cheapest way back to the start from it
+    kMST = 2,              // Nearest city from the agent, plus the MST over the unvisited cities and the start city
+    kMax = 3,              // Maximum of kFarthestCity and kMST
+};
+
+/**
+ * Heuristic value of a state, along with the parts which can be reused by its children.
+ */
+struct HeuristicInfo {
+    int value = 0;
+    // MST weight over the unvisited cities and start city, which only changes when a new city is visited
+    int city_mst = 0;
+};
+
+/**
+ * Computes admissible heuristics using the distance cache of the state's level.
+ * Unsolvable states (a city can't be reached) get a value of at least kUnreachable.
+ * Holds scratch buffers, so each thread should use its own instance.
+ */
+class TSPHeuristic {
+public:
+    explicit TSPHeuristic(HeuristicType type = HeuristicType::kMax);
+
+    /**
+     * Compute the heuristic from scratch.
+     * @param state The state to evaluate
+     * @return The heuristic info
+     */
+    [[nodiscard]] auto compute(const TSPGameState &state) -> HeuristicInfo;
+
+    /**
+     * Compute the heuristic from scratch with a given distance table instead of the level's own.
+     * @param state The state to evaluate
+     * @param distances Distance table of the state's level, which must store the rows of every city
+     * @return The heuristic info
+     */
+    [[nodiscard]] auto compute(const TSPGameState &state, const DistanceCache &distances) -> HeuristicInfo;
+
+    /**
+     * Compute the heuristic of a child from its parent's info, where the child is the parent after one apply_action.
+     * The city MST is reused unless the move visited a new city.
+     * @param parent_info The info of the parent state
+     * @param child The child state
+     * @return The heuristic info of the child
+     */
+    [[nodiscard]] auto update(const HeuristicInfo &parent_info, const TSPGameState &child) -> HeuristicInfo;
+
+    /**
+     * Get the type of heuristic being computed
+     * @return The heuristic type
+     */
+    [[nodiscard]] auto get_type() const noexcept -> HeuristicType;
+
+private:
+    void CollectCities(const TSPGameState &state);
+    [[nodiscard]] auto CityMST(const DistanceCache &distances) -> int;
+    [[nodiscard]] auto Evaluate(const TSPGameState &state, const DistanceCache &distances, int city_mst) const -> int;
+
+    HeuristicType type;
+    std::vector<int> cities;
+    std::vector<int> min_edge;
+    std::vector<uint8_t> in_tree;
+};
+
+}    // namespace tsp
+
+#endif    // TSP_HEURISTIC_H_
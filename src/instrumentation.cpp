@@ -0,0 +1,105 @@
+#include "instrumentation.h"
+
+#include <algorithm>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+namespace tsp {
+
+namespace {
+const std::array<const char*, kNumInstrumentationCounters> kCounterNames{
+    "construct", "apply_action", "apply_action_noop", "hash_update", "hash_query", "observation", "image",
+};
+const std::array<const char*, kNumInstrumentationTimers> kTimerNames{
+    "construct", "apply_action", "hash_update", "observation", "image",
+};
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<ThreadInstrumentation*> live;
+    // Totals of threads which have exited
+    InstrumentationSnapshot retired;
+};
+
+// Never destroyed, so that threads exiting during static destruction can still retire their counts
+auto GetRegistry() -> Registry& {
+    static auto* registry = new Registry();    // NOLINT(*-owning-memory)
+    return *registry;
+}
+
+void AddTo(InstrumentationSnapshot& snapshot, const ThreadInstrumentation& storage) {
+    for (std::size_t i = 0; i < snapshot.counts.size(); ++i) {
+        snapshot.counts[i] += storage.counts[i].load(std::memory_order_relaxed);
+    }
+    for (std::size_t i = 0; i < snapshot.cycles.size(); ++i) {
+        snapshot.cycles[i] += storage.cycles[i].load(std::memory_order_relaxed);
+        snapshot.timed_calls[i] += storage.timed_calls[i].load(std::memory_order_relaxed);
+    }
+}
+
+// Registers the thread's storage for its lifetime
+class ThreadSlot {
+public:
+    ThreadSlot() {
+        auto& registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.live.push_back(&storage);
+    }
+    ~ThreadSlot() {
+        auto& registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        AddTo(registry.retired, storage);
+        registry.live.erase(std::find(registry.live.begin(), registry.live.end(), &storage));
+    }
+    ThreadSlot(const ThreadSlot&) = delete;
+    ThreadSlot(ThreadSlot&&) = delete;
+    auto operator=(const ThreadSlot&) -> ThreadSlot& = delete;
+    auto operator=(ThreadSlot&&) -> ThreadSlot& = delete;
+
+    ThreadInstrumentation storage;
+};
+}    // namespace
+
+auto InstrumentationSnapshot::to_string() const -> std::string {
+    std::ostringstream ss;
+    for (std::size_t i = 0; i < counts.size(); ++i) {
+        ss << kCounterNames[i] << " " << counts[i] << "\n";
+    }
+    for (std::size_t i = 0; i < cycles.size(); ++i) {
+        ss << kTimerNames[i] << "_cycles " << cycles[i] << " " << timed_calls[i] << "\n";
+    }
+    return ss.str();
+}
+
+auto get_thread_instrumentation() -> ThreadInstrumentation& {
+    thread_local ThreadSlot slot;
+    return slot.storage;
+}
+
+auto get_instrumentation_snapshot() -> InstrumentationSnapshot {
+    auto& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    InstrumentationSnapshot snapshot = registry.retired;
+    for (const auto* storage : registry.live) {
+        AddTo(snapshot, *storage);
+    }
+    return snapshot;
+}
+
+void reset_instrumentation() {
+    auto& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.retired = InstrumentationSnapshot();
+    for (auto* storage : registry.live) {
+        for (auto& count : storage->counts) {
+            count.store(0, std::memory_order_relaxed);
+        }
+        for (std::size_t i = 0; i < storage->cycles.size(); ++i) {
+            storage->cycles[i].store(0, std::memory_order_relaxed);
+            storage->timed_calls[i].store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+}    // namespace tsp
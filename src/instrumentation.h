@@ -0,0 +1,154 @@
+#ifndef TSP_INSTRUMENTATION_H_
+#define TSP_INSTRUMENTATION_H_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Set TSP_INSTRUMENTATION to 1 to count hot path calls, and TSP_INSTRUMENTATION_TIMERS to 1 to also time them.
+// When disabled the TSP_COUNT and TSP_TIME macros compile to nothing.
+#ifndef TSP_INSTRUMENTATION
+#define TSP_INSTRUMENTATION 0
+#endif
+#ifndef TSP_INSTRUMENTATION_TIMERS
+#define TSP_INSTRUMENTATION_TIMERS 0
+#endif
+
+#if TSP_INSTRUMENTATION_TIMERS
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+#endif
+
+namespace tsp {
+
+constexpr bool kInstrumentationEnabled = TSP_INSTRUMENTATION != 0;
+constexpr bool kInstrumentationTimersEnabled = kInstrumentationEnabled && TSP_INSTRUMENTATION_TIMERS != 0;
+
+enum class InstrumentationCounter : int {
+    kConstruct = 0,          // States constructed from a level
+    kApplyAction = 1,        // Calls to apply_action
+    kApplyActionNoop = 2,    // Calls to apply_action which walked into a wall or off the board
+    kHashUpdate = 3,         // Incremental hash updates from a move
+    kHashQuery = 4,          // Calls to get_hash
+    kObservation = 5,        // Full observations written, in any encoding
+    kImage = 6,              // Images rendered, including dirty renders
+};
+constexpr int kNumInstrumentationCounters = 7;
+
+enum class InstrumentationTimer : int {
+    kConstruct = 0,
+    kApplyAction = 1,
+    kHashUpdate = 2,
+    kObservation = 3,
+    kImage = 4,
+};
+constexpr int kNumInstrumentationTimers = 5;
+
+/**
+ * Counters and timers aggregated over every thread
+ */
+struct InstrumentationSnapshot {
+    std::array<uint64_t, kNumInstrumentationCounters> counts{};
+    // Total cycles (or nanoseconds where no cycle counter is available) and number of timed calls
+    std::array<uint64_t, kNumInstrumentationTimers> cycles{};
+    std::array<uint64_t, kNumInstrumentationTimers> timed_calls{};
+
+    [[nodiscard]] auto get_count(InstrumentationCounter counter) const noexcept -> uint64_t {
+        return counts[static_cast<std::size_t>(counter)];
+    }
+
+    [[nodiscard]] auto get_cycles(InstrumentationTimer timer) const noexcept -> uint64_t {
+        return cycles[static_cast<std::size_t>(timer)];
+    }
+
+    /**
+     * Export the snapshot as text, with one "name value" line per counter and one "name cycles calls" line per timer
+     * @return The text
+     */
+    [[nodiscard]] auto to_string() const -> std::string;
+};
+
+/**
+ * Aggregate the counters of all live threads and of threads which have exited.
+ * Counts from other threads which are still running may be slightly out of date.
+ * @return The snapshot, which is all zeros unless built with TSP_INSTRUMENTATION
+ */
+[[nodiscard]] auto get_instrumentation_snapshot() -> InstrumentationSnapshot;
+
+/**
+ * Reset all counters and timers to zero. Counts made concurrently on other threads may be lost.
+ */
+void reset_instrumentation();
+
+// Per thread storage, only written by its owning thread
+struct ThreadInstrumentation {
+    std::array<std::atomic<uint64_t>, kNumInstrumentationCounters> counts{};
+    std::array<std::atomic<uint64_t>, kNumInstrumentationTimers> cycles{};
+    std::array<std::atomic<uint64_t>, kNumInstrumentationTimers> timed_calls{};
+};
+
+/**
+ * Get the storage of the calling thread, registering it on first use
+ * @return The thread's counters
+ */
+[[nodiscard]] auto get_thread_instrumentation() -> ThreadInstrumentation &;
+
+// Only the owning thread writes, so a relaxed load and store avoids a locked read-modify-write
+inline void instrumentation_add(std::atomic<uint64_t> &slot, uint64_t value) noexcept {
+    slot.store(slot.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+inline void instrumentation_count(InstrumentationCounter counter) {
+    instrumentation_add(get_thread_instrumentation().counts[static_cast<std::size_t>(counter)], 1);
+}
+
+#if TSP_INSTRUMENTATION_TIMERS
+inline auto read_cycle_counter() noexcept -> uint64_t {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+/**
+ * Adds the cycles between construction and destruction to a timer
+ */
+class ScopedCycleTimer {
+public:
+    explicit ScopedCycleTimer(InstrumentationTimer timer_) : timer(timer_), start(read_cycle_counter()) {}
+    ~ScopedCycleTimer() {
+        auto &storage = get_thread_instrumentation();
+        instrumentation_add(storage.cycles[static_cast<std::size_t>(timer)], read_cycle_counter() - start);
+        instrumentation_add(storage.timed_calls[static_cast<std::size_t>(timer)], 1);
+    }
+    ScopedCycleTimer(const ScopedCycleTimer &) = delete;
+    ScopedCycleTimer(ScopedCycleTimer &&) = delete;
+    auto operator=(const ScopedCycleTimer &) -> ScopedCycleTimer & = delete;
+    auto operator=(ScopedCycleTimer &&) -> ScopedCycleTimer & = delete;
+
+private:
+    InstrumentationTimer timer;
+    uint64_t start;
+};
+#endif
+
+}    // namespace tsp
+
+#if TSP_INSTRUMENTATION
+#define TSP_COUNT(counter) ::tsp::instrumentation_count(::tsp::InstrumentationCounter::counter)
+#else
+#define TSP_COUNT(counter) ((void)0)
+#endif
+
+#if TSP_INSTRUMENTATION && TSP_INSTRUMENTATION_TIMERS
+#define TSP_TIME(timer) const ::tsp::ScopedCycleTimer tsp_scoped_timer_##timer(::tsp::InstrumentationTimer::timer)
+#else
+#define TSP_TIME(timer) ((void)0)
+#endif
+
+#endif    // TSP_INSTRUMENTATION_H_
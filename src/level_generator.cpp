@@ -0,0 +1,233 @@
+#include "level_generator.h"
+
+#include <algorithm>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include "distance_cache.h"
+#include "heuristic.h"
+#include "thread_pool.h"
+#include "tsp_base.h"
+#include "zobrist.h"
+
+namespace tsp {
+
+namespace {
+// Number of layouts sampled for a seed before giving up on finding one with every city reachable
+constexpr int kMaxReachableAttempts = 1000;
+
+// Counter based generator over splitmix64, so a seed gives the same level on every platform
+class LevelRng {
+public:
+    explicit LevelRng(uint64_t seed) : state(splitmix64(seed)) {}
+
+    auto next() noexcept -> uint64_t {
+        return splitmix64(state++);
+    }
+
+    // Uniform integer in [0, bound)
+    auto next_below(std::size_t bound) noexcept -> std::size_t {
+        return static_cast<std::size_t>((static_cast<unsigned __int128>(next()) * bound) >> 64);
+    }
+
+private:
+    uint64_t state;
+};
+
+struct Layout {
+    int agent_idx = -1;
+    BoardBitset wall_layer;
+    BoardBitset city_layer;
+};
+
+void CheckOptions(const GeneratorOptions& options) {
+    if (options.map_size < 1 || options.num_cities < 0 || options.num_random_walls < 0) {
+        throw std::invalid_argument("Invalid map size, number of cities, or number of random walls.");
+    }
+    const auto num_cells = static_cast<int64_t>(options.map_size) * static_cast<int64_t>(options.map_size);
+    const int64_t num_diagonal_walls = options.add_walls ? 4 * std::max(options.map_size / 2 - 1, 0) : 0;
+    if (num_cells > std::numeric_limits<int>::max() ||
+        num_diagonal_walls + options.num_random_walls + options.num_cities + 1 > num_cells) {
+        throw std::invalid_argument("The walls, cities, and agent don't fit on the board.");
+    }
+}
+
+// Sample cities, random walls, and the agent without replacement from the free cells
+void SampleLayout(const GeneratorOptions& options, LevelRng& rng, Layout& layout, std::vector<int>& free_cells) {
+    const int n = options.map_size;
+    const auto num_cells = static_cast<std::size_t>(n) * static_cast<std::size_t>(n);
+    layout.wall_layer = BoardBitset(num_cells);
+    layout.city_layer = BoardBitset(num_cells);
+    if (options.add_walls) {
+        for (int i = 0; i < n / 2 - 1; ++i) {
+            layout.wall_layer.set(static_cast<std::size_t>((i * n) + i));
+            layout.wall_layer.set(static_cast<std::size_t>(((i + 1) * n) - i - 1));
+            layout.wall_layer.set(static_cast<std::size_t>(((n - 1 - i) * n) + i));
+            layout.wall_layer.set(static_cast<std::size_t>(((n - i) * n) - i - 1));
+        }
+    }
+    free_cells.clear();
+    for (std::size_t i = 0; i < num_cells; ++i) {
+        if (!layout.wall_layer.test(i)) {
+            free_cells.push_back(static_cast<int>(i));
+        }
+    }
+
+    // Partial Fisher-Yates shuffle, where position k holds the k-th sampled cell
+    const auto num_samples = static_cast<std::size_t>(options.num_cities + options.num_random_walls + 1);
+    for (std::size_t k = 0; k < num_samples; ++k) {
+        std::swap(free_cells[k], free_cells[k + rng.next_below(free_cells.size() - k)]);
+    }
+    const auto num_cities = static_cast<std::size_t>(options.num_cities);
+    for (std::size_t k = 0; k < num_cities; ++k) {
+        layout.city_layer.set(static_cast<std::size_t>(free_cells[k]));
+    }
+    for (std::size_t k = num_cities; k < num_samples - 1; ++k) {
+        layout.wall_layer.set(static_cast<std::size_t>(free_cells[k]));
+    }
+    layout.agent_idx = free_cells[num_samples - 1];
+}
+
+auto ToBoardStr(int map_size, const Layout& layout) -> std::string {
+    const auto num_cells = static_cast<std::size_t>(map_size) * static_cast<std::size_t>(map_size);
+    std::string board_str = std::to_string(map_size) + "|" + std::to_string(map_size);
+    board_str.reserve(board_str.size() + (3 * num_cells));
+    for (std::size_t i = 0; i < num_cells; ++i) {
+        Element el = Element::kEmpty;
+        if (layout.wall_layer.test(i)) {
+            el = Element::kWall;
+        } else if (layout.city_layer.test(i)) {
+            el = Element::kCityUnvisited;
+        } else if (static_cast<int>(i) == layout.agent_idx) {
+            el = Element::kAgent;
+        }
+        board_str += "|0";
+        board_str += static_cast<char>('0' + static_cast<int>(el));
+    }
+    return board_str;
+}
+
+auto MakeLevel(int map_size, const Layout& layout) -> TSPLevelPtr {
+    return std::make_shared<const TSPLevel>(map_size, map_size, layout.agent_idx, layout.wall_layer,
+                                            layout.city_layer);
+}
+
+// Levels are only built when checking reachability, as plain generation just needs the board string
+void GenerateLayout(const GeneratorOptions& options, uint64_t seed, Layout& layout, std::vector<int>& free_cells) {
+    LevelRng rng(seed);
+    for (int attempt = 0; attempt < kMaxReachableAttempts; ++attempt) {
+        SampleLayout(options, rng, layout, free_cells);
+        if (!options.require_reachable || all_cities_reachable(*MakeLevel(options.map_size, layout))) {
+            return;
+        }
+    }
+    throw std::runtime_error("Could not generate a level with every city reachable.");
+}
+}    // namespace
+
+auto generate_board_str(const GeneratorOptions& options, uint64_t seed) -> std::string {
+    CheckOptions(options);
+    Layout layout;
+    std::vector<int> free_cells;
+    GenerateLayout(options, seed, layout, free_cells);
+    return ToBoardStr(options.map_size, layout);
+}
+
+auto generate_level(const GeneratorOptions& options, uint64_t seed) -> TSPLevelPtr {
+    CheckOptions(options);
+    Layout layout;
+    std::vector<int> free_cells;
+    GenerateLayout(options, seed, layout, free_cells);
+    return MakeLevel(options.map_size, layout);
+}
+
+auto all_cities_reachable(const TSPLevel& level) -> bool {
+    thread_local std::vector<uint16_t> distances;
+    distances.resize(static_cast<std::size_t>(level.get_num_cells()));
+    compute_distances(level, level.get_agent_index(), distances.data());
+    return std::all_of(level.get_city_indices().begin(), level.get_city_indices().end(),
+                       [&](int city) { return distances[static_cast<std::size_t>(city)] != kUnreachable; });
+}
+
+auto compute_difficulty(const TSPLevelPtr& level) -> LevelDifficulty {
+    if (!all_cities_reachable(*level)) {
+        return {kUnreachable, kUnreachable};
+    }
+    // Only the city rows are needed, so the level's all-pairs table (a BFS from every free cell) isn't built
+    const DistanceCache distances(*level, DistanceCacheOptions{.max_bytes = 0, .num_threads = 1});
+    LevelDifficulty difficulty;
+    TSPHeuristic heuristic(HeuristicType::kMax);
+    difficulty.lower_bound = heuristic.compute(TSPGameState(level), distances).value;
+
+    std::vector<int> remaining = level->get_city_indices();
+    if (remaining.empty()) {
+        return difficulty;
+    }
+
+    // Visit the nearest unvisited city until all are visited, then return to the first one
+    int current = level->get_agent_index();
+    int start_city = -1;
+    while (!remaining.empty()) {
+        auto nearest = remaining.begin();
+        for (auto it = remaining.begin(); it != remaining.end(); ++it) {
+            if (distances.get_row(*it)[current] < distances.get_row(*nearest)[current]) {
+                nearest = it;
+            }
+        }
+        difficulty.greedy_cost += distances.get_row(*nearest)[current];
+        current = *nearest;
+        start_city = start_city == -1 ? current : start_city;
+        remaining.erase(nearest);
+    }
+    difficulty.greedy_cost += distances.get_row(start_city)[current];
+    return difficulty;
+}
+
+void write_generated_levels(const GeneratorOptions& options, uint64_t first_seed, std::size_t count, std::ostream& out,
+                            std::ostream* difficulty_out) {
+    CheckOptions(options);
+    const auto batch_size = static_cast<std::size_t>(std::max(options.batch_size, 1));
+    std::vector<std::string> board_strs(std::min(batch_size, count));
+    std::vector<LevelDifficulty> difficulties(difficulty_out == nullptr ? 0 : board_strs.size());
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    ThreadPool pool(options.num_threads);
+    for (std::size_t batch_begin = 0; batch_begin < count; batch_begin += batch_size) {
+        const std::size_t batch_count = std::min(batch_size, count - batch_begin);
+        pool.parallel_for(static_cast<int>(batch_count), [&](int begin, int end) {
+            try {
+                Layout layout;
+                std::vector<int> free_cells;
+                for (auto i = static_cast<std::size_t>(begin); i < static_cast<std::size_t>(end); ++i) {
+                    GenerateLayout(options, first_seed + batch_begin + i, layout, free_cells);
+                    board_strs[i] = ToBoardStr(options.map_size, layout);
+                    if (difficulty_out != nullptr) {
+                        difficulties[i] = compute_difficulty(MakeLevel(options.map_size, layout));
+                    }
+                }
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                error = std::current_exception();
+            }
+        });
+        if (error) {
+            std::rethrow_exception(error);
+        }
+        for (std::size_t i = 0; i < batch_count; ++i) {
+            out << board_strs[i] << '\n';
+            if (difficulty_out != nullptr) {
+                *difficulty_out << difficulties[i].lower_bound << ' ' << difficulties[i].greedy_cost << '\n';
+            }
+        }
+    }
+    out.flush();
+    if (difficulty_out != nullptr) {
+        difficulty_out->flush();
+    }
+}
+
+}    // namespace tsp
@@ -0,0 +1,88 @@
+#ifndef TSP_LEVEL_GENERATOR_H_
+#define TSP_LEVEL_GENERATOR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+#include "tsp_level.h"
+
+namespace tsp {
+
+struct GeneratorOptions {
+    // Number of rows and columns of the square board
+    int map_size = 10;
+    int num_cities = 1;
+    // Add the diagonal wall pattern from each corner towards the center, as in scripts/generate_levelset.py
+    bool add_walls = false;
+    // Number of additional walls placed on random free cells
+    int num_random_walls = 0;
+    // Resample levels where a city can't be reached from the agent
+    bool require_reachable = false;
+    // Number of threads to generate with, or <= 0 to use the hardware concurrency
+    int num_threads = 1;
+    // Number of levels generated between writes when streaming
+    int batch_size = 1 << 14;
+};
+
+/**
+ * Difficulty estimate of a level, taken from the distances between the agent and cities.
+ * Both values are kUnreachable if a city can't be reached.
+ */
+struct LevelDifficulty {
+    // Admissible heuristic of the initial state, so a lower bound on the solution cost
+    int lower_bound = 0;
+    // Cost of the nearest neighbour tour, so an upper bound on the solution cost
+    int greedy_cost = 0;
+};
+
+/**
+ * Generate the board string of a level, which only depends on the options and the seed (not the platform or the
+ * number of threads).
+ * @param options The generator options
+ * @param seed The level seed
+ * @return The board string
+ * @throws std::invalid_argument if the cities, agent, and walls don't fit on the board
+ * @throws std::runtime_error if require_reachable is set and no reachable level is found after many attempts
+ */
+[[nodiscard]] auto generate_board_str(const GeneratorOptions &options, uint64_t seed) -> std::string;
+
+/**
+ * Generate a level, see generate_board_str().
+ * @param options The generator options
+ * @param seed The level seed
+ * @return The level
+ */
+[[nodiscard]] auto generate_level(const GeneratorOptions &options, uint64_t seed) -> TSPLevelPtr;
+
+/**
+ * Check if every city can be reached from the agent's starting cell.
+ * @param level The level to check
+ * @return True if all cities are reachable
+ */
+[[nodiscard]] auto all_cities_reachable(const TSPLevel &level) -> bool;
+
+/**
+ * Estimate the difficulty of a level from the distances between its agent and cities.
+ * Only the city rows of the distance table are built, on the calling thread, and the level's own cache is left alone.
+ * @param level The level to evaluate
+ * @return The difficulty bounds
+ */
+[[nodiscard]] auto compute_difficulty(const TSPLevelPtr &level) -> LevelDifficulty;
+
+/**
+ * Generate levels for seeds [first_seed, first_seed + count) across threads, streaming one board string per line in
+ * seed order. Only one batch of levels is held in memory at a time.
+ * @param options The generator options
+ * @param first_seed Seed of the first level
+ * @param count Number of levels
+ * @param out Stream to write the board strings to
+ * @param difficulty_out If not null, the difficulty of each level is also written as "lower_bound greedy_cost" lines
+ */
+void write_generated_levels(const GeneratorOptions &options, uint64_t first_seed, std::size_t count, std::ostream &out,
+                            std::ostream *difficulty_out = nullptr);
+
+}    // namespace tsp
+
+#endif    // TSP_LEVEL_GENERATOR_H_
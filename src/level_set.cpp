@@ -0,0 +1,60 @@
+#include "level_set.h"
+
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <mutex>
+
+#include "thread_pool.h"
+
+namespace tsp {
+
+LevelSet::LevelSet(const std::string& path) : file(path) {
+    // Index the lines, skipping empty ones and trailing carriage returns
+    const char* it = file.data();
+    const char* end = it + file.size();
+    while (it < end) {
+        const auto* newline = static_cast<const char*>(std::memchr(it, '\n', static_cast<std::size_t>(end - it)));
+        const char* line_end = newline == nullptr ? end : newline;
+        const char* trimmed_end = (line_end > it && *(line_end - 1) == '\r') ? line_end - 1 : line_end;
+        if (trimmed_end > it) {
+            lines.emplace_back(it, static_cast<std::size_t>(trimmed_end - it));
+        }
+        it = line_end + 1;
+    }
+}
+
+auto LevelSet::size() const noexcept -> std::size_t {
+    return lines.size();
+}
+
+auto LevelSet::get_board_str(std::size_t index) const noexcept -> std::string_view {
+    return lines[index];
+}
+
+auto LevelSet::get_level(std::size_t index) const -> TSPLevelPtr {
+    return std::make_shared<const TSPLevel>(lines[index]);
+}
+
+auto LevelSet::load_all(int num_threads) const -> std::vector<TSPLevelPtr> {
+    std::vector<TSPLevelPtr> levels(lines.size());
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    ThreadPool pool(num_threads);
+    pool.parallel_for(static_cast<int>(lines.size()), [&](int begin, int end) {
+        try {
+            for (int i = begin; i < end; ++i) {
+                levels[static_cast<std::size_t>(i)] = get_level(static_cast<std::size_t>(i));
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            error = std::current_exception();
+        }
+    });
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    return levels;
+}
+
+}    // namespace tsp
@@ -0,0 +1,68 @@
+#ifndef TSP_LEVEL_SET_H_
+#define TSP_LEVEL_SET_H_
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "mapped_file.h"
+#include "tsp_level.h"
+
+namespace tsp {
+
+/**
+ * Read-only view over a level set file, with one board string per line (e.g. scripts/train.txt).
+ * The file is memory mapped and only the line offsets are indexed on open, so levels are parsed on demand.
+ */
+class LevelSet {
+public:
+    LevelSet() = delete;
+
+    /**
+     * @param path Path to the level set file
+     * @throws std::runtime_error if the file can't be opened or mapped
+     */
+    explicit LevelSet(const std::string &path);
+    ~LevelSet() = default;
+
+    LevelSet(const LevelSet &) = delete;
+    LevelSet(LevelSet &&) = delete;
+    auto operator=(const LevelSet &) -> LevelSet & = delete;
+    auto operator=(LevelSet &&) -> LevelSet & = delete;
+
+    /**
+     * Get the number of levels (non-empty lines) in the file
+     * @return Number of levels
+     */
+    [[nodiscard]] auto size() const noexcept -> std::size_t;
+
+    /**
+     * Get the board string of a level, pointing into the mapped file
+     * @param index The level index
+     * @return View of the board string, valid for the lifetime of the level set
+     */
+    [[nodiscard]] auto get_board_str(std::size_t index) const noexcept -> std::string_view;
+
+    /**
+     * Parse a level.
+     * @param index The level index
+     * @return The parsed level
+     */
+    [[nodiscard]] auto get_level(std::size_t index) const -> TSPLevelPtr;
+
+    /**
+     * Parse every level, splitting the levels into chunks across threads.
+     * @param num_threads Number of threads to parse with, or <= 0 to use the hardware concurrency
+     * @return The parsed levels, in file order
+     */
+    [[nodiscard]] auto load_all(int num_threads = 1) const -> std::vector<TSPLevelPtr>;
+
+private:
+    MappedFile file;
+    std::vector<std::string_view> lines;
+};
+
+}    // namespace tsp
+
+#endif    // TSP_LEVEL_SET_H_
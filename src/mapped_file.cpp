@@ -0,0 +1,59 @@
+#include "mapped_file.h"
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define TSP_HAS_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace tsp {
+
+MappedFile::MappedFile(const std::string& path) {
+#ifdef TSP_HAS_MMAP
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Unable to open file: " + path);
+    }
+    struct stat file_stat {};
+    if (::fstat(fd, &file_stat) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Unable to stat file: " + path);
+    }
+    file_size = static_cast<std::size_t>(file_stat.st_size);
+    if (file_size > 0) {
+        void* mapped = ::mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("Unable to map file: " + path);
+        }
+        file_data = static_cast<const char*>(mapped);
+    }
+    ::close(fd);
+#else
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Unable to open file: " + path);
+    }
+    std::stringstream ss;
+    ss << file.rdbuf();
+    buffer = ss.str();
+    file_data = buffer.empty() ? nullptr : buffer.data();
+    file_size = buffer.size();
+#endif
+}
+
+MappedFile::~MappedFile() {
+#ifdef TSP_HAS_MMAP
+    if (file_data != nullptr) {
+        ::munmap(const_cast<char*>(file_data), file_size);    // NOLINT(*-const-cast)
+    }
+#endif
+}
+
+}    // namespace tsp
@@ -0,0 +1,54 @@
+#ifndef TSP_MAPPED_FILE_H_
+#define TSP_MAPPED_FILE_H_
+
+#include <cstddef>
+#include <string>
+
+namespace tsp {
+
+/**
+ * Read-only view of a whole file, memory mapped where supported and read into memory otherwise.
+ * The mapping is page aligned, so data() is suitably aligned for any fundamental type.
+ */
+class MappedFile {
+public:
+    MappedFile() = delete;
+
+    /**
+     * @param path Path to the file
+     * @throws std::runtime_error if the file can't be opened or mapped
+     */
+    explicit MappedFile(const std::string &path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile(MappedFile &&) = delete;
+    auto operator=(const MappedFile &) -> MappedFile & = delete;
+    auto operator=(MappedFile &&) -> MappedFile & = delete;
+
+    /**
+     * Get the file contents
+     * @return Pointer to the first byte, or nullptr if the file is empty
+     */
+    [[nodiscard]] auto data() const noexcept -> const char * {
+        return file_data;
+    }
+
+    /**
+     * Get the file size
+     * @return Number of bytes
+     */
+    [[nodiscard]] auto size() const noexcept -> std::size_t {
+        return file_size;
+    }
+
+private:
+    const char *file_data = nullptr;
+    std::size_t file_size = 0;
+    // Fallback storage when memory mapping isn't available
+    std::string buffer;
+};
+
+}    // namespace tsp
+
+#endif    // TSP_MAPPED_FILE_H_
@@ -0,0 +1,402 @@
+#include "mcts.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#include "thread_pool.h"
+#include "work_stealing.h"
+
+namespace tsp {
+
+namespace {
+enum NodeStatus : int {
+    kUnexpanded = 0,
+    kExpanding = 1,    // Claimed by a descent, waiting on the evaluator
+    kExpanded = 2,
+    kTerminal = 3,     // Solution state, which is never expanded
+};
+
+// Transposition map shards, picked by the top hash bits
+constexpr int kShardBits = 6;
+constexpr int kNumShards = 1 << kShardBits;
+
+void AtomicAdd(std::atomic<double>& target, double value) noexcept {
+    double current = target.load(std::memory_order_relaxed);
+    while (!target.compare_exchange_weak(current, current + value, std::memory_order_relaxed)) {
+    }
+}
+
+struct Node;
+
+// Statistics live on the edges, so that a node reached through several transpositions keeps separate action values
+struct Edge {
+    std::atomic<Node*> child{nullptr};
+    std::atomic<int> visits{0};
+    std::atomic<int> virtual_visits{0};
+    std::atomic<double> value_sum{0};
+    // Written before the node is published as expanded
+    float prior = 0;
+    bool legal = false;
+};
+
+struct Node {
+    std::atomic<int> status{kUnexpanded};
+    std::array<Edge, kNumActions> edges;
+};
+
+// Node storage and the transposition map of one search tree
+class Tree {
+public:
+    explicit Tree(int num_workers) : pools(static_cast<std::size_t>(num_workers)) {}
+
+    // Get the node of a state, creating it in the worker's pool if the state is new
+    auto get_or_create(uint64_t hash, bool terminal, int worker) -> Node* {
+        auto& shard = shards[static_cast<std::size_t>(hash >> (64 - kShardBits))];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto& node = shard.nodes[hash];
+        if (node == nullptr) {
+            node = &pools[static_cast<std::size_t>(worker)].emplace_back();
+            node->status.store(terminal ? kTerminal : kUnexpanded, std::memory_order_relaxed);
+            num_nodes.fetch_add(1, std::memory_order_relaxed);
+        }
+        return node;
+    }
+
+    [[nodiscard]] auto size() const noexcept -> uint64_t {
+        return num_nodes.load(std::memory_order_relaxed);
+    }
+
+    Node* root = nullptr;
+
+private:
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<uint64_t, Node*> nodes;
+    };
+
+    std::array<Shard, kNumShards> shards;
+    // One pool per worker, as deques never move their nodes
+    std::vector<std::deque<Node>> pools;
+    std::atomic<uint64_t> num_nodes{0};
+};
+
+class MCTSSearch {
+public:
+    MCTSSearch(const TSPGameState& root_state_, const MCTSOptions& options_, const LeafEvaluator& evaluator_)
+        : root_state(root_state_),
+          options(options_),
+          evaluator(evaluator_),
+          pool(options_.num_threads),
+          value_scale(std::max(1.0, root_state_.get_num_unvisited_cities() + options_.solution_reward)) {
+        if (options.num_simulations < 0 || options.batch_size < 1 || options.virtual_loss < 0 ||
+            options.max_depth < 1) {
+            throw std::invalid_argument("Invalid number of simulations, batch size, virtual loss, or max depth.");
+        }
+        rollout_options.max_steps = options.rollout_steps;
+        rollout_options.discount = options.discount;
+        rollout_options.solution_reward = options.solution_reward;
+        const int num_workers = pool.size();
+        const int num_trees = options.parallelism == MCTSParallelism::kRoot ? num_workers : 1;
+        for (int t = 0; t < num_trees; ++t) {
+            trees.push_back(std::make_unique<Tree>(num_workers));
+            trees.back()->root = trees.back()->get_or_create(root_state.get_hash(), root_state.is_solution(), 0);
+        }
+        for (int w = 0; w < num_workers; ++w) {
+            workers.push_back(std::make_unique<Worker>(root_state, options.batch_size));
+        }
+    }
+
+    auto run() -> MCTSResult {
+        const auto start_time = std::chrono::steady_clock::now();
+        WorkStealingRanges work(options.num_simulations, pool.size());
+        std::exception_ptr error;
+        std::mutex error_mutex;
+        pool.parallel_for(pool.size(), [&](int begin, int end) {
+            for (int w = begin; w < end; ++w) {
+                try {
+                    RunWorker(w, work);
+                } catch (...) {
+                    stop.store(true);
+                    std::lock_guard<std::mutex> lock(error_mutex);
+                    error = std::current_exception();
+                }
+            }
+        });
+        if (error) {
+            std::rethrow_exception(error);
+        }
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time;
+
+        MCTSResult result;
+        result.seconds = elapsed.count();
+        std::array<double, kNumActions> value_sums{};
+        for (const auto& tree : trees) {
+            result.num_nodes += tree->size();
+            for (std::size_t a = 0; a < kNumActions; ++a) {
+                const auto& edge = tree->root->edges[a];
+                result.visit_counts[a] += static_cast<uint32_t>(edge.visits.load());
+                value_sums[a] += edge.value_sum.load();
+            }
+        }
+        for (const auto& worker : workers) {
+            result.num_simulations += worker->num_simulations;
+            result.num_collisions += worker->num_collisions;
+            result.num_evaluator_calls += worker->num_evaluator_calls;
+        }
+        result.simulations_per_second =
+            result.seconds > 0 ? static_cast<double>(result.num_simulations) / result.seconds : 0.0;
+
+        uint64_t total_visits = 0;
+        double total_value = 0;
+        for (std::size_t a = 0; a < kNumActions; ++a) {
+            total_visits += result.visit_counts[a];
+            total_value += value_sums[a];
+            if (result.visit_counts[a] > 0) {
+                result.q_values[a] = static_cast<float>(value_sums[a] / result.visit_counts[a]);
+            }
+            if (result.visit_counts[a] > result.visit_counts[static_cast<std::size_t>(result.action)]) {
+                result.action = static_cast<Action>(a);
+            }
+        }
+        if (total_visits > 0) {
+            for (std::size_t a = 0; a < kNumActions; ++a) {
+                result.policy[a] = static_cast<float>(result.visit_counts[a]) / static_cast<float>(total_visits);
+            }
+            result.value = static_cast<float>(total_value / static_cast<double>(total_visits));
+        }
+        return result;
+    }
+
+private:
+    struct PathStep {
+        Edge* edge;
+        Node* child;
+        double reward;
+    };
+
+    struct Leaf {
+        Node* node;
+        TSPGameState state;
+        std::vector<PathStep> path;
+        uint64_t seed;
+    };
+
+    struct Worker {
+        Worker(const TSPGameState& root_state, int batch_size)
+            : batch(static_cast<std::size_t>(batch_size), Leaf{nullptr, root_state, {}, 0}),
+              states(static_cast<std::size_t>(batch_size)),
+              policies(static_cast<std::size_t>(batch_size * kNumActions)),
+              values(static_cast<std::size_t>(batch_size)) {}
+        std::vector<Leaf> batch;
+        int num_leaves = 0;
+        std::vector<const TSPGameState*> states;
+        std::vector<float> policies;
+        std::vector<float> values;
+        uint64_t num_simulations = 0;
+        uint64_t num_collisions = 0;
+        uint64_t num_evaluator_calls = 0;
+    };
+
+    enum class Descent : int {
+        kLeaf,         // Reached a leaf, which was added to the batch
+        kBackedUp,     // Reached a terminal state or the depth limit, and was backed up straight away
+        kCollision,    // Reached a leaf already being evaluated
+    };
+
+    void RunWorker(int w, WorkStealingRanges& work) {
+        auto& worker = *workers[static_cast<std::size_t>(w)];
+        auto& tree = *trees[options.parallelism == MCTSParallelism::kRoot ? static_cast<std::size_t>(w) : 0];
+        int sim = 0;
+        while (!stop.load(std::memory_order_relaxed) && work.next(w, sim)) {
+            ++worker.num_simulations;
+            // A collision with a leaf of our own batch is resolved by evaluating the batch and descending again
+            while (Descend(w, worker, tree, static_cast<uint64_t>(sim)) == Descent::kCollision) {
+                if (worker.num_leaves == 0) {
+                    ++worker.num_collisions;
+                    break;
+                }
+                Evaluate(worker);
+            }
+            if (worker.num_leaves == options.batch_size) {
+                Evaluate(worker);
+            }
+        }
+        Evaluate(worker);
+    }
+
+    auto Descend(int w, Worker& worker, Tree& tree, uint64_t sim) -> Descent {
+        auto& leaf = worker.batch[static_cast<std::size_t>(worker.num_leaves)];
+        leaf.state = root_state;
+        leaf.path.clear();
+        Node* node = tree.root;
+        uint8_t excluded = 0;
+        while (true) {
+            const int status = node->status.load(std::memory_order_acquire);
+            if (status == kTerminal || static_cast<int>(leaf.path.size()) >= options.max_depth) {
+                Backup(leaf.path, 0.0);
+                return Descent::kBackedUp;
+            }
+            if (status != kExpanded) {
+                int expected = kUnexpanded;
+                if (node->status.compare_exchange_strong(expected, kExpanding, std::memory_order_acq_rel)) {
+                    leaf.node = node;
+                    leaf.seed = options.seed + sim;
+                    ++worker.num_leaves;
+                    return Descent::kLeaf;
+                }
+                for (const auto& step : leaf.path) {
+                    step.edge->virtual_visits.fetch_sub(options.virtual_loss, std::memory_order_relaxed);
+                }
+                return Descent::kCollision;
+            }
+
+            const int action = SelectAction(*node, excluded);
+            if (action < 0) {
+                // Every action is illegal or leads back onto the path, so nothing can be gained from here
+                Backup(leaf.path, 0.0);
+                return Descent::kBackedUp;
+            }
+            auto& edge = node->edges[static_cast<std::size_t>(action)];
+            const auto record = leaf.state.apply_action_with_undo(static_cast<Action>(action));
+            const bool solved = leaf.state.is_solution();
+            Node* child = edge.child.load(std::memory_order_acquire);
+            if (child == nullptr) {
+                child = tree.get_or_create(leaf.state.get_hash(), solved, w);
+                edge.child.store(child, std::memory_order_release);
+            }
+            // Returning to a state on the path is a wasted move, so pick another action instead
+            const auto on_path = [child](const PathStep& step) { return step.child == child; };
+            if (child == tree.root || std::any_of(leaf.path.begin(), leaf.path.end(), on_path)) {
+                leaf.state.undo_action(record);
+                excluded |= static_cast<uint8_t>(1 << action);
+                continue;
+            }
+            edge.virtual_visits.fetch_add(options.virtual_loss, std::memory_order_relaxed);
+            leaf.path.push_back({&edge, child, static_cast<double>(leaf.state.get_reward_signal()) +
+                                                   (solved ? options.solution_reward : 0.0)});
+            node = child;
+            excluded = 0;
+        }
+    }
+
+    // Pick the best legal action outside the excluded mask, or -1 if there is none
+    [[nodiscard]] auto SelectAction(const Node& node, uint8_t excluded) const noexcept -> int {
+        int parent_visits = 0;
+        for (const auto& edge : node.edges) {
+            parent_visits += edge.legal ? edge.visits.load(std::memory_order_relaxed) +
+                                              edge.virtual_visits.load(std::memory_order_relaxed)
+                                        : 0;
+        }
+        int best_action = -1;
+        double best_score = -std::numeric_limits<double>::infinity();
+        for (int a = 0; a < kNumActions; ++a) {
+            const auto& edge = node.edges[static_cast<std::size_t>(a)];
+            if (!edge.legal || (excluded & (1 << a))) {
+                continue;
+            }
+            // Virtual visits count as returns of 0, the lowest possible
+            const int visits = edge.visits.load(std::memory_order_relaxed) +
+                               edge.virtual_visits.load(std::memory_order_relaxed);
+            const double q =
+                visits > 0 ? edge.value_sum.load(std::memory_order_relaxed) / (value_scale * visits) : 0.0;
+            double score = 0;
+            if (options.tree_policy == TreePolicy::kUCT) {
+                score = visits == 0 ? std::numeric_limits<double>::infinity()
+                                    : q + (options.exploration * std::sqrt(std::log(parent_visits) / visits));
+            } else {
+                score = q + (options.exploration * edge.prior * std::sqrt(parent_visits + 1) / (1 + visits));
+            }
+            if (score > best_score) {
+                best_score = score;
+                best_action = a;
+            }
+        }
+        return best_action;
+    }
+
+    void Evaluate(Worker& worker) {
+        const auto num_leaves = static_cast<std::size_t>(worker.num_leaves);
+        if (num_leaves == 0) {
+            return;
+        }
+        if (evaluator) {
+            for (std::size_t i = 0; i < num_leaves; ++i) {
+                worker.states[i] = &worker.batch[i].state;
+            }
+            evaluator(worker.states.data(), worker.num_leaves, worker.policies.data(), worker.values.data());
+            ++worker.num_evaluator_calls;
+        } else {
+            std::fill(worker.policies.begin(), worker.policies.end(), 1.0F);
+            for (std::size_t i = 0; i < num_leaves; ++i) {
+                auto state = worker.batch[i].state;
+                const auto result = rollout(state, rollout_options, worker.batch[i].seed);
+                worker.values[i] = static_cast<float>(result.total_reward);
+            }
+        }
+        for (std::size_t i = 0; i < num_leaves; ++i) {
+            auto& leaf = worker.batch[i];
+            Expand(*leaf.node, leaf.state, &worker.policies[i * kNumActions]);
+            Backup(leaf.path, worker.values[i]);
+        }
+        worker.num_leaves = 0;
+    }
+
+    static void Expand(Node& node, const TSPGameState& state, const float* priors) noexcept {
+        const auto mask = state.legal_action_mask();
+        double prior_sum = 0;
+        int num_legal = 0;
+        for (int a = 0; a < kNumActions; ++a) {
+            if (mask & (1 << a)) {
+                prior_sum += std::max(0.0F, priors[a]);
+                ++num_legal;
+            }
+        }
+        for (int a = 0; a < kNumActions; ++a) {
+            auto& edge = node.edges[static_cast<std::size_t>(a)];
+            edge.legal = (mask & (1 << a)) != 0;
+            if (edge.legal) {
+                edge.prior = prior_sum > 0 ? static_cast<float>(std::max(0.0F, priors[a]) / prior_sum)
+                                           : 1.0F / static_cast<float>(num_legal);
+            }
+        }
+        node.status.store(kExpanded, std::memory_order_release);
+    }
+
+    void Backup(const std::vector<PathStep>& path, double value) noexcept {
+        for (auto it = path.rbegin(); it != path.rend(); ++it) {
+            value = it->reward + (options.discount * value);
+            it->edge->visits.fetch_add(1, std::memory_order_relaxed);
+            AtomicAdd(it->edge->value_sum, value);
+            it->edge->virtual_visits.fetch_sub(options.virtual_loss, std::memory_order_relaxed);
+        }
+    }
+
+    const TSPGameState& root_state;
+    const MCTSOptions& options;
+    const LeafEvaluator& evaluator;
+    RolloutOptions rollout_options;
+    ThreadPool pool;
+    double value_scale;
+    std::vector<std::unique_ptr<Tree>> trees;
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::atomic<bool> stop{false};
+};
+}    // namespace
+
+auto search_mcts(const TSPGameState& state, const MCTSOptions& options, const LeafEvaluator& evaluator) -> MCTSResult {
+    MCTSSearch search(state, options, evaluator);
+    return search.run();
+}
+
+}    // namespace tsp
@@ -0,0 +1,93 @@
+#ifndef TSP_MCTS_H_
+#define TSP_MCTS_H_
+
+#include <array>
+#include <cstdint>
+#include <functional>
+
+#include "definitions.h"
+#include "rollout.h"
+#include "tsp_base.h"
+
+namespace tsp {
+
+enum class TreePolicy : int {
+    kUCT = 0,     // Q + c * sqrt(ln N / n), trying every action once before revisiting any
+    kPUCT = 1,    // Q + c * P * sqrt(N) / (1 + n), with priors P from the leaf evaluator (uniform without one)
+};
+
+enum class MCTSParallelism : int {
+    kTree = 0,    // All threads search one shared tree, spread apart by virtual loss
+    kRoot = 1,    // Each thread searches its own tree, and the root statistics are summed
+};
+
+/**
+ * Batched leaf evaluator, e.g. a hook into an external model.
+ * Given batch_size states, writes kNumActions prior probabilities per state to policies (indexed by action, illegal
+ * actions are ignored and the rest renormalized) and the expected discounted return from each state to values.
+ * States can be encoded with TSPGameState::get_observation(). Called concurrently from several threads when
+ * num_threads != 1.
+ */
+using LeafEvaluator =
+    std::function<void(const TSPGameState *const *states, int batch_size, float *policies, float *values)>;
+
+struct MCTSOptions {
+    // Number of leaf descents, including those abandoned because the leaf was already being evaluated
+    int num_simulations = 800;
+    TreePolicy tree_policy = TreePolicy::kPUCT;
+    MCTSParallelism parallelism = MCTSParallelism::kTree;
+    // Number of threads, or <= 0 to use the hardware concurrency
+    int num_threads = 1;
+    // Exploration constant, applied to values normalized by the number of unvisited cities plus the solution reward
+    double exploration = 1.25;
+    // Visits added to each edge on the path of a simulation in flight, counting as losses until the leaf is backed up
+    int virtual_loss = 1;
+    // Number of leaves each thread collects before calling the evaluator
+    int batch_size = 1;
+    // Maximum depth of a descent, which also stops descents cycling through repeated states
+    int max_depth = 256;
+    // Returns are discounted so that shorter tours are preferred
+    double discount = 0.99;
+    // Reward for reaching a solution state, on top of get_reward_signal()
+    double solution_reward = 1.0;
+    // Step cap of the random rollouts used to value leaves when there is no evaluator
+    int rollout_steps = 200;
+    uint64_t seed = 0;
+};
+
+struct MCTSResult {
+    // Most visited root action
+    Action action = Action::kUp;
+    std::array<uint32_t, kNumActions> visit_counts{};
+    // Mean return of each root action, or 0 if unvisited
+    std::array<float, kNumActions> q_values{};
+    // Root visit counts normalized to a distribution, e.g. as a policy target
+    std::array<float, kNumActions> policy{};
+    // Visit weighted mean return from the root
+    float value = 0;
+    uint64_t num_simulations = 0;
+    // Descents abandoned because they reached a leaf which was already being evaluated
+    uint64_t num_collisions = 0;
+    // Number of distinct states in the tree(s), shared between transpositions
+    uint64_t num_nodes = 0;
+    uint64_t num_evaluator_calls = 0;
+    double seconds = 0;
+    double simulations_per_second = 0;
+};
+
+/**
+ * Monte Carlo tree search from a state.
+ * Nodes are shared between transpositions by get_hash(), with visit statistics kept on the edges. Threads take
+ * simulations from a work stealing scheduler, and in-flight descents add virtual loss so that threads and the leaves of
+ * a batch spread over the tree.
+ * @param state The state to search from
+ * @param options The search options
+ * @param evaluator Batched leaf evaluator, or empty to value leaves with random rollouts under uniform priors
+ * @return The root statistics and search throughput
+ */
+[[nodiscard]] auto search_mcts(const TSPGameState &state, const MCTSOptions &options = MCTSOptions(),
+                               const LeafEvaluator &evaluator = nullptr) -> MCTSResult;
+
+}    // namespace tsp
+
+#endif    // TSP_MCTS_H_
@@ -0,0 +1,244 @@
+#include "observation.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+#include "definitions.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define TSP_HAS_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+namespace tsp {
+
+namespace {
+// Value written for a set channel, for each output type
+template <typename T>
+constexpr auto OneValue() noexcept -> T {
+    if constexpr (std::is_same_v<T, float>) {
+        return 1.0F;
+    } else if constexpr (std::is_same_v<T, uint16_t>) {
+        return kBFloat16One;
+    } else {
+        return 1;
+    }
+}
+
+// Bit pattern of 1.0F, for writing float planes with integer vector stores
+constexpr int32_t kFloatOneBits = 0x3F800000;
+
+template <typename T>
+void EncodeScalar(const uint8_t* codes, int begin, int end, T* obs, int channel_stride) noexcept {
+    for (int c = 0; c < kNumChannels; ++c) {
+        T* plane = obs + static_cast<std::ptrdiff_t>(c) * channel_stride;
+        for (int i = begin; i < end; ++i) {
+            plane[i] = codes[i] == c ? OneValue<T>() : T{0};
+        }
+    }
+}
+
+#ifdef TSP_HAS_X86_SIMD
+// The vector kernels only depend on the output width, and return the number of cells written so that the scalar
+// kernel can finish the tail
+template <typename T>
+auto EncodeSSE2(const uint8_t* codes, int num_cells, T* obs, int channel_stride) noexcept -> int {
+    constexpr int kStep = 16 / static_cast<int>(sizeof(T));
+    const int vec_end = num_cells - (num_cells % kStep);
+    const __m128i zero = _mm_setzero_si128();
+    for (int i = 0; i < vec_end; i += kStep) {
+        // Widen the codes to the output width
+        __m128i wide;
+        if constexpr (sizeof(T) == 1) {
+            wide = _mm_loadu_si128(reinterpret_cast<const __m128i*>(codes + i));    // NOLINT(*-reinterpret-cast)
+        } else if constexpr (sizeof(T) == 2) {
+            wide = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(codes + i)), zero);    // NOLINT
+        } else {
+            int32_t packed = 0;
+            std::memcpy(&packed, codes + i, sizeof(packed));
+            wide = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero), zero);
+        }
+        for (int c = 0; c < kNumChannels; ++c) {
+            __m128i mask;
+            if constexpr (sizeof(T) == 1) {
+                mask = _mm_cmpeq_epi8(wide, _mm_set1_epi8(static_cast<char>(c)));
+            } else if constexpr (sizeof(T) == 2) {
+                mask = _mm_cmpeq_epi16(wide, _mm_set1_epi16(static_cast<int16_t>(c)));
+            } else {
+                mask = _mm_cmpeq_epi32(wide, _mm_set1_epi32(c));
+            }
+            const __m128i one = sizeof(T) == 1   ? _mm_set1_epi8(1)
+                                : sizeof(T) == 2 ? _mm_set1_epi16(static_cast<int16_t>(kBFloat16One))
+                                                 : _mm_set1_epi32(kFloatOneBits);
+            T* out = obs + (static_cast<std::ptrdiff_t>(c) * channel_stride) + i;
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_and_si128(mask, one));    // NOLINT
+        }
+    }
+    return vec_end;
+}
+
+template <typename T>
+__attribute__((target("avx2"))) auto EncodeAVX2(const uint8_t* codes, int num_cells, T* obs,
+                                                int channel_stride) noexcept -> int {
+    constexpr int kStep = 32 / static_cast<int>(sizeof(T));
+    const int vec_end = num_cells - (num_cells % kStep);
+    for (int i = 0; i < vec_end; i += kStep) {
+        // Widen the codes to the output width
+        __m256i wide;
+        if constexpr (sizeof(T) == 1) {
+            wide = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(codes + i));    // NOLINT(*-reinterpret-cast)
+        } else if constexpr (sizeof(T) == 2) {
+            wide = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(codes + i)));    // NOLINT
+        } else {
+            wide = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(codes + i)));    // NOLINT
+        }
+        for (int c = 0; c < kNumChannels; ++c) {
+            __m256i mask;
+            if constexpr (sizeof(T) == 1) {
+                mask = _mm256_cmpeq_epi8(wide, _mm256_set1_epi8(static_cast<char>(c)));
+            } else if constexpr (sizeof(T) == 2) {
+                mask = _mm256_cmpeq_epi16(wide, _mm256_set1_epi16(static_cast<int16_t>(c)));
+            } else {
+                mask = _mm256_cmpeq_epi32(wide, _mm256_set1_epi32(c));
+            }
+            const __m256i one = sizeof(T) == 1   ? _mm256_set1_epi8(1)
+                                : sizeof(T) == 2 ? _mm256_set1_epi16(static_cast<int16_t>(kBFloat16One))
+                                                 : _mm256_set1_epi32(kFloatOneBits);
+            T* out = obs + (static_cast<std::ptrdiff_t>(c) * channel_stride) + i;
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_and_si256(mask, one));    // NOLINT
+        }
+    }
+    return vec_end;
+}
+#endif
+
+auto DetectSimdLevel() noexcept -> SimdLevel {
+#ifdef TSP_HAS_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return SimdLevel::kAVX2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return SimdLevel::kSSE2;
+    }
+#endif
+    return SimdLevel::kScalar;
+}
+
+template <typename T>
+void Encode(const uint8_t* codes, int num_cells, T* obs, int channel_stride) noexcept {
+    int vec_end = 0;
+#ifdef TSP_HAS_X86_SIMD
+    switch (get_simd_level()) {
+        case SimdLevel::kAVX2:
+            vec_end = EncodeAVX2(codes, num_cells, obs, channel_stride);
+            break;
+        case SimdLevel::kSSE2:
+            vec_end = EncodeSSE2(codes, num_cells, obs, channel_stride);
+            break;
+        case SimdLevel::kScalar:
+            break;
+    }
+#endif
+    EncodeScalar(codes, vec_end, num_cells, obs, channel_stride);
+}
+
+template <typename T>
+void DecodeBitPlanes(const uint64_t* planes, int num_cells, T* obs, int channel_stride) noexcept {
+    const std::size_t num_words = bit_plane_words(num_cells);
+    for (int c = 0; c < kNumChannels; ++c) {
+        T* plane = obs + static_cast<std::ptrdiff_t>(c) * channel_stride;
+        const uint64_t* words = planes + static_cast<std::size_t>(c) * num_words;
+        std::fill_n(plane, num_cells, T{0});
+        for (std::size_t w = 0; w < num_words; ++w) {
+            for (uint64_t word = words[w]; word != 0; word &= word - 1) {
+                plane[(w * 64) + static_cast<std::size_t>(__builtin_ctzll(word))] = OneValue<T>();
+            }
+        }
+    }
+}
+
+template <typename T>
+void DecodeSparse(const uint32_t* entries, int num_entries, int num_cells, T* obs, int channel_stride) noexcept {
+    // Every cell starts empty, and each entry moves its cell to another channel
+    std::fill_n(obs, num_cells, OneValue<T>());
+    for (int c = 1; c < kNumChannels; ++c) {
+        std::fill_n(obs + static_cast<std::ptrdiff_t>(c) * channel_stride, num_cells, T{0});
+    }
+    for (int e = 0; e < num_entries; ++e) {
+        const int index = get_sparse_cell_index(entries[e]);
+        obs[index] = T{0};
+        obs[(static_cast<std::ptrdiff_t>(get_sparse_cell_element(entries[e])) * channel_stride) + index] =
+            OneValue<T>();
+    }
+}
+}    // namespace
+
+auto get_simd_level() noexcept -> SimdLevel {
+    static const SimdLevel level = DetectSimdLevel();
+    return level;
+}
+
+void encode_one_hot(const uint8_t* codes, int num_cells, float* obs, int channel_stride) noexcept {
+    Encode(codes, num_cells, obs, channel_stride);
+}
+
+void encode_one_hot(const uint8_t* codes, int num_cells, uint8_t* obs, int channel_stride) noexcept {
+    Encode(codes, num_cells, obs, channel_stride);
+}
+
+void encode_one_hot_bfloat16(const uint8_t* codes, int num_cells, uint16_t* obs, int channel_stride) noexcept {
+    Encode(codes, num_cells, obs, channel_stride);
+}
+
+void decode_one_hot(const float* obs, int num_cells, int channel_stride, uint8_t* codes) noexcept {
+    for (int i = 0; i < num_cells; ++i) {
+        int best = 0;
+        for (int c = 1; c < kNumChannels; ++c) {
+            if (obs[(static_cast<std::ptrdiff_t>(c) * channel_stride) + i] >
+                obs[(static_cast<std::ptrdiff_t>(best) * channel_stride) + i]) {
+                best = c;
+            }
+        }
+        codes[i] = static_cast<uint8_t>(best);
+    }
+}
+
+void encode_bit_planes(const uint8_t* codes, int num_cells, uint64_t* planes) noexcept {
+    const std::size_t num_words = bit_plane_words(num_cells);
+    std::fill_n(planes, kNumChannels * num_words, 0);
+    for (int i = 0; i < num_cells; ++i) {
+        planes[(codes[i] * num_words) + (static_cast<std::size_t>(i) / 64)] |= uint64_t{1} << (i % 64);
+    }
+}
+
+void decode_bit_planes(const uint64_t* planes, int num_cells, float* obs, int channel_stride) noexcept {
+    DecodeBitPlanes(planes, num_cells, obs, channel_stride);
+}
+
+void decode_bit_planes(const uint64_t* planes, int num_cells, uint8_t* obs, int channel_stride) noexcept {
+    DecodeBitPlanes(planes, num_cells, obs, channel_stride);
+}
+
+auto encode_sparse(const uint8_t* codes, int num_cells, uint32_t* entries) noexcept -> int {
+    int num_entries = 0;
+    for (int i = 0; i < num_cells; ++i) {
+        if (codes[i] != static_cast<uint8_t>(Element::kEmpty)) {
+            entries[num_entries++] = make_sparse_cell(i, codes[i]);
+        }
+    }
+    return num_entries;
+}
+
+void decode_sparse(const uint32_t* entries, int num_entries, int num_cells, float* obs, int channel_stride) noexcept {
+    DecodeSparse(entries, num_entries, num_cells, obs, channel_stride);
+}
+
+void decode_sparse(const uint32_t* entries, int num_entries, int num_cells, uint8_t* obs,
+                   int channel_stride) noexcept {
+    DecodeSparse(entries, num_entries, num_cells, obs, channel_stride);
+}
+
+}    // namespace tsp
@@ -0,0 +1,141 @@
+#ifndef TSP_OBSERVATION_H_
+#define TSP_OBSERVATION_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace tsp {
+
+// bfloat16 bit pattern of 1.0
+constexpr uint16_t kBFloat16One = 0x3F80;
+
+enum class SimdLevel : int {
+    kScalar = 0,
+    kSSE2 = 1,
+    kAVX2 = 2,
+};
+
+/**
+ * Get the instruction set used by the one-hot kernels, chosen at runtime from what the CPU supports
+ * @return The SIMD level
+ */
+[[nodiscard]] auto get_simd_level() noexcept -> SimdLevel;
+
+/**
+ * One-hot encode per-cell element codes into channel planes, where channel c of cell i is 1 if codes[i] == c.
+ * Every channel is written for each cell, so the planes don't need to be cleared first.
+ * @param codes Element code (static_cast<uint8_t>(Element)) of each cell
+ * @param num_cells Number of cells
+ * @param obs The buffer to write into, holding kNumChannels planes
+ * @param channel_stride Number of values between the start of consecutive channels (>= num_cells)
+ */
+void encode_one_hot(const uint8_t *codes, int num_cells, float *obs, int channel_stride) noexcept;
+
+/**
+ * One-hot encode per-cell element codes into uint8_t channel planes of 0 and 1.
+ * @param codes Element code of each cell
+ * @param num_cells Number of cells
+ * @param obs The buffer to write into, holding kNumChannels planes
+ * @param channel_stride Number of values between the start of consecutive channels (>= num_cells)
+ */
+void encode_one_hot(const uint8_t *codes, int num_cells, uint8_t *obs, int channel_stride) noexcept;
+
+/**
+ * One-hot encode per-cell element codes into bfloat16 channel planes, stored as their uint16_t bit patterns.
+ * @param codes Element code of each cell
+ * @param num_cells Number of cells
+ * @param obs The buffer to write into, holding kNumChannels planes
+ * @param channel_stride Number of values between the start of consecutive channels (>= num_cells)
+ */
+void encode_one_hot_bfloat16(const uint8_t *codes, int num_cells, uint16_t *obs, int channel_stride) noexcept;
+
+/**
+ * Convert a dense one-hot observation back to per-cell element codes (argmax over the channels).
+ * The codes are the per-cell uint8_t index form, which encode_one_hot() decodes back to the dense layout.
+ * @param obs The dense observation
+ * @param num_cells Number of cells
+ * @param channel_stride Number of values between the start of consecutive channels (>= num_cells)
+ * @param codes The buffer to write into, of at least num_cells bytes
+ */
+void decode_one_hot(const float *obs, int num_cells, int channel_stride, uint8_t *codes) noexcept;
+
+/**
+ * Get the number of words in each channel plane of the bit-packed form
+ * @param num_cells Number of cells
+ * @return Number of words per channel
+ */
+[[nodiscard]] constexpr auto bit_plane_words(int num_cells) noexcept -> std::size_t {
+    return (static_cast<std::size_t>(num_cells) + 63) / 64;
+}
+
+/**
+ * Encode per-cell element codes as bit-packed channel planes, where bit i of plane c is set if codes[i] == c.
+ * Plane c starts at word c * bit_plane_words(num_cells), and bits past num_cells are cleared.
+ * @param codes Element code of each cell
+ * @param num_cells Number of cells
+ * @param planes The buffer to write into, of kNumChannels * bit_plane_words(num_cells) words
+ */
+void encode_bit_planes(const uint8_t *codes, int num_cells, uint64_t *planes) noexcept;
+
+/**
+ * Decode bit-packed channel planes to the dense layout.
+ * @param planes The bit-packed planes
+ * @param num_cells Number of cells
+ * @param obs The buffer to write into, holding kNumChannels planes
+ * @param channel_stride Number of values between the start of consecutive channels (>= num_cells)
+ */
+void decode_bit_planes(const uint64_t *planes, int num_cells, float *obs, int channel_stride) noexcept;
+void decode_bit_planes(const uint64_t *planes, int num_cells, uint8_t *obs, int channel_stride) noexcept;
+
+/**
+ * Entry of the sparse form, packing a cell index with the element at that cell
+ * @param index The cell index, less than 2^29
+ * @param el_code The element code
+ * @return The packed entry
+ */
+[[nodiscard]] constexpr auto make_sparse_cell(int index, uint8_t el_code) noexcept -> uint32_t {
+    return (static_cast<uint32_t>(index) << 3) | el_code;
+}
+
+/**
+ * Get the cell index of a sparse entry
+ * @param entry The packed entry
+ * @return The cell index
+ */
+[[nodiscard]] constexpr auto get_sparse_cell_index(uint32_t entry) noexcept -> int {
+    return static_cast<int>(entry >> 3);
+}
+
+/**
+ * Get the element code of a sparse entry
+ * @param entry The packed entry
+ * @return The element code
+ */
+[[nodiscard]] constexpr auto get_sparse_cell_element(uint32_t entry) noexcept -> uint8_t {
+    return static_cast<uint8_t>(entry & 7);
+}
+
+/**
+ * Encode per-cell element codes as a list of the non-empty cells, in increasing cell order.
+ * @param codes Element code of each cell
+ * @param num_cells Number of cells
+ * @param entries The buffer to write into, of at least num_cells entries
+ * @return Number of entries written
+ */
+auto encode_sparse(const uint8_t *codes, int num_cells, uint32_t *entries) noexcept -> int;
+
+/**
+ * Decode a list of non-empty cells to the dense layout, where every cell not in the list is empty.
+ * @param entries The sparse entries
+ * @param num_entries Number of entries
+ * @param num_cells Number of cells
+ * @param obs The buffer to write into, holding kNumChannels planes
+ * @param channel_stride Number of values between the start of consecutive channels (>= num_cells)
+ */
+void decode_sparse(const uint32_t *entries, int num_entries, int num_cells, float *obs, int channel_stride) noexcept;
+void decode_sparse(const uint32_t *entries, int num_entries, int num_cells, uint8_t *obs,
+                   int channel_stride) noexcept;
+
+}    // namespace tsp
+
+#endif    // TSP_OBSERVATION_H_
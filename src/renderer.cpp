@@ -0,0 +1,153 @@
+#include "renderer.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+
+#include "instrumentation.h"
+
+namespace tsp {
+
+namespace {
+// Colour maps for state to image
+struct Pixel {
+    unsigned char r;
+    unsigned char g;
+    unsigned char b;
+};
+const Pixel WHITE = {.r = 0xff, .g = 0xff, .b = 0xff};
+const Pixel BLACK = {.r = 0x00, .g = 0x00, .b = 0x00};
+const Pixel RED = {.r = 0xff, .g = 0x00, .b = 0x00};
+const Pixel GREEN = {.r = 0x00, .g = 0xFF, .b = 0x00};
+const Pixel BLUE = {.r = 0x00, .g = 0xFF, .b = 0xFF};
+const Pixel YELLOW = {.r = 0xFF, .g = 0xFF, .b = 0x00};
+const Pixel MAGENTA = {.r = 0xFF, .g = 0x00, .b = 0xFF};
+const Pixel GREY = {.r = 0xA9, .g = 0xA9, .b = 0xA9};
+const std::array<Pixel, kNumElements> kElementToPixelMap{
+    WHITE,      // kEmpty
+    BLACK,      // kAgent
+    GREY,       // kWall
+    RED,        // kCityUnvisited
+    GREEN,      // kCityVisited
+    BLUE,       // kStartCity
+    YELLOW,     // kAgentAtCity
+    MAGENTA,    // kAgentAtStartCity
+};
+
+constexpr int kImageChannels = 3;
+}    // namespace
+
+Renderer::Renderer(int sprite_height_, int sprite_width_) : sprite_height(sprite_height_), sprite_width(sprite_width_) {
+    if (sprite_height <= 0 || sprite_width <= 0) {
+        throw std::invalid_argument("Sprite size must be positive.");
+    }
+    for (std::size_t el = 0; el < kNumElements; ++el) {
+        const auto& pixel = kElementToPixelMap[el];
+        auto& row = sprite_rows[el];
+        row.resize(static_cast<std::size_t>(sprite_width * kImageChannels));
+        for (std::size_t c = 0; c < row.size(); c += kImageChannels) {
+            row[c + 0] = pixel.r;
+            row[c + 1] = pixel.g;
+            row[c + 2] = pixel.b;
+        }
+    }
+}
+
+auto Renderer::image_shape(const TSPGameState& state) const noexcept -> std::array<int, 3> {
+    const auto& level = state.get_level();
+    return {level->get_rows() * sprite_height, level->get_cols() * sprite_width, kImageChannels};
+}
+
+void Renderer::render(const TSPGameState& state, uint8_t* img) const noexcept {
+    render(state, img, state.get_level()->get_cols() * sprite_width * kImageChannels);
+}
+
+void Renderer::render(const TSPGameState& state, uint8_t* img, int row_stride) const noexcept {
+    TSP_COUNT(kImage);
+    TSP_TIME(kImage);
+    const auto& level = state.get_level();
+    const auto cols = level->get_cols();
+    const auto sprite_row_bytes = static_cast<std::size_t>(sprite_width * kImageChannels);
+    const auto image_row_bytes = static_cast<std::size_t>(cols) * sprite_row_bytes;
+    int i = 0;
+    for (int h = 0; h < level->get_rows(); ++h) {
+        // Draw the first pixel row of each sprite, then copy it down the rest of the sprite height
+        uint8_t* first_row = img + (static_cast<std::ptrdiff_t>(h * sprite_height) * row_stride);
+        for (int w = 0; w < cols; ++w, ++i) {
+            const auto& sprite_row = sprite_rows[static_cast<std::size_t>(state.get_element(i))];
+            std::memcpy(first_row + (w * sprite_row_bytes), sprite_row.data(), sprite_row_bytes);
+        }
+        for (int r = 1; r < sprite_height; ++r) {
+            std::memcpy(first_row + static_cast<std::ptrdiff_t>(r) * row_stride, first_row, image_row_bytes);
+        }
+    }
+}
+
+void Renderer::render_dirty(const TSPGameState& state, uint8_t* img) {
+    render_dirty(state, img, state.get_level()->get_cols() * sprite_width * kImageChannels);
+}
+
+void Renderer::render_dirty(const TSPGameState& state, uint8_t* img, int row_stride) {
+    const auto& level = state.get_level();
+    const auto& cities = level->get_city_indices();
+    visited_words.resize((cities.size() + kBitsPerWord - 1) / kBitsPerWord);
+    state.get_visited_city_words(visited_words.data());
+    const int agent_idx = state.get_agent_index();
+    const int start_city_idx = state.get_start_city_index();
+
+    if (level != prev_level || row_stride != prev_row_stride) {
+        render(state, img, row_stride);
+        num_cells_drawn = level->get_num_cells();
+    } else {
+        // Only the agent cells, start city, and newly (un)visited cities can change between frames
+        TSP_COUNT(kImage);
+        TSP_TIME(kImage);
+        num_cells_drawn = 0;
+        std::array<int, 4> drawn{prev_agent_idx, agent_idx, prev_start_city_idx, start_city_idx};
+        const auto drawn_end = drawn.begin() + 4;
+        for (auto it = drawn.begin(); it != drawn_end; ++it) {
+            if (*it != -1 && std::find(drawn.begin(), it, *it) == it) {
+                DrawCell(img, row_stride, level->get_cols(), *it, state.get_element(*it));
+                ++num_cells_drawn;
+            }
+        }
+        for (std::size_t w = 0; w < visited_words.size(); ++w) {
+            uint64_t changed = visited_words[w] ^ prev_visited_words[w];
+            while (changed != 0) {
+                const int city_idx = cities[w * kBitsPerWord + static_cast<std::size_t>(__builtin_ctzll(changed))];
+                if (std::find(drawn.begin(), drawn_end, city_idx) == drawn_end) {
+                    DrawCell(img, row_stride, level->get_cols(), city_idx, state.get_element(city_idx));
+                    ++num_cells_drawn;
+                }
+                changed &= changed - 1;
+            }
+        }
+    }
+
+    prev_level = level;
+    prev_row_stride = row_stride;
+    prev_agent_idx = agent_idx;
+    prev_start_city_idx = start_city_idx;
+    prev_visited_words.swap(visited_words);
+}
+
+void Renderer::reset() noexcept {
+    prev_level.reset();
+    prev_row_stride = -1;
+}
+
+// ---------------------------------------------------------------------------
+
+void Renderer::DrawCell(uint8_t* img, int row_stride, int cols, int index, Element el) const noexcept {
+    const auto& sprite_row = sprite_rows[static_cast<std::size_t>(el)];
+    const int h = index / cols;
+    const int w = index % cols;
+    uint8_t* img_row = img + (static_cast<std::ptrdiff_t>(h * sprite_height) * row_stride) +
+                       (static_cast<std::ptrdiff_t>(w) * static_cast<std::ptrdiff_t>(sprite_row.size()));
+    for (int r = 0; r < sprite_height; ++r, img_row += row_stride) {
+        std::memcpy(img_row, sprite_row.data(), sprite_row.size());
+    }
+}
+
+}    // namespace tsp
@@ -0,0 +1,98 @@
+#ifndef TSP_RENDERER_H_
+#define TSP_RENDERER_H_
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "definitions.h"
+#include "tsp_base.h"
+#include "tsp_level.h"
+
+namespace tsp {
+
+/**
+ * Renders states into RGB (HWC) images, where each cell is drawn as a solid sprite of the element's colour.
+ * One pixel row of each element's sprite is pre-rendered, so drawing a cell is a memcpy per pixel row.
+ */
+class Renderer {
+public:
+    /**
+     * @param sprite_height Height in pixels of each cell
+     * @param sprite_width Width in pixels of each cell
+     * @throws std::invalid_argument if the sprite size is not positive
+     */
+    explicit Renderer(int sprite_height = 1, int sprite_width = 1);
+
+    /**
+     * Get the shape the image of a state should be viewed as.
+     * @param state The state to render
+     * @return array indicating image HWC
+     */
+    [[nodiscard]] auto image_shape(const TSPGameState &state) const noexcept -> std::array<int, 3>;
+
+    /**
+     * Render the full image of a state into a caller provided buffer, which must hold the number of bytes given by
+     * image_shape().
+     * @param state The state to render
+     * @param img The buffer to write into
+     */
+    void render(const TSPGameState &state, uint8_t *img) const noexcept;
+
+    /**
+     * Render the full image of a state, with a custom distance between the start of each pixel row.
+     * @param state The state to render
+     * @param img The buffer to write into
+     * @param row_stride Number of bytes between the start of consecutive pixel rows (>= image width * channels)
+     */
+    void render(const TSPGameState &state, uint8_t *img, int row_stride) const noexcept;
+
+    /**
+     * Render a state into the buffer holding the previous frame from render_dirty(), only redrawing the cells which
+     * changed. The full image is drawn on the first call, after reset(), or if the level or stride changed.
+     * @param state The state to render
+     * @param img The buffer holding the previous frame
+     */
+    void render_dirty(const TSPGameState &state, uint8_t *img);
+
+    /**
+     * Render a state into the buffer holding the previous frame, with a custom row stride.
+     * @param state The state to render
+     * @param img The buffer holding the previous frame
+     * @param row_stride Number of bytes between the start of consecutive pixel rows (>= image width * channels)
+     */
+    void render_dirty(const TSPGameState &state, uint8_t *img, int row_stride);
+
+    /**
+     * Forget the previous frame, so the next render_dirty() draws the full image (e.g. when switching buffers).
+     */
+    void reset() noexcept;
+
+    /**
+     * Get the number of cells drawn by the last render_dirty()
+     * @return Number of cells
+     */
+    [[nodiscard]] auto get_num_cells_drawn() const noexcept -> int {
+        return num_cells_drawn;
+    }
+
+private:
+    void DrawCell(uint8_t *img, int row_stride, int cols, int index, Element el) const noexcept;
+
+    int sprite_height;
+    int sprite_width;
+    std::array<std::vector<uint8_t>, kNumElements> sprite_rows;
+
+    // Previous frame drawn by render_dirty()
+    TSPLevelPtr prev_level;
+    int prev_row_stride = -1;
+    int prev_agent_idx = -1;
+    int prev_start_city_idx = -1;
+    std::vector<uint64_t> prev_visited_words;
+    std::vector<uint64_t> visited_words;
+    int num_cells_drawn = 0;
+};
+
+}    // namespace tsp
+
+#endif    // TSP_RENDERER_H_
@@ -0,0 +1,91 @@
+#include "rollout.h"
+
+#include <bitset>
+#include <chrono>
+#include <exception>
+#include <mutex>
+
+#include "thread_pool.h"
+#include "work_stealing.h"
+#include "zobrist.h"
+
+namespace tsp {
+
+namespace {
+// Pick a legal action uniformly, or kUp if there is none (the agent is walled in, so every action is a no-op)
+auto RandomLegalAction(const TSPGameState& state, uint64_t random) noexcept -> Action {
+    const auto mask = state.legal_action_mask();
+    const auto num_legal = static_cast<uint64_t>(std::bitset<kNumActions>(mask).count());
+    if (num_legal == 0) {
+        return Action::kUp;
+    }
+    auto k = static_cast<uint64_t>((static_cast<unsigned __int128>(random) * num_legal) >> 64);
+    for (int a = 0; a < kNumActions; ++a) {
+        if ((mask & (1 << a)) && k-- == 0) {
+            return static_cast<Action>(a);
+        }
+    }
+    return Action::kUp;
+}
+}    // namespace
+
+auto rollout(TSPGameState& state, const RolloutOptions& options, uint64_t seed, const RolloutPolicy& policy)
+    -> RolloutResult {
+    RolloutResult result;
+    result.solved = state.is_solution();
+    uint64_t rng_state = splitmix64(seed);
+    double scale = 1.0;
+    while (!result.solved && result.steps < options.max_steps) {
+        const uint64_t random = splitmix64(rng_state++);
+        state.apply_action(policy ? policy(state, random) : RandomLegalAction(state, random));
+        ++result.steps;
+        result.solved = state.is_solution();
+        result.total_reward += scale * (static_cast<double>(state.get_reward_signal()) +
+                                        (result.solved ? options.solution_reward : 0.0));
+        scale *= options.discount;
+    }
+    return result;
+}
+
+auto run_rollouts(const std::vector<TSPGameState>& states, const RolloutOptions& options, const RolloutPolicy& policy)
+    -> RolloutBatchResult {
+    RolloutBatchResult batch;
+    batch.results.resize(states.size());
+    const auto start_time = std::chrono::steady_clock::now();
+
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    ThreadPool pool(options.num_threads);
+    WorkStealingRanges work(static_cast<int>(states.size()), pool.size());
+    pool.parallel_for(pool.size(), [&](int begin, int end) {
+        try {
+            for (int worker = begin; worker < end; ++worker) {
+                int i = 0;
+                while (work.next(worker, i)) {
+                    const auto idx = static_cast<std::size_t>(i);
+                    auto state = states[idx];
+                    batch.results[idx] = rollout(state, options, options.seed + idx, policy);
+                }
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            error = std::current_exception();
+        }
+    });
+    if (error) {
+        std::rethrow_exception(error);
+    }
+
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time;
+    batch.seconds = elapsed.count();
+    for (const auto& result : batch.results) {
+        batch.total_steps += static_cast<uint64_t>(result.steps);
+    }
+    if (batch.seconds > 0) {
+        batch.rollouts_per_second = static_cast<double>(states.size()) / batch.seconds;
+        batch.steps_per_second = static_cast<double>(batch.total_steps) / batch.seconds;
+    }
+    return batch;
+}
+
+}    // namespace tsp
@@ -0,0 +1,74 @@
+#ifndef TSP_ROLLOUT_H_
+#define TSP_ROLLOUT_H_
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "definitions.h"
+#include "tsp_base.h"
+
+namespace tsp {
+
+/**
+ * Rollout policy, which picks the action to take from a state.
+ * Called with a uniformly random 64 bit number which the policy may use to sample, so that rollouts are reproducible.
+ * Called concurrently from several threads when rollouts run in parallel.
+ */
+using RolloutPolicy = std::function<Action(const TSPGameState &state, uint64_t random)>;
+
+struct RolloutOptions {
+    // Maximum number of steps of each rollout
+    int max_steps = 1000;
+    // Each reward is scaled by discount^t, where t is the number of steps taken before it
+    double discount = 1.0;
+    // Extra reward for reaching a solution state
+    double solution_reward = 0.0;
+    // Number of threads, or <= 0 to use the hardware concurrency
+    int num_threads = 1;
+    // Rollout i of a batch is seeded from seed + i, so results don't depend on the number of threads
+    uint64_t seed = 0;
+};
+
+struct RolloutResult {
+    // Discounted sum of get_reward_signal() over the rollout, plus the solution reward if solved
+    double total_reward = 0;
+    int steps = 0;
+    bool solved = false;
+};
+
+struct RolloutBatchResult {
+    // Result of each rollout, in input order
+    std::vector<RolloutResult> results;
+    uint64_t total_steps = 0;
+    double seconds = 0;
+    double rollouts_per_second = 0;
+    double steps_per_second = 0;
+};
+
+/**
+ * Play a rollout from a state until it is solved or the step cap is reached.
+ * @param state The state to play from, which is left at the final state
+ * @param options The rollout options, where num_threads and seed are unused
+ * @param seed Seed for the random numbers of this rollout
+ * @param policy The policy, or empty to pick uniformly among the legal actions
+ * @return The rollout result
+ */
+auto rollout(TSPGameState &state, const RolloutOptions &options, uint64_t seed, const RolloutPolicy &policy = nullptr)
+    -> RolloutResult;
+
+/**
+ * Play one rollout from each state in parallel, with work stealing between threads to balance rollouts of uneven
+ * length.
+ * @param states The states to play from, e.g. the same state repeated for many rollouts of it
+ * @param options The rollout options
+ * @param policy The policy, or empty to pick uniformly among the legal actions
+ * @return The result of each rollout and the throughput
+ */
+[[nodiscard]] auto run_rollouts(const std::vector<TSPGameState> &states,
+                                const RolloutOptions &options = RolloutOptions(), const RolloutPolicy &policy = nullptr)
+    -> RolloutBatchResult;
+
+}    // namespace tsp
+
+#endif    // TSP_ROLLOUT_H_
@@ -0,0 +1,284 @@
+#include "serialization.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
+
+namespace tsp {
+
+namespace {
+constexpr std::array<char, 4> kMagic{'T', 'S', 'P', 'B'};
+constexpr uint32_t kByteOrderMarker = 0x01020304;
+
+struct FileHeader {
+    std::array<char, 4> magic{};
+    uint32_t version = 0;
+    uint32_t byte_order = 0;
+    uint32_t num_levels = 0;
+    uint32_t state_words = 0;
+    uint32_t reserved = 0;
+    uint64_t num_states = 0;
+    uint64_t states_offset = 0;
+};
+static_assert(sizeof(FileHeader) % sizeof(uint64_t) == 0);
+
+struct LevelHeader {
+    int32_t rows = 0;
+    int32_t cols = 0;
+    int32_t agent_idx = 0;
+    int32_t num_cities = 0;
+};
+static_assert(sizeof(LevelHeader) % sizeof(uint64_t) == 0);
+
+// Trivial so that records can be copied in and out of word buffers, hence no default member initializers
+struct RecordHeader {
+    uint32_t level_index;
+    int32_t agent_idx;
+    int32_t start_city_idx;
+    uint32_t reserved;
+    uint64_t hash;
+};
+static_assert(sizeof(RecordHeader) % sizeof(uint64_t) == 0);
+static_assert(std::is_trivial_v<RecordHeader>);
+
+constexpr std::size_t kRecordHeaderWords = sizeof(RecordHeader) / sizeof(uint64_t);
+
+auto NumWords(std::size_t bits) noexcept -> std::size_t {
+    return (bits + kBitsPerWord - 1) / kBitsPerWord;
+}
+
+// Read a layer of num_cells bits, rejecting set bits past the end so that layers compare equal word by word
+auto ReadLayer(const char* data, std::size_t num_cells) -> BoardBitset {
+    BoardBitset layer(num_cells);
+    std::memcpy(layer.data(), data, layer.num_words() * sizeof(uint64_t));
+    if (num_cells % kBitsPerWord != 0 && (layer.data()[layer.num_words() - 1] >> (num_cells % kBitsPerWord)) != 0) {
+        throw std::runtime_error("Binary file level layer has bits set past the board.");
+    }
+    return layer;
+}
+}    // namespace
+
+BinaryWriter::BinaryWriter(const std::string& path, std::vector<TSPLevelPtr> levels_)
+    : file(path, std::ios::binary | std::ios::trunc), levels(std::move(levels_)) {
+    if (!file) {
+        throw std::runtime_error("Unable to open file: " + path);
+    }
+    for (const auto& level : levels) {
+        state_words = std::max(state_words, NumWords(static_cast<std::size_t>(level->get_num_cities())));
+    }
+
+    // Levels are written up front, and the header is patched with the state count on close
+    FileHeader header;
+    header.magic = kMagic;
+    header.version = kBinaryFormatVersion;
+    header.byte_order = kByteOrderMarker;
+    header.num_levels = static_cast<uint32_t>(levels.size());
+    header.state_words = static_cast<uint32_t>(state_words);
+    header.states_offset = sizeof(FileHeader);
+    for (const auto& level : levels) {
+        header.states_offset += sizeof(LevelHeader) + 2 * NumWords(level->get_wall_layer().size()) * sizeof(uint64_t);
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));    // NOLINT(*-reinterpret-cast)
+
+    for (std::size_t i = 0; i < levels.size(); ++i) {
+        const auto& level = levels[i];
+        level_indices.emplace(level.get(), static_cast<uint32_t>(i));
+        const LevelHeader level_header{.rows = level->get_rows(),
+                                       .cols = level->get_cols(),
+                                       .agent_idx = level->get_agent_index(),
+                                       .num_cities = level->get_num_cities()};
+        const auto layer_bytes = static_cast<std::streamsize>(level->get_wall_layer().num_words() * sizeof(uint64_t));
+        file.write(reinterpret_cast<const char*>(&level_header), sizeof(level_header));    // NOLINT(*-reinterpret-cast)
+        file.write(reinterpret_cast<const char*>(level->get_wall_layer().data()), layer_bytes);    // NOLINT
+        file.write(reinterpret_cast<const char*>(level->get_city_layer().data()), layer_bytes);    // NOLINT
+    }
+}
+
+BinaryWriter::~BinaryWriter() {
+    try {
+        close();
+    } catch (...) {    // NOLINT(*-empty-catch)
+        // Errors can only be reported by calling close() explicitly
+    }
+}
+
+void BinaryWriter::write(const TSPGameState& state) {
+    write(&state, 1);
+}
+
+void BinaryWriter::write(const TSPGameState* states, std::size_t count) {
+    const std::size_t record_words = kRecordHeaderWords + state_words;
+    record_buffer.assign(count * record_words, 0);
+    for (std::size_t i = 0; i < count; ++i) {
+        const auto& state = states[i];
+        const auto it = level_indices.find(state.get_level().get());
+        if (it == level_indices.end()) {
+            throw std::invalid_argument("State is played on a level which was not given to the writer.");
+        }
+        const RecordHeader record{.level_index = it->second,
+                                  .agent_idx = state.get_agent_index(),
+                                  .start_city_idx = state.get_start_city_index(),
+                                  .reserved = 0,
+                                  .hash = state.get_hash()};
+        uint64_t* record_words_begin = record_buffer.data() + i * record_words;
+        std::memcpy(record_words_begin, &record, sizeof(record));
+        state.get_visited_city_words(record_words_begin + kRecordHeaderWords);
+    }
+    file.write(reinterpret_cast<const char*>(record_buffer.data()),    // NOLINT(*-reinterpret-cast)
+               static_cast<std::streamsize>(record_buffer.size() * sizeof(uint64_t)));
+    num_states += count;
+}
+
+void BinaryWriter::close() {
+    if (!file.is_open()) {
+        return;
+    }
+    file.seekp(static_cast<std::streamoff>(offsetof(FileHeader, num_states)));
+    file.write(reinterpret_cast<const char*>(&num_states), sizeof(num_states));    // NOLINT(*-reinterpret-cast)
+    const bool failed = !file;
+    file.close();
+    if (failed) {
+        throw std::runtime_error("Unable to write binary file.");
+    }
+}
+
+BinaryReader::BinaryReader(const std::string& path) : file(path) {
+    const char* data = file.data();
+    const std::size_t size = file.size();
+    FileHeader header;
+    if (size < sizeof(header)) {
+        throw std::runtime_error("Binary file is too small: " + path);
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if (header.magic != kMagic) {
+        throw std::runtime_error("Not a binary TSP file: " + path);
+    }
+    if (header.version != kBinaryFormatVersion) {
+        throw std::runtime_error("Unsupported binary file version " + std::to_string(header.version) + ": " + path);
+    }
+    if (header.byte_order != kByteOrderMarker) {
+        throw std::runtime_error("Binary file was written with a different byte order: " + path);
+    }
+
+    // Levels
+    std::size_t offset = sizeof(header);
+    levels.reserve(header.num_levels);
+    for (uint32_t i = 0; i < header.num_levels; ++i) {
+        LevelHeader level_header;
+        if (size - offset < sizeof(level_header)) {
+            throw std::runtime_error("Binary file is truncated: " + path);
+        }
+        std::memcpy(&level_header, data + offset, sizeof(level_header));
+        offset += sizeof(level_header);
+        if (level_header.rows < 0 || level_header.cols < 0) {
+            throw std::runtime_error("Binary file has an invalid level size: " + path);
+        }
+        const auto num_cells =
+            static_cast<std::size_t>(level_header.rows) * static_cast<std::size_t>(level_header.cols);
+        const std::size_t layer_bytes = NumWords(num_cells) * sizeof(uint64_t);
+        if ((size - offset) / 2 < layer_bytes) {
+            throw std::runtime_error("Binary file is truncated: " + path);
+        }
+        auto wall_layer = ReadLayer(data + offset, num_cells);
+        auto city_layer = ReadLayer(data + offset + layer_bytes, num_cells);
+        offset += 2 * layer_bytes;
+        try {
+            levels.push_back(std::make_shared<const TSPLevel>(level_header.rows, level_header.cols,
+                                                              level_header.agent_idx, std::move(wall_layer),
+                                                              std::move(city_layer)));
+        } catch (const std::invalid_argument& e) {
+            throw std::runtime_error("Binary file has an invalid level (" + std::string(e.what()) + "): " + path);
+        }
+        if (levels.back()->get_num_cities() != level_header.num_cities) {
+            throw std::runtime_error("Binary file level city count does not match its layer: " + path);
+        }
+    }
+
+    // States
+    if (header.states_offset != offset) {
+        throw std::runtime_error("Binary file states do not follow the levels: " + path);
+    }
+    state_words = header.state_words;
+    const std::size_t record_bytes = (kRecordHeaderWords + state_words) * sizeof(uint64_t);
+    if (header.num_states > (size - offset) / record_bytes) {
+        throw std::runtime_error("Binary file is truncated: " + path);
+    }
+    num_states = static_cast<std::size_t>(header.num_states);
+    // The mapping is page aligned and every section is a whole number of words, so records can be read in place
+    states_begin = reinterpret_cast<const uint64_t*>(data + offset);    // NOLINT(*-reinterpret-cast)
+}
+
+auto BinaryReader::get_record(std::size_t index) const noexcept -> StateRecordView {
+    const uint64_t* record_words = states_begin + index * (kRecordHeaderWords + state_words);
+    RecordHeader record;
+    std::memcpy(&record, record_words, sizeof(record));
+    return {.level_index = record.level_index,
+            .agent_idx = record.agent_idx,
+            .start_city_idx = record.start_city_idx,
+            .hash = record.hash,
+            .visited_city_words = record_words + kRecordHeaderWords};
+}
+
+auto BinaryReader::get_state(std::size_t index) const -> TSPGameState {
+    const auto record = get_record(index);
+    if (record.level_index >= levels.size()) {
+        throw std::runtime_error("State record has an invalid level index.");
+    }
+    const auto& level = levels[record.level_index];
+    if (NumWords(static_cast<std::size_t>(level->get_num_cities())) > state_words) {
+        throw std::runtime_error("State record is too small for its level.");
+    }
+    try {
+        TSPGameState state(level, record.agent_idx, record.start_city_idx, record.visited_city_words);
+        if (state.get_hash() != record.hash) {
+            throw std::runtime_error("State record hash does not match the restored state.");
+        }
+        return state;
+    } catch (const std::invalid_argument& e) {
+        throw std::runtime_error("Invalid state record: " + std::string(e.what()));
+    }
+}
+
+auto BinaryReader::load_all_states() const -> std::vector<TSPGameState> {
+    std::vector<TSPGameState> states;
+    states.reserve(num_states);
+    for (std::size_t i = 0; i < num_states; ++i) {
+        states.push_back(get_state(i));
+    }
+    return states;
+}
+
+void write_levels(const std::string& path, const std::vector<TSPLevelPtr>& levels) {
+    BinaryWriter writer(path, levels);
+    writer.close();
+}
+
+void write_states(const std::string& path, const std::vector<TSPGameState>& states) {
+    std::vector<TSPLevelPtr> levels;
+    std::unordered_set<const TSPLevel*> seen;
+    for (const auto& state : states) {
+        if (seen.insert(state.get_level().get()).second) {
+            levels.push_back(state.get_level());
+        }
+    }
+    BinaryWriter writer(path, std::move(levels));
+    writer.write(states.data(), states.size());
+    writer.close();
+}
+
+auto read_levels(const std::string& path) -> std::vector<TSPLevelPtr> {
+    return BinaryReader(path).get_levels();
+}
+
+auto read_states(const std::string& path) -> std::vector<TSPGameState> {
+    return BinaryReader(path).load_all_states();
+}
+
+}    // namespace tsp
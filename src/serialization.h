@@ -0,0 +1,212 @@
+#ifndef TSP_SERIALIZATION_H_
+#define TSP_SERIALIZATION_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "mapped_file.h"
+#include "tsp_base.h"
+#include "tsp_level.h"
+
+namespace tsp {
+
+/**
+ * Binary file layout (all values in host byte order, which is checked on read, and 8 byte aligned):
+ *   Header       magic "TSPB", version, byte order marker, num_levels, state_words, reserved, num_states,
+ *                states_offset
+ *   Levels       num_levels sections of {int32 rows, cols, agent_idx, num_cities} followed by the wall layer and
+ *                then the city layer, each bit-packed into (rows * cols + 63) / 64 words
+ *   States       num_states fixed-size records of {uint32 level_index, int32 agent_idx, int32 start_city_idx,
+ *                uint32 reserved, uint64 hash} followed by state_words words of visited cities indexed by city id
+ * The format version is bumped whenever the layout or the state hash function changes.
+ */
+constexpr uint32_t kBinaryFormatVersion = 2;
+
+/**
+ * Read-only view of a state record, pointing into the mapped file
+ */
+struct StateRecordView {
+    uint32_t level_index = 0;
+    int agent_idx = -1;
+    int start_city_idx = -1;
+    uint64_t hash = 0;
+    // Bitmask of the visited cities indexed by city id (see TSPLevel::get_city_indices())
+    const uint64_t *visited_city_words = nullptr;
+};
+
+/**
+ * Streaming writer of levels and the states played on them.
+ * The levels are written on construction, and states are appended with fixed-size records.
+ */
+class BinaryWriter {
+public:
+    BinaryWriter() = delete;
+
+    /**
+     * @param path Path of the file to create
+     * @param levels The levels which the written states are played on, matched by pointer
+     * @throws std::runtime_error if the file can't be opened
+     */
+    BinaryWriter(const std::string &path, std::vector<TSPLevelPtr> levels);
+    ~BinaryWriter();
+
+    BinaryWriter(const BinaryWriter &) = delete;
+    BinaryWriter(BinaryWriter &&) = delete;
+    auto operator=(const BinaryWriter &) -> BinaryWriter & = delete;
+    auto operator=(BinaryWriter &&) -> BinaryWriter & = delete;
+
+    /**
+     * Append a state record.
+     * @param state The state to write, whose level must be one of the levels given on construction
+     * @throws std::invalid_argument if the level of the state was not given on construction
+     */
+    void write(const TSPGameState &state);
+
+    /**
+     * Append a batch of state records.
+     * @param states Array of states to write
+     * @param num_states Number of states in the array
+     */
+    void write(const TSPGameState *states, std::size_t num_states);
+
+    /**
+     * Finish writing the file. Called by the destructor if not called explicitly.
+     * @throws std::runtime_error if writing failed
+     */
+    void close();
+
+    /**
+     * Get the number of states written so far
+     * @return Number of states
+     */
+    [[nodiscard]] auto get_num_states() const noexcept -> uint64_t {
+        return num_states;
+    }
+
+private:
+    std::ofstream file;
+    std::vector<TSPLevelPtr> levels;
+    std::unordered_map<const TSPLevel *, uint32_t> level_indices;
+    std::size_t state_words = 0;
+    uint64_t num_states = 0;
+    std::vector<uint64_t> record_buffer;
+};
+
+/**
+ * Read-only view over a binary file written by BinaryWriter.
+ * The file is memory mapped and validated on open, and state records are read in place without copying.
+ */
+class BinaryReader {
+public:
+    BinaryReader() = delete;
+
+    /**
+     * @param path Path to the binary file
+     * @throws std::runtime_error if the file can't be opened or is not a valid binary file of this version
+     */
+    explicit BinaryReader(const std::string &path);
+    ~BinaryReader() = default;
+
+    BinaryReader(const BinaryReader &) = delete;
+    BinaryReader(BinaryReader &&) = delete;
+    auto operator=(const BinaryReader &) -> BinaryReader & = delete;
+    auto operator=(BinaryReader &&) -> BinaryReader & = delete;
+
+    /**
+     * Get the number of levels in the file
+     * @return Number of levels
+     */
+    [[nodiscard]] auto get_num_levels() const noexcept -> std::size_t {
+        return levels.size();
+    }
+
+    /**
+     * Get a level, which is shared by all states restored from the file
+     * @param index The level index
+     * @return The level
+     */
+    [[nodiscard]] auto get_level(std::size_t index) const noexcept -> const TSPLevelPtr & {
+        return levels[index];
+    }
+
+    /**
+     * Get all levels, in file order
+     * @return The levels
+     */
+    [[nodiscard]] auto get_levels() const noexcept -> const std::vector<TSPLevelPtr> & {
+        return levels;
+    }
+
+    /**
+     * Get the number of state records in the file
+     * @return Number of states
+     */
+    [[nodiscard]] auto get_num_states() const noexcept -> std::size_t {
+        return num_states;
+    }
+
+    /**
+     * Get a view of a state record without restoring the state
+     * @param index The state index
+     * @return View of the record, valid for the lifetime of the reader
+     */
+    [[nodiscard]] auto get_record(std::size_t index) const noexcept -> StateRecordView;
+
+    /**
+     * Restore a state.
+     * @param index The state index
+     * @return The state, which compares equal to and has the same hash as the written state
+     * @throws std::runtime_error if the record is not a valid state
+     */
+    [[nodiscard]] auto get_state(std::size_t index) const -> TSPGameState;
+
+    /**
+     * Restore every state.
+     * @return The states, in file order
+     * @throws std::runtime_error if a record is not a valid state
+     */
+    [[nodiscard]] auto load_all_states() const -> std::vector<TSPGameState>;
+
+private:
+    MappedFile file;
+    std::vector<TSPLevelPtr> levels;
+    std::size_t state_words = 0;
+    std::size_t num_states = 0;
+    const uint64_t *states_begin = nullptr;
+};
+
+/**
+ * Write levels without any states, e.g. to store a level set in binary form.
+ * @param path Path of the file to create
+ * @param levels The levels to write
+ */
+void write_levels(const std::string &path, const std::vector<TSPLevelPtr> &levels);
+
+/**
+ * Write states along with the distinct levels they are played on.
+ * @param path Path of the file to create
+ * @param states The states to write
+ */
+void write_states(const std::string &path, const std::vector<TSPGameState> &states);
+
+/**
+ * Read every level of a binary file.
+ * @param path Path to the binary file
+ * @return The levels, in file order
+ */
+[[nodiscard]] auto read_levels(const std::string &path) -> std::vector<TSPLevelPtr>;
+
+/**
+ * Read every state of a binary file.
+ * @param path Path to the binary file
+ * @return The states, in file order
+ */
+[[nodiscard]] auto read_states(const std::string &path) -> std::vector<TSPGameState>;
+
+}    // namespace tsp
+
+#endif    // TSP_SERIALIZATION_H_
@@ -0,0 +1,372 @@
+#include "solver.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "thread_pool.h"
+#include "transposition_table.h"
+
+namespace tsp {
+
+namespace {
+
+// Node references pack the owning thread in the top bits and the node index in the bottom bits
+constexpr int kRefThreadShift = 48;
+constexpr uint64_t kRefIndexMask = (uint64_t{1} << kRefThreadShift) - 1;
+constexpr uint64_t kNoParent = std::numeric_limits<uint64_t>::max();
+constexpr int kMaxThreads = 1 << (64 - kRefThreadShift);
+// Hash bits used to pick the owning thread, kept away from the low bits used to index the transposition table
+constexpr int kOwnerHashShift = 40;
+constexpr int kNoSolution = std::numeric_limits<int>::max();
+
+auto MakeRef(int thread, std::size_t idx) noexcept -> uint64_t {
+    return (static_cast<uint64_t>(thread) << kRefThreadShift) | static_cast<uint64_t>(idx);
+}
+
+auto RefThread(uint64_t ref) noexcept -> std::size_t {
+    return static_cast<std::size_t>(ref >> kRefThreadShift);
+}
+
+auto RefIndex(uint64_t ref) noexcept -> std::size_t {
+    return static_cast<std::size_t>(ref & kRefIndexMask);
+}
+
+// Upper bound on the number of distinct states of a level: agent position x visited cities x start city
+auto StateSpaceBound(const TSPLevel& level) noexcept -> std::size_t {
+    constexpr int kMaxShift = 40;
+    const int num_cities = level.get_num_cities();
+    if (num_cities >= kMaxShift) {
+        return std::numeric_limits<std::size_t>::max();
+    }
+    return static_cast<std::size_t>(level.get_num_cells()) * (std::size_t{1} << num_cities) *
+           static_cast<std::size_t>(num_cities + 1);
+}
+
+struct Node {
+    TSPGameState state;
+    int g;
+    HeuristicInfo h;
+    uint64_t parent;
+    Action action;
+};
+
+struct OpenEntry {
+    double f;
+    int g;
+    std::size_t idx;
+};
+
+// Lowest f first, breaking ties towards deeper nodes
+struct OpenEntryCompare {
+    auto operator()(const OpenEntry& lhs, const OpenEntry& rhs) const noexcept -> bool {
+        return lhs.f > rhs.f || (lhs.f == rhs.f && lhs.g < rhs.g);
+    }
+};
+
+class HashDistributedSearch {
+public:
+    HashDistributedSearch(const TSPGameState& root, const SolverOptions& options, int num_threads)
+        : weight(options.algorithm == SearchAlgorithm::kAStar
+                     ? 1.0
+                     : (options.algorithm == SearchAlgorithm::kWeightedAStar ? options.weight : 0.0)),
+          max_nodes(options.max_nodes),
+          table(2 * std::min(options.max_nodes, StateSpaceBound(*root.get_level()))),
+          active_work(num_threads) {
+        const auto heuristic_type =
+            options.algorithm == SearchAlgorithm::kBFS ? HeuristicType::kZero : options.heuristic;
+        for (int i = 0; i < num_threads; ++i) {
+            workers.push_back(std::make_unique<Worker>(root, heuristic_type));
+        }
+        // Build the shared distance table once up front rather than inside the first expansion
+        if (heuristic_type != HeuristicType::kZero) {
+            (void)root.get_level()->get_distances();
+        }
+        const auto root_h = workers[0]->heuristic.compute(root);
+        if (root_h.value < kUnreachable) {
+            Receive(Owner(root.get_hash()), {root, 0, root_h, kNoParent, Action::kUp});
+        }
+    }
+
+    auto run() -> SolverResult {
+        const auto start_time = std::chrono::steady_clock::now();
+        std::vector<std::thread> threads;
+        for (int i = 1; i < static_cast<int>(workers.size()); ++i) {
+            threads.emplace_back(&HashDistributedSearch::WorkerLoop, this, i);
+        }
+        WorkerLoop(0);
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time;
+
+        SolverResult result;
+        result.seconds = elapsed.count();
+        result.memory_bytes = table.memory_bytes();
+        for (const auto& worker : workers) {
+            result.nodes_expanded += worker->expanded;
+            result.nodes_generated += worker->generated;
+            result.memory_bytes += worker->nodes.capacity() * sizeof(Node);
+        }
+        result.nodes_per_second =
+            result.seconds > 0 ? static_cast<double>(result.nodes_expanded) / result.seconds : 0.0;
+
+        // Solutions found before running out of memory are discarded, as they may not meet the optimality bound
+        if (incumbent_cost.load() != kNoSolution && !out_of_memory.load()) {
+            result.solved = true;
+            for (uint64_t ref = incumbent_ref; ref != kNoParent;) {
+                const auto& node = workers[RefThread(ref)]->nodes[RefIndex(ref)];
+                if (node.parent != kNoParent) {
+                    result.actions.push_back(node.action);
+                }
+                ref = node.parent;
+            }
+            std::reverse(result.actions.begin(), result.actions.end());
+            result.cost = static_cast<int>(result.actions.size());
+        }
+        return result;
+    }
+
+private:
+    struct Message {
+        TSPGameState state;
+        int g;
+        HeuristicInfo h;
+        uint64_t parent;
+        Action action;
+    };
+
+    struct Worker {
+        Worker(const TSPGameState& root, HeuristicType heuristic_type)
+            : heuristic(heuristic_type), children(kNumActions, root) {}
+        std::vector<Node> nodes;
+        std::priority_queue<OpenEntry, std::vector<OpenEntry>, OpenEntryCompare> open;
+        std::mutex inbox_mutex;
+        std::vector<Message> inbox;
+        TSPHeuristic heuristic;
+        std::vector<TSPGameState> children;
+        std::array<Action, kNumActions> actions{};
+        uint64_t expanded = 0;
+        uint64_t generated = 0;
+    };
+
+    [[nodiscard]] auto Owner(uint64_t hash) const noexcept -> int {
+        return static_cast<int>((hash >> kOwnerHashShift) % static_cast<uint64_t>(workers.size()));
+    }
+
+    [[nodiscard]] auto Priority(int g, const HeuristicInfo& h) const noexcept -> double {
+        return g + (weight * h.value);
+    }
+
+    // Nodes whose priority reaches the incumbent cost can't lead to a solution within the bound
+    [[nodiscard]] auto IsPruned(int g, const HeuristicInfo& h) const noexcept -> bool {
+        return h.value >= kUnreachable || Priority(g, h) >= incumbent_cost.load(std::memory_order_relaxed);
+    }
+
+    void OfferSolution(int g, uint64_t ref) {
+        std::lock_guard<std::mutex> lock(incumbent_mutex);
+        if (g < incumbent_cost.load()) {
+            incumbent_cost.store(g);
+            incumbent_ref = ref;
+        }
+    }
+
+    // Add a state owned by this thread, either new or reached with a better cost
+    void Receive(int id, Message&& msg) {
+        auto& worker = *workers[static_cast<std::size_t>(id)];
+        const auto candidate_ref = MakeRef(id, worker.nodes.size());
+        const auto [ref, inserted] = table.find_or_insert(
+            msg.state.get_hash(), candidate_ref,
+            [&](uint64_t stored_ref) { return worker.nodes[RefIndex(stored_ref)].state == msg.state; });
+        const auto idx = RefIndex(ref);
+        if (inserted) {
+            // Store the node before checking the capacity, so that every published ref points at a node
+            worker.nodes.push_back({std::move(msg.state), msg.g, msg.h, msg.parent, msg.action});
+        }
+        if (table.is_full() || table.size() > max_nodes) {
+            out_of_memory.store(true);
+            return;
+        }
+
+        if (!inserted) {
+            auto& node = worker.nodes[idx];
+            if (msg.g >= node.g) {
+                return;
+            }
+            node.g = msg.g;
+            node.parent = msg.parent;
+            node.action = msg.action;
+        }
+
+        const auto& node = worker.nodes[idx];
+        if (node.state.is_solution()) {
+            OfferSolution(node.g, ref);
+            return;
+        }
+        worker.open.push({Priority(node.g, node.h), node.g, idx});
+    }
+
+    void Expand(int id, std::size_t idx) {
+        auto& worker = *workers[static_cast<std::size_t>(id)];
+        ++worker.expanded;
+        // Local children may grow the node list, so copy out what is needed
+        const TSPGameState state = worker.nodes[idx].state;
+        const int child_g = worker.nodes[idx].g + 1;
+        const HeuristicInfo h = worker.nodes[idx].h;
+        const auto parent_ref = MakeRef(id, idx);
+
+        const int num_children = state.expand(worker.children.data(), worker.actions.data());
+        for (int i = 0; i < num_children && !out_of_memory.load(std::memory_order_relaxed); ++i) {
+            ++worker.generated;
+            const auto& child = worker.children[static_cast<std::size_t>(i)];
+            const auto child_h = worker.heuristic.update(h, child);
+            if (IsPruned(child_g, child_h)) {
+                continue;
+            }
+            Message msg{child, child_g, child_h, parent_ref, worker.actions[static_cast<std::size_t>(i)]};
+            const int owner = Owner(child.get_hash());
+            if (owner == id) {
+                Receive(id, std::move(msg));
+            } else {
+                auto& other = *workers[static_cast<std::size_t>(owner)];
+                active_work.fetch_add(1);
+                std::lock_guard<std::mutex> lock(other.inbox_mutex);
+                other.inbox.push_back(std::move(msg));
+            }
+        }
+    }
+
+    // Pop the best node which still needs expanding, or return false if there is none
+    auto PopOpen(Worker& worker, std::size_t& idx) -> bool {
+        while (!worker.open.empty()) {
+            const auto entry = worker.open.top();
+            worker.open.pop();
+            const auto& node = worker.nodes[entry.idx];
+            if (entry.g > node.g) {
+                continue;    // Stale entry, node was reopened with a better cost
+            }
+            if (IsPruned(node.g, node.h)) {
+                // Open is ordered by priority, so everything left is pruned as well
+                worker.open = {};
+                return false;
+            }
+            idx = entry.idx;
+            return true;
+        }
+        return false;
+    }
+
+    // Each thread counts towards active_work while busy, as does each message in flight. Once it reaches 0 no thread
+    // has work and none can be created, so the search is done.
+    void WorkerLoop(int id) {
+        auto& worker = *workers[static_cast<std::size_t>(id)];
+        bool active = true;
+        std::vector<Message> batch;
+        while (!out_of_memory.load(std::memory_order_relaxed)) {
+            {
+                std::lock_guard<std::mutex> lock(worker.inbox_mutex);
+                batch.swap(worker.inbox);
+            }
+            if (!batch.empty()) {
+                if (!active) {
+                    active_work.fetch_add(1);
+                    active = true;
+                }
+                for (auto& msg : batch) {
+                    if (out_of_memory.load(std::memory_order_relaxed)) {
+                        break;
+                    }
+                    Receive(id, std::move(msg));
+                }
+                active_work.fetch_sub(static_cast<int64_t>(batch.size()));
+                batch.clear();
+            }
+
+            std::size_t idx = 0;
+            if (PopOpen(worker, idx)) {
+                if (!active) {
+                    active_work.fetch_add(1);
+                    active = true;
+                }
+                Expand(id, idx);
+                continue;
+            }
+
+            if (active) {
+                active_work.fetch_sub(1);
+                active = false;
+            }
+            if (active_work.load() == 0) {
+                break;
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    double weight;
+    std::size_t max_nodes;
+    std::vector<std::unique_ptr<Worker>> workers;
+    TranspositionTable table;
+    std::atomic<int64_t> active_work;
+    std::atomic<int> incumbent_cost{kNoSolution};
+    std::mutex incumbent_mutex;
+    uint64_t incumbent_ref = kNoParent;
+    std::atomic<bool> out_of_memory{false};
+};
+
+}    // namespace
+
+auto solve(const TSPGameState& state, const SolverOptions& options) -> SolverResult {
+    int num_threads = options.num_threads;
+    if (num_threads <= 0) {
+        num_threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    }
+    num_threads = std::min(num_threads, kMaxThreads);
+    HashDistributedSearch search(state, options, num_threads);
+    return search.run();
+}
+
+auto solve(const std::string& board_str, const SolverOptions& options) -> SolverResult {
+    return solve(TSPGameState(board_str), options);
+}
+
+auto solve_levels(const std::vector<std::string>& board_strs, const SolverOptions& options)
+    -> std::vector<SolverResult> {
+    std::vector<TSPGameState> states;
+    states.reserve(board_strs.size());
+    for (const auto& board_str : board_strs) {
+        states.emplace_back(board_str);
+    }
+
+    std::vector<SolverResult> results(board_strs.size());
+    auto single_options = options;
+    single_options.num_threads = 1;
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    ThreadPool pool(options.num_threads);
+    pool.parallel_for(static_cast<int>(board_strs.size()), [&](int begin, int end) {
+        try {
+            for (int i = begin; i < end; ++i) {
+                results[static_cast<std::size_t>(i)] = solve(states[static_cast<std::size_t>(i)], single_options);
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            error = std::current_exception();
+        }
+    });
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    return results;
+}
+
+}    // namespace tsp
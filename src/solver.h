@@ -0,0 +1,75 @@
+#ifndef TSP_SOLVER_H_
+#define TSP_SOLVER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "definitions.h"
+#include "heuristic.h"
+#include "tsp_base.h"
+
+namespace tsp {
+
+enum class SearchAlgorithm : int {
+    kAStar = 0,            // Optimal, f = g + h
+    kWeightedAStar = 1,    // Cost within weight * optimal, f = g + weight * h
+    kBFS = 2,              // Optimal breadth first search (no heuristic), f = g
+};
+
+struct SolverOptions {
+    SearchAlgorithm algorithm = SearchAlgorithm::kAStar;
+    // Heuristic weight used by kWeightedAStar
+    double weight = 2.0;
+    HeuristicType heuristic = HeuristicType::kMax;
+    // Number of search threads, or <= 0 to use the hardware concurrency
+    int num_threads = 1;
+    // Maximum number of distinct states stored, the search fails once exceeded
+    std::size_t max_nodes = std::size_t{1} << 22;
+};
+
+struct SolverResult {
+    bool solved = false;
+    // Number of moves in the solution, or -1 if not solved
+    int cost = -1;
+    std::vector<Action> actions;
+    uint64_t nodes_expanded = 0;
+    uint64_t nodes_generated = 0;
+    double seconds = 0;
+    double nodes_per_second = 0;
+    std::size_t memory_bytes = 0;
+};
+
+/**
+ * Find a sequence of actions from the state to a solution state using hash distributed best first search.
+ * Each thread owns the states whose hash maps to it, and children are sent to their owner's queue. Duplicate
+ * detection uses a shared lock-free transposition table keyed on get_hash() and verified with full state equality.
+ * @param state The state to search from
+ * @param options The search options
+ * @return The solution and search statistics
+ */
+[[nodiscard]] auto solve(const TSPGameState &state, const SolverOptions &options = SolverOptions()) -> SolverResult;
+
+/**
+ * Solve the initial state of a board string.
+ * @param board_str The board string
+ * @param options The search options
+ * @return The solution and search statistics
+ */
+[[nodiscard]] auto solve(const std::string &board_str, const SolverOptions &options = SolverOptions()) -> SolverResult;
+
+/**
+ * Solve a set of boards, distributing whole boards across threads with each board searched on a single thread.
+ * This gives better throughput than parallelizing each search when labelling many levels.
+ * @param board_strs The board strings
+ * @param options The search options, where num_threads is the number of boards solved at once
+ * @return The result for each board, in input order
+ * @throws The first exception raised by a search (e.g. std::bad_alloc), after every thread has finished
+ */
+[[nodiscard]] auto solve_levels(const std::vector<std::string> &board_strs,
+                                const SolverOptions &options = SolverOptions()) -> std::vector<SolverResult>;
+
+}    // namespace tsp
+
+#endif    // TSP_SOLVER_H_
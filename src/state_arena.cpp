@@ -0,0 +1,152 @@
+#include "state_arena.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace tsp {
+
+namespace {
+// City ids are stored offset by 1 above the action and checkpoint bits of a node
+constexpr int kMaxCities = (1 << 13) - 1;
+
+// Per thread buffer for the actions replayed by rematerialize()
+auto ReplayScratch() -> std::vector<Action>& {
+    thread_local std::vector<Action> actions;
+    actions.clear();
+    return actions;
+}
+}    // namespace
+
+StateArena::StateArena(const TSPGameState& root_, int checkpoint_interval_)
+    : root(root_),
+      checkpoint_interval(checkpoint_interval_),
+      num_city_words(static_cast<std::size_t>(root_.get_level()->get_num_cities() + 63) / 64) {
+    if (checkpoint_interval <= 0) {
+        throw std::invalid_argument("Checkpoint interval must be positive.");
+    }
+    if (root.get_level()->get_num_cities() > kMaxCities) {
+        throw std::invalid_argument("State arenas support at most " + std::to_string(kMaxCities) + " cities.");
+    }
+    clear();
+}
+
+auto StateArena::add_child(NodeIndex parent, Action action, const TSPGameState& child) -> NodeIndex {
+    if (num_nodes >= static_cast<std::size_t>(kNoParent)) {
+        throw std::length_error("State arena is full.");
+    }
+    const int new_city = child.get_reward_signal() != 0 ? child.get_level()->get_city_id(child.get_agent_index()) : -1;
+    // The child is checkpointed if it is the checkpoint interval of moves below the nearest checkpoint or the root
+    int steps = 1;
+    for (NodeIndex current = parent; current != kRootIndex && !IsCheckpoint(current); current = get_parent(current)) {
+        ++steps;
+    }
+    const bool checkpoint = steps == checkpoint_interval;
+
+    const int action_city = (static_cast<int>(action) & kActionMask) | (checkpoint ? kCheckpointFlag : 0) |
+                            ((new_city + 1) << kCityShift);
+    const int depth = checkpoint ? get_g(parent) + 1 : 0;
+    const auto index = Allocate(child.get_hash(), parent, static_cast<uint16_t>(action_city));
+    if (checkpoint) {
+        checkpoint_nodes.push_back(index);
+        checkpoint_depths.push_back(depth);
+        checkpoint_agents.push_back(child.get_agent_index());
+        checkpoint_start_cities.push_back(child.get_start_city_index());
+        checkpoint_city_words.resize(checkpoint_city_words.size() + num_city_words);
+        child.get_visited_city_words(checkpoint_city_words.data() + checkpoint_city_words.size() - num_city_words);
+    }
+    return index;
+}
+
+auto StateArena::rematerialize(NodeIndex index) const -> TSPGameState {
+    if (index == kRootIndex) {
+        return root;
+    }
+    // Always replay at least the node's own action, so that the reward signal is restored as well
+    auto& actions = ReplayScratch();
+    NodeIndex current = index;
+    do {
+        actions.push_back(get_action(current));
+        current = get_parent(current);
+    } while (current != kRootIndex && !IsCheckpoint(current));
+
+    TSPGameState state = current == kRootIndex ? root : RestoreCheckpoint(current);
+    for (auto it = actions.rbegin(); it != actions.rend(); ++it) {
+        state.apply_action(*it);
+    }
+    return state;
+}
+
+auto StateArena::get_actions(NodeIndex index) const -> std::vector<Action> {
+    std::vector<Action> actions;
+    for (NodeIndex current = index; current != kRootIndex; current = get_parent(current)) {
+        actions.push_back(get_action(current));
+    }
+    std::reverse(actions.begin(), actions.end());
+    return actions;
+}
+
+auto StateArena::get_g(NodeIndex index) const -> int {
+    int steps = 0;
+    NodeIndex current = index;
+    while (current != kRootIndex && !IsCheckpoint(current)) {
+        current = get_parent(current);
+        ++steps;
+    }
+    return current == kRootIndex ? steps : steps + checkpoint_depths[FindCheckpoint(current)];
+}
+
+void StateArena::clear() {
+    pages.clear();
+    checkpoint_nodes.clear();
+    checkpoint_depths.clear();
+    checkpoint_agents.clear();
+    checkpoint_start_cities.clear();
+    checkpoint_city_words.clear();
+    num_nodes = 0;
+    (void)Allocate(root.get_hash(), kNoParent, 0);
+}
+
+auto StateArena::memory_bytes() const noexcept -> std::size_t {
+    return (pages.size() * kPageSize * kNodeBytes) + (checkpoint_nodes.capacity() * sizeof(NodeIndex)) +
+           (checkpoint_depths.capacity() * sizeof(int)) + (checkpoint_agents.capacity() * sizeof(int)) +
+           (checkpoint_start_cities.capacity() * sizeof(int)) + (checkpoint_city_words.capacity() * sizeof(uint64_t));
+}
+
+// ---------------------------------------------------------------------------
+
+auto StateArena::IsCheckpoint(NodeIndex index) const noexcept -> bool {
+    return (GetActionCity(index) & kCheckpointFlag) != 0;
+}
+
+auto StateArena::FindCheckpoint(NodeIndex index) const noexcept -> std::size_t {
+    // Nodes are checkpointed in the order they are added, so the list is sorted
+    const auto it = std::lower_bound(checkpoint_nodes.begin(), checkpoint_nodes.end(), index);
+    return static_cast<std::size_t>(it - checkpoint_nodes.begin());
+}
+
+auto StateArena::RestoreCheckpoint(NodeIndex index) const -> TSPGameState {
+    const std::size_t slot = FindCheckpoint(index);
+    return {root.get_level(), checkpoint_agents[slot], checkpoint_start_cities[slot],
+            checkpoint_city_words.data() + (slot * num_city_words)};
+}
+
+auto StateArena::Allocate(uint64_t hash, NodeIndex parent, uint16_t action_city) -> NodeIndex {
+    if ((num_nodes & (kPageSize - 1)) == 0) {
+        // Nodes are written before being read, so pages are left uninitialized
+        Page page;
+        page.hashes.reset(new uint64_t[kPageSize]);
+        page.parents.reset(new NodeIndex[kPageSize]);
+        page.action_cities.reset(new uint16_t[kPageSize]);
+        pages.push_back(std::move(page));
+    }
+    const auto slot = num_nodes & (kPageSize - 1);
+    auto& page = pages.back();
+    page.hashes[slot] = hash;
+    page.parents[slot] = parent;
+    page.action_cities[slot] = action_city;
+    return static_cast<NodeIndex>(num_nodes++);
+}
+
+}    // namespace tsp
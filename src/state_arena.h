@@ -0,0 +1,163 @@
+#ifndef TSP_STATE_ARENA_H_
+#define TSP_STATE_ARENA_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "definitions.h"
+#include "tsp_base.h"
+
+namespace tsp {
+
+/**
+ * Append-only storage of search tree nodes.
+ * Nodes are bump allocated in large pages and only hold their hash, parent, action and newly visited city, with the
+ * hashes kept in a separate array so that each node takes 14 bytes. Full states are rematerialized on demand by
+ * replaying actions from the nearest checkpointed ancestor, where the visited cities and depth of every node at a
+ * multiple of the checkpoint interval deep are kept. The depth of other nodes is rebuilt from their parent chain. All
+ * nodes are freed at once by clear() or when the arena is destroyed.
+ * The arena is not thread safe.
+ */
+class StateArena {
+public:
+    using NodeIndex = uint32_t;
+    static constexpr NodeIndex kRootIndex = 0;
+    static constexpr NodeIndex kNoParent = std::numeric_limits<NodeIndex>::max();
+    static constexpr int kDefaultCheckpointInterval = 32;
+    static constexpr int kPageShift = 16;
+    static constexpr std::size_t kPageSize = std::size_t{1} << kPageShift;
+
+    StateArena() = delete;
+
+    /**
+     * Create an arena holding only the root node.
+     * @param root The state at the root of the tree
+     * @param checkpoint_interval Depth between checkpoints, trading memory for the replay length of rematerialize()
+     * @throws std::invalid_argument if the checkpoint interval is not positive or the level has too many cities
+     */
+    StateArena(const TSPGameState &root, int checkpoint_interval = kDefaultCheckpointInterval);
+
+    /**
+     * Add a child node
+     * @param parent The parent node
+     * @param action The action applied to the parent state
+     * @param child The resulting state, i.e. the parent state after applying the action (e.g. from expand())
+     * @return The index of the child node
+     * @throws std::length_error if the arena is full
+     */
+    auto add_child(NodeIndex parent, Action action, const TSPGameState &child) -> NodeIndex;
+
+    /**
+     * Rebuild the full state of a node by replaying at most the checkpoint interval of actions.
+     * The reward signal matches that of the state the node was added with.
+     * @param index The node
+     * @return The state
+     */
+    [[nodiscard]] auto rematerialize(NodeIndex index) const -> TSPGameState;
+
+    /**
+     * Get the actions from the root to a node
+     * @param index The node
+     * @return The actions in order
+     */
+    [[nodiscard]] auto get_actions(NodeIndex index) const -> std::vector<Action>;
+
+    /**
+     * Free every node apart from the root in one shot
+     */
+    void clear();
+
+    [[nodiscard]] auto get_parent(NodeIndex index) const noexcept -> NodeIndex {
+        return pages[index >> kPageShift].parents[index & (kPageSize - 1)];
+    }
+
+    [[nodiscard]] auto get_action(NodeIndex index) const noexcept -> Action {
+        return static_cast<Action>(GetActionCity(index) & kActionMask);
+    }
+
+    /**
+     * Get the city newly visited by the action leading to a node
+     * @param index The node
+     * @return The city id (see TSPLevel::get_city_indices()), or -1 if no city was visited
+     */
+    [[nodiscard]] auto get_new_city(NodeIndex index) const noexcept -> int {
+        return static_cast<int>(GetActionCity(index) >> kCityShift) - 1;
+    }
+
+    [[nodiscard]] auto get_hash(NodeIndex index) const noexcept -> uint64_t {
+        return pages[index >> kPageShift].hashes[index & (kPageSize - 1)];
+    }
+
+    /**
+     * Get the depth of a node, found by walking at most the checkpoint interval of parents
+     * @param index The node
+     * @return Number of actions from the root
+     */
+    [[nodiscard]] auto get_g(NodeIndex index) const -> int;
+
+    /**
+     * Get the number of nodes, including the root
+     * @return Number of nodes
+     */
+    [[nodiscard]] auto size() const noexcept -> std::size_t {
+        return num_nodes;
+    }
+
+    /**
+     * Get the memory held by the nodes and checkpoints
+     * @return Number of bytes
+     */
+    [[nodiscard]] auto memory_bytes() const noexcept -> std::size_t;
+
+    [[nodiscard]] auto get_root() const noexcept -> const TSPGameState & {
+        return root;
+    }
+
+    [[nodiscard]] auto get_checkpoint_interval() const noexcept -> int {
+        return checkpoint_interval;
+    }
+
+private:
+    // Node fields are stored in separate arrays, as a hash next to a parent and action would be padded to 16 bytes
+    struct Page {
+        std::unique_ptr<uint64_t[]> hashes;
+        std::unique_ptr<NodeIndex[]> parents;
+        // Action in the low 2 bits, then the checkpoint flag, then the id + 1 of the city visited by the action (0 if
+        // none) in the rest
+        std::unique_ptr<uint16_t[]> action_cities;
+    };
+    static constexpr std::size_t kNodeBytes = sizeof(uint64_t) + sizeof(NodeIndex) + sizeof(uint16_t);
+    static_assert(kNodeBytes < 16, "Arena nodes should take less than 16 bytes");
+
+    static constexpr int kActionBits = 2;
+    static constexpr uint16_t kActionMask = (1 << kActionBits) - 1;
+    static constexpr uint16_t kCheckpointFlag = 1 << kActionBits;
+    static constexpr int kCityShift = kActionBits + 1;
+
+    [[nodiscard]] auto GetActionCity(NodeIndex index) const noexcept -> uint16_t {
+        return pages[index >> kPageShift].action_cities[index & (kPageSize - 1)];
+    }
+    [[nodiscard]] auto IsCheckpoint(NodeIndex index) const noexcept -> bool;
+    [[nodiscard]] auto FindCheckpoint(NodeIndex index) const noexcept -> std::size_t;
+    [[nodiscard]] auto RestoreCheckpoint(NodeIndex index) const -> TSPGameState;
+    auto Allocate(uint64_t hash, NodeIndex parent, uint16_t action_city) -> NodeIndex;
+
+    TSPGameState root;
+    int checkpoint_interval;
+    std::size_t num_city_words;
+    std::size_t num_nodes = 0;
+    std::vector<Page> pages;
+    // Checkpointed nodes in increasing index order, with the depth, agent, start city and visited city words of each
+    std::vector<NodeIndex> checkpoint_nodes;
+    std::vector<int> checkpoint_depths;
+    std::vector<int> checkpoint_agents;
+    std::vector<int> checkpoint_start_cities;
+    std::vector<uint64_t> checkpoint_city_words;
+};
+
+}    // namespace tsp
+
+#endif    // TSP_STATE_ARENA_H_
@@ -0,0 +1,141 @@
+#include "symmetry.h"
+
+#include <array>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+#include "zobrist.h"
+
+namespace tsp {
+
+namespace {
+// Row and column offsets of each action, in Action order
+constexpr std::array<std::pair<int, int>, kNumActions> kActionDirections{{{-1, 0}, {0, 1}, {1, 0}, {0, -1}}};
+
+// Transform a (row, col) position on a rows x cols board
+auto TransformCoords(Symmetry symmetry, int rows, int cols, int row, int col) noexcept -> std::pair<int, int> {
+    switch (symmetry) {
+        case Symmetry::kRotate180:
+            return {rows - 1 - row, cols - 1 - col};
+        case Symmetry::kFlipVertical:
+            return {rows - 1 - row, col};
+        case Symmetry::kFlipHorizontal:
+            return {row, cols - 1 - col};
+        case Symmetry::kTranspose:
+            return {col, row};
+        case Symmetry::kAntiTranspose:
+            return {cols - 1 - col, rows - 1 - row};
+        case Symmetry::kRotate90:
+            return {col, rows - 1 - row};
+        case Symmetry::kRotate270:
+            return {cols - 1 - col, row};
+        default:
+            return {row, col};
+    }
+}
+
+template <typename T>
+void AugmentObservations(const T* obs, int batch_size, int num_channels, int rows, int cols, T* out) {
+    const auto table = SymmetryTable::get(rows, cols);
+    const int num_symmetries = table->get_num_symmetries();
+    const auto num_cells = static_cast<std::size_t>(rows) * static_cast<std::size_t>(cols);
+    const std::size_t obs_size = static_cast<std::size_t>(num_channels) * num_cells;
+    for (std::size_t b = 0; b < static_cast<std::size_t>(batch_size); ++b) {
+        const T* src = obs + (b * obs_size);
+        for (int s = 0; s < num_symmetries; ++s) {
+            const auto symmetry = static_cast<Symmetry>(s);
+            T* dst = out + (((b * static_cast<std::size_t>(num_symmetries)) + static_cast<std::size_t>(s)) * obs_size);
+            for (std::size_t ch = 0; ch < static_cast<std::size_t>(num_channels); ++ch) {
+                const T* src_plane = src + (ch * num_cells);
+                T* dst_plane = dst + (ch * num_cells);
+                for (std::size_t i = 0; i < num_cells; ++i) {
+                    dst_plane[table->get_cell(symmetry, static_cast<int>(i))] = src_plane[i];
+                }
+            }
+        }
+    }
+}
+}    // namespace
+
+auto transform_action(Symmetry symmetry, Action action) noexcept -> Action {
+    // Directions transform by the linear part of the symmetry, which is the transform of a 1x1 board
+    const auto [row_offset, col_offset] = kActionDirections[static_cast<std::size_t>(action)];
+    const auto direction = TransformCoords(symmetry, 1, 1, row_offset, col_offset);
+    for (int a = 0; a < kNumActions; ++a) {
+        if (kActionDirections[static_cast<std::size_t>(a)] == direction) {
+            return static_cast<Action>(a);
+        }
+    }
+    return action;
+}
+
+SymmetryTable::SymmetryTable(int rows, int cols)
+    : num_symmetries(tsp::get_num_symmetries(rows, cols)),
+      num_cells(static_cast<std::size_t>(rows) * static_cast<std::size_t>(cols)) {
+    const auto zobrist = ZobristTable::get(static_cast<int>(num_cells));
+    const auto num_syms = static_cast<std::size_t>(num_symmetries);
+    cells.resize(num_syms * num_cells);
+    keys.resize(num_syms * kNumElements * num_cells);
+    for (std::size_t s = 0; s < num_syms; ++s) {
+        const auto symmetry = static_cast<Symmetry>(s);
+        // Symmetries which swap rows and columns only exist for square boards, so the shape is unchanged
+        for (int row = 0; row < rows; ++row) {
+            for (int col = 0; col < cols; ++col) {
+                const auto [new_row, new_col] = TransformCoords(symmetry, rows, cols, row, col);
+                cells[(s * num_cells) + static_cast<std::size_t>((row * cols) + col)] = (new_row * cols) + new_col;
+            }
+        }
+        for (std::size_t el = 0; el < kNumElements; ++el) {
+            for (std::size_t i = 0; i < num_cells; ++i) {
+                keys[(((s * kNumElements) + el) * num_cells) + i] =
+                    zobrist->get_key(static_cast<Element>(el), cells[(s * num_cells) + i]);
+            }
+        }
+    }
+}
+
+auto SymmetryTable::get(int rows, int cols) -> std::shared_ptr<const SymmetryTable> {
+    static std::mutex mutex;
+    static std::unordered_map<uint64_t, std::weak_ptr<const SymmetryTable>> tables;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& entry = tables[(static_cast<uint64_t>(static_cast<uint32_t>(rows)) << 32) | static_cast<uint32_t>(cols)];
+    auto table = entry.lock();
+    if (!table) {
+        table = std::make_shared<const SymmetryTable>(rows, cols);
+        entry = table;
+    }
+    return table;
+}
+
+void augment_observations(const float* obs, int batch_size, int num_channels, int rows, int cols, float* out) {
+    AugmentObservations(obs, batch_size, num_channels, rows, cols, out);
+}
+
+void augment_observations(const uint8_t* obs, int batch_size, int num_channels, int rows, int cols, uint8_t* out) {
+    AugmentObservations(obs, batch_size, num_channels, rows, cols, out);
+}
+
+void augment_actions(const Action* actions, int batch_size, int num_symmetries, Action* out) {
+    for (std::size_t b = 0; b < static_cast<std::size_t>(batch_size); ++b) {
+        for (int s = 0; s < num_symmetries; ++s) {
+            out[(b * static_cast<std::size_t>(num_symmetries)) + static_cast<std::size_t>(s)] =
+                transform_action(static_cast<Symmetry>(s), actions[b]);
+        }
+    }
+}
+
+void augment_policies(const float* policies, int batch_size, int num_symmetries, float* out) {
+    for (std::size_t b = 0; b < static_cast<std::size_t>(batch_size); ++b) {
+        for (int s = 0; s < num_symmetries; ++s) {
+            float* dst = out + (((b * static_cast<std::size_t>(num_symmetries)) + static_cast<std::size_t>(s)) *
+                                static_cast<std::size_t>(kNumActions));
+            for (int a = 0; a < kNumActions; ++a) {
+                const auto new_action = transform_action(static_cast<Symmetry>(s), static_cast<Action>(a));
+                dst[static_cast<std::size_t>(new_action)] = policies[(b * kNumActions) + static_cast<std::size_t>(a)];
+            }
+        }
+    }
+}
+
+}    // namespace tsp
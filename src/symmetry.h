@@ -0,0 +1,149 @@
+#ifndef TSP_SYMMETRY_H_
+#define TSP_SYMMETRY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "definitions.h"
+
+// Set to 1 to track the hash of every symmetric variant of each state, so that TSPGameState::get_canonical_hash() is
+// a constant time lookup instead of a pass over the cities.
+#ifndef TSP_CANONICAL_HASH
+#define TSP_CANONICAL_HASH 0
+#endif
+
+namespace tsp {
+
+constexpr bool kCanonicalHash = TSP_CANONICAL_HASH != 0;
+
+// Rotations and reflections of a board (the dihedral group D4).
+// The first 4 keep the board shape, so they are the only symmetries of non-square boards.
+enum class Symmetry : int {
+    kIdentity = 0,
+    kRotate180 = 1,
+    kFlipVertical = 2,      // Mirror top and bottom
+    kFlipHorizontal = 3,    // Mirror left and right
+    kTranspose = 4,         // Mirror along the main diagonal
+    kAntiTranspose = 5,     // Mirror along the anti diagonal
+    kRotate90 = 6,          // Clockwise
+    kRotate270 = 7,         // Clockwise
+};
+constexpr int kNumSymmetries = 8;
+
+/**
+ * Get the number of symmetries of a board shape
+ * @param rows Number of rows of the board
+ * @param cols Number of columns of the board
+ * @return 8 for square boards, otherwise 4
+ */
+[[nodiscard]] constexpr auto get_num_symmetries(int rows, int cols) noexcept -> int {
+    return rows == cols ? kNumSymmetries : kNumSymmetries / 2;
+}
+
+/**
+ * Get the action which moves in the same direction on the transformed board
+ * @param symmetry The symmetry
+ * @param action The action on the original board
+ * @return The action on the transformed board
+ */
+[[nodiscard]] auto transform_action(Symmetry symmetry, Action action) noexcept -> Action;
+
+/**
+ * Cell permutations and Zobrist keys of each symmetry of a board shape.
+ * Tables only depend on the board shape, so one table is shared by every level of the same shape.
+ */
+class SymmetryTable {
+public:
+    SymmetryTable() = delete;
+
+    /**
+     * Build the table for a board shape. Prefer get() to share tables between levels.
+     * @param rows Number of rows of the board
+     * @param cols Number of columns of the board
+     */
+    SymmetryTable(int rows, int cols);
+
+    /**
+     * Get the shared table for a board shape, building it if no level of that shape is alive.
+     * @param rows Number of rows of the board
+     * @param cols Number of columns of the board
+     * @return The table
+     */
+    [[nodiscard]] static auto get(int rows, int cols) -> std::shared_ptr<const SymmetryTable>;
+
+    /**
+     * Get the number of symmetries of the board shape, see get_num_symmetries()
+     * @return Number of symmetries
+     */
+    [[nodiscard]] auto get_num_symmetries() const noexcept -> int {
+        return num_symmetries;
+    }
+
+    /**
+     * Get the index a cell is moved to by a symmetry
+     * @param symmetry The symmetry, which must be less than get_num_symmetries()
+     * @param index The cell index
+     * @return The transformed cell index
+     */
+    [[nodiscard]] auto get_cell(Symmetry symmetry, int index) const noexcept -> int {
+        return cells[(static_cast<std::size_t>(symmetry) * num_cells) + static_cast<std::size_t>(index)];
+    }
+
+    /**
+     * Get the Zobrist key of an element at the cell a symmetry moves it to, i.e. the key the element contributes to
+     * the hash of the transformed state
+     * @param symmetry The symmetry, which must be less than get_num_symmetries()
+     * @param el The element
+     * @param index The cell index on the original board
+     * @return The key
+     */
+    [[nodiscard]] auto get_key(Symmetry symmetry, Element el, int index) const noexcept -> uint64_t {
+        const std::size_t table = (static_cast<std::size_t>(symmetry) * kNumElements) + static_cast<std::size_t>(el);
+        return keys[(table * num_cells) + static_cast<std::size_t>(index)];
+    }
+
+private:
+    int num_symmetries;
+    std::size_t num_cells;
+    std::vector<int> cells;
+    std::vector<uint64_t> keys;
+};
+
+/**
+ * Write every symmetric variant of a batch of observations by permuting the cells of each channel, so that the states
+ * don't need to be encoded again.
+ * @param obs Batch of observations, each of num_channels planes of rows * cols cells (e.g. from get_observation())
+ * @param batch_size Number of observations
+ * @param num_channels Number of channels of each observation
+ * @param rows Number of rows of the board
+ * @param cols Number of columns of the board
+ * @param out Output of batch_size * get_num_symmetries(rows, cols) observations, where variant s of observation b is
+ * at index b * get_num_symmetries(rows, cols) + s
+ */
+void augment_observations(const float *obs, int batch_size, int num_channels, int rows, int cols, float *out);
+void augment_observations(const uint8_t *obs, int batch_size, int num_channels, int rows, int cols, uint8_t *out);
+
+/**
+ * Write every symmetric variant of a batch of actions, in the same order as augment_observations()
+ * @param actions Batch of actions
+ * @param batch_size Number of actions
+ * @param num_symmetries Number of symmetries of the board shape, see get_num_symmetries()
+ * @param out Output of batch_size * num_symmetries actions
+ */
+void augment_actions(const Action *actions, int batch_size, int num_symmetries, Action *out);
+
+/**
+ * Write every symmetric variant of a batch of action distributions (e.g. policy targets), in the same order as
+ * augment_observations()
+ * @param policies Batch of kNumActions values per distribution, indexed by action
+ * @param batch_size Number of distributions
+ * @param num_symmetries Number of symmetries of the board shape, see get_num_symmetries()
+ * @param out Output of batch_size * num_symmetries * kNumActions values
+ */
+void augment_policies(const float *policies, int batch_size, int num_symmetries, float *out);
+
+}    // namespace tsp
+
+#endif    // TSP_SYMMETRY_H_
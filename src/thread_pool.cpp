@@ -0,0 +1,92 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+
+namespace tsp {
+
+namespace {
+// Number of chunks each thread gets on average, so that uneven work still balances
+constexpr int kChunksPerThread = 4;
+}    // namespace
+
+ThreadPool::ThreadPool(int num_threads) {
+    if (num_threads <= 0) {
+        num_threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    }
+    workers.reserve(static_cast<std::size_t>(num_threads - 1));
+    for (int i = 0; i < num_threads - 1; ++i) {
+        workers.emplace_back(&ThreadPool::WorkerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    work_cv.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+auto ThreadPool::size() const noexcept -> int {
+    return static_cast<int>(workers.size()) + 1;
+}
+
+void ThreadPool::parallel_for(int count, const std::function<void(int, int)>& func) {
+    if (count <= 0) {
+        return;
+    }
+    if (workers.empty() || count == 1) {
+        func(0, count);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = &func;
+        job_count = count;
+        chunk_size = std::max(1, (count + (size() * kChunksPerThread) - 1) / (size() * kChunksPerThread));
+        next_chunk.store(0, std::memory_order_relaxed);
+        active_workers = static_cast<int>(workers.size());
+        ++generation;
+    }
+    work_cv.notify_all();
+    RunChunks();
+    std::unique_lock<std::mutex> lock(mutex);
+    done_cv.wait(lock, [this]() { return active_workers == 0; });
+    job = nullptr;
+}
+
+void ThreadPool::WorkerLoop() {
+    uint64_t seen_generation = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            work_cv.wait(lock, [&]() { return stop || generation != seen_generation; });
+            if (stop) {
+                return;
+            }
+            seen_generation = generation;
+        }
+        RunChunks();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--active_workers == 0) {
+                done_cv.notify_one();
+            }
+        }
+    }
+}
+
+void ThreadPool::RunChunks() {
+    while (true) {
+        const int begin = next_chunk.fetch_add(1, std::memory_order_relaxed) * chunk_size;
+        if (begin >= job_count) {
+            return;
+        }
+        (*job)(begin, std::min(job_count, begin + chunk_size));
+    }
+}
+
+}    // namespace tsp
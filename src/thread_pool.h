@@ -0,0 +1,64 @@
+#ifndef TSP_THREAD_POOL_H_
+#define TSP_THREAD_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace tsp {
+
+/**
+ * Fixed size pool of worker threads for data parallel loops.
+ * The calling thread takes part in each loop, so a pool of size 1 runs everything inline without spawning threads.
+ */
+class ThreadPool {
+public:
+    /**
+     * @param num_threads Total number of threads (including the caller), or <= 0 to use the hardware concurrency
+     */
+    explicit ThreadPool(int num_threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool(ThreadPool &&) = delete;
+    auto operator=(const ThreadPool &) -> ThreadPool & = delete;
+    auto operator=(ThreadPool &&) -> ThreadPool & = delete;
+
+    /**
+     * Get the number of threads used by the pool, including the caller
+     * @return Number of threads
+     */
+    [[nodiscard]] auto size() const noexcept -> int;
+
+    /**
+     * Split [0, count) into chunks and call func(begin, end) on each chunk across the pool, blocking until all chunks
+     * are complete. func must not throw. Only one thread may call parallel_for on a pool at a time.
+     * @param count Number of items to process
+     * @param func Callable which processes the items in [begin, end)
+     */
+    void parallel_for(int count, const std::function<void(int, int)> &func);
+
+private:
+    void WorkerLoop();
+    void RunChunks();
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable work_cv;
+    std::condition_variable done_cv;
+    const std::function<void(int, int)> *job = nullptr;
+    int job_count = 0;
+    int chunk_size = 1;
+    std::atomic<int> next_chunk{0};
+    int active_workers = 0;
+    uint64_t generation = 0;
+    bool stop = false;
+};
+
+}    // namespace tsp
+
+#endif    // TSP_THREAD_POOL_H_
@@ -0,0 +1,126 @@
+#ifndef TSP_TRANSPOSITION_TABLE_H_
+#define TSP_TRANSPOSITION_TABLE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace tsp {
+
+/**
+ * Lock-free open addressing hash table from 64 bit state hashes to 64 bit values (e.g. node references).
+ * Slots are claimed with a CAS on the key, and entries are never removed.
+ * Hash collisions between different states are resolved by the caller supplied equality check, so a key may appear
+ * in several slots. Concurrent inserts of the same key must come from a single thread (e.g. the owner of that hash
+ * in hash distributed search), while inserts of different keys may come from any thread.
+ */
+class TranspositionTable {
+public:
+    TranspositionTable() = delete;
+
+    /**
+     * @param min_capacity Minimum number of entries, rounded up to a power of 2
+     */
+    explicit TranspositionTable(std::size_t min_capacity)
+        : capacity(RoundUpPow2(min_capacity)), mask(capacity - 1), slots(new Slot[capacity]) {}
+
+    /**
+     * Find the entry for a state, inserting it if it is missing.
+     * @param hash The state hash
+     * @param value The value to store if the state is inserted
+     * @param is_same Callable taking a stored value, which returns true if that value refers to the queried state
+     * @return The stored value and true if inserted, or the existing value and false if found. If the table is full,
+     * returns {value, false} and sets is_full()
+     */
+    template <typename EqualFunc>
+    auto find_or_insert(uint64_t hash, uint64_t value, EqualFunc &&is_same) -> std::pair<uint64_t, bool> {
+        const uint64_t key = ToKey(hash);
+        std::size_t idx = static_cast<std::size_t>(key) & mask;
+        for (std::size_t probe = 0; probe < capacity; ++probe) {
+            Slot &slot = slots[idx];
+            uint64_t stored_key = slot.key.load(std::memory_order_acquire);
+            if (stored_key == kEmptyKey) {
+                if (slot.key.compare_exchange_strong(stored_key, key, std::memory_order_acq_rel)) {
+                    slot.value.store(value, std::memory_order_release);
+                    num_entries.fetch_add(1, std::memory_order_relaxed);
+                    return {value, true};
+                }
+                // Another thread claimed the slot first, stored_key now holds its key
+            }
+            if (stored_key == key) {
+                const uint64_t stored_value = slot.value.load(std::memory_order_acquire);
+                if (is_same(stored_value)) {
+                    return {stored_value, false};
+                }
+            }
+            idx = (idx + 1) & mask;
+        }
+        full.store(true, std::memory_order_relaxed);
+        return {value, false};
+    }
+
+    /**
+     * Get the number of entries stored
+     * @return Number of entries
+     */
+    [[nodiscard]] auto size() const noexcept -> std::size_t {
+        return num_entries.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Get the maximum number of entries
+     * @return Number of slots
+     */
+    [[nodiscard]] auto get_capacity() const noexcept -> std::size_t {
+        return capacity;
+    }
+
+    /**
+     * Check if an insert failed because the table ran out of slots
+     * @return True if full
+     */
+    [[nodiscard]] auto is_full() const noexcept -> bool {
+        return full.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Get the memory used by the table
+     * @return Number of bytes
+     */
+    [[nodiscard]] auto memory_bytes() const noexcept -> std::size_t {
+        return capacity * sizeof(Slot);
+    }
+
+private:
+    static constexpr uint64_t kEmptyKey = 0;
+
+    struct Slot {
+        std::atomic<uint64_t> key{kEmptyKey};
+        std::atomic<uint64_t> value{0};
+    };
+
+    // Reserve 0 for empty slots
+    static auto ToKey(uint64_t hash) noexcept -> uint64_t {
+        return hash == kEmptyKey ? 1 : hash;
+    }
+
+    static auto RoundUpPow2(std::size_t n) noexcept -> std::size_t {
+        std::size_t result = 1;
+        while (result < n) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    std::size_t capacity;
+    std::size_t mask;
+    std::unique_ptr<Slot[]> slots;    // NOLINT(*-avoid-c-arrays)
+    std::atomic<std::size_t> num_entries{0};
+    std::atomic<bool> full{false};
+};
+
+}    // namespace tsp
+
+#endif    // TSP_TRANSPOSITION_TABLE_H_
@@ -1,12 +1,19 @@
 #include "tsp_base.h"
 
+#include <algorithm>
 #include <array>
 #include <cassert>
+#include <cstddef>
+#include <cstring>
 #include <sstream>
+#include <stdexcept>
 #include <string>
-#include <unordered_map>
 #include <vector>
 
+#include "instrumentation.h"
+#include "observation.h"
+#include "renderer.h"
+
 namespace tsp {
 
 namespace {
@@ -22,107 +29,87 @@ const std::array<std::string, kNumElements> kElementToStrMap{
     "$",    // kAgentAtStartCity
 };
 
-// Direction to offsets (col, row)
-using Offset = std::pair<int, int>;
-constexpr std::array<Offset, kNumActions> kActionOffsets{{
-    {0, -1},    // Action::kUp
-    {1, 0},     // Action::kRight
-    {0, 1},     // Action::kDown
-    {-1, 0},    // Action::kLeft
-}};
-static_assert(kActionOffsets.size() == kNumActions);
-
-// Colour maps for state to image
-struct Pixel {
-    unsigned char r;
-    unsigned char g;
-    unsigned char b;
-};
-const Pixel WHITE = {.r = 0xff, .g = 0xff, .b = 0xff};
-const Pixel BLACK = {.r = 0x00, .g = 0x00, .b = 0x00};
-const Pixel RED = {.r = 0xff, .g = 0x00, .b = 0x00};
-const Pixel GREEN = {.r = 0x00, .g = 0xFF, .b = 0x00};
-const Pixel BLUE = {.r = 0x00, .g = 0xFF, .b = 0xFF};
-const Pixel YELLOW = {.r = 0xFF, .g = 0xFF, .b = 0x00};
-const Pixel MAGENTA = {.r = 0xFF, .g = 0x00, .b = 0xFF};
-const Pixel GREY = {.r = 0xA9, .g = 0xA9, .b = 0xA9};
-const std::unordered_map<Element, Pixel> kElementToPixelMap{
-    {Element::kAgent, BLACK},        {Element::kEmpty, WHITE},
-    {Element::kWall, GREY},          {Element::kCityUnvisited, RED},
-    {Element::kCityVisited, GREEN},  {Element::kStartCity, BLUE},
-    {Element::kAgentAtCity, YELLOW}, {Element::kAgentAtStartCity, MAGENTA},
-};
-
-// https://en.wikipedia.org/wiki/Xorshift
-// Portable RNG Seed
-constexpr uint64_t SPLIT64_S1 = 30;
-constexpr uint64_t SPLIT64_S2 = 27;
-constexpr uint64_t SPLIT64_S3 = 31;
-constexpr uint64_t SPLIT64_C1 = 0x9E3779B97f4A7C15;
-constexpr uint64_t SPLIT64_C2 = 0xBF58476D1CE4E5B9;
-constexpr uint64_t SPLIT64_C3 = 0x94D049BB133111EB;
-auto to_local_hash(int flat_size, Element el, int offset) noexcept -> uint64_t {
-    uint64_t seed = (flat_size * static_cast<int>(el)) + offset;
-    uint64_t result = seed + SPLIT64_C1;
-    result = (result ^ (result >> SPLIT64_S1)) * SPLIT64_C2;
-    result = (result ^ (result >> SPLIT64_S2)) * SPLIT64_C3;
-    return result ^ (result >> SPLIT64_S3);
+// Per thread buffer for the element codes of a board, which only allocates when a larger board is seen
+auto ElementCodeScratch(std::size_t num_cells) -> uint8_t* {
+    thread_local std::vector<uint8_t> codes;
+    if (codes.size() < num_cells) {
+        codes.resize(num_cells);
+    }
+    return codes.data();
 }
-
 }    // namespace
 
-TSPGameState::TSPGameState(const std::string& board_str) {
-    std::stringstream board_ss(board_str);
-    std::string segment;
-    std::vector<std::string> seglist;
-    // string split on |
-    while (std::getline(board_ss, segment, '|')) {
-        seglist.push_back(segment);
+TSPGameState::TSPGameState(const std::string& board_str)
+    : TSPGameState(std::make_shared<const TSPLevel>(board_str)) {}
+
+TSPGameState::TSPGameState(TSPLevelPtr level_)
+    : level(std::move(level_)), agent_idx(level->get_agent_index()), remaining_cities(level->get_num_cities()) {
+    TSP_COUNT(kConstruct);
+    TSP_TIME(kConstruct);
+    visited_cities = CityBitset(static_cast<std::size_t>(level->get_num_cities()));
+    if constexpr (kCanonicalHash) {
+        // Build the symmetry keys up front, so that toggling keys never has to allocate
+        (void)level->get_symmetry_table();
+    }
+    for (const int city_idx : level->get_city_indices()) {
+        ToggleKey(Element::kCityUnvisited, city_idx);
     }
+    ToggleKey(Element::kAgent, agent_idx);
+}
+
+TSPGameState::TSPGameState(TSPLevelPtr level_, int agent_idx_, int start_city_idx_, const uint64_t* visited_city_words)
+    : TSPGameState(std::move(level_)) {
+    const auto num_cells = level->get_num_cells();
+    const auto& cities = level->get_city_indices();
+    const auto num_city_words = (cities.size() + kBitsPerWord - 1) / kBitsPerWord;
+    const auto is_visited = [&](std::size_t city_id) -> bool {
+        return (visited_city_words[city_id / kBitsPerWord] >> (city_id % kBitsPerWord)) & 1;
+    };
 
-    // Check input
-    if (seglist.size() < 2) {
-        throw std::invalid_argument("Board string should have at minimum 3 values separated by '|'.");
+    // Check the parts are consistent before modifying anything
+    if (agent_idx_ < 0 || agent_idx_ >= num_cells || level->is_wall(agent_idx_)) {
+        throw std::invalid_argument("Agent index is not an empty cell or city.");
     }
-    rows = std::stoi(seglist[0]);
-    cols = std::stoi(seglist[1]);
-    if (seglist.size() != static_cast<std::size_t>(rows * cols) + 2) {
-        throw std::invalid_argument("Supplied rows/cols does not match input board length.");
+    if (cities.size() % kBitsPerWord != 0 && num_city_words > 0 &&
+        (visited_city_words[num_city_words - 1] >> (cities.size() % kBitsPerWord)) != 0) {
+        throw std::invalid_argument("Visited cities contain bits past the number of cities.");
     }
-
-    // Parse
-    for (int i = 2; i < static_cast<int>(seglist.size()); ++i) {
-        int el_idx = std::stoi(seglist[i]);
-        if (el_idx < 0 || el_idx > 3) {
-            std::cerr << board_str << std::endl;
-            std::cerr << el_idx << std::endl;
-            throw std::invalid_argument("Unknown element type.");
-        }
-        const auto el = static_cast<Element>(el_idx);
-        visited_flags.push_back(el == Element::kCityUnvisited ? false : true);
-        bool is_city = el == Element::kCityUnvisited;
-        hash ^= is_city ? to_local_hash(rows * cols, Element::kCityUnvisited, agent_idx) : 0;
-        board_is_city.push_back(is_city);
-        remaining_cities += is_city;
-        board_is_wall.push_back(el == Element::kWall);
-        if (el == Element::kAgent) {
-            if (agent_idx != -1) {
-                throw std::invalid_argument("More than one agent.");
-            }
-            agent_idx = i - 2;
-            hash ^= to_local_hash(rows * cols, Element::kAgent, agent_idx);
+    bool any_visited = false;
+    bool start_visited = false;
+    for (std::size_t k = 0; k < cities.size(); ++k) {
+        any_visited |= is_visited(k);
+        start_visited |= is_visited(k) && cities[k] == start_city_idx_;
+        if (!is_visited(k) && cities[k] == agent_idx_) {
+            throw std::invalid_argument("Agent is on an unvisited city.");
         }
     }
-    if (agent_idx == -1) {
-        throw std::invalid_argument("Missing agent.");
+    if (start_city_idx_ == -1 ? any_visited : !start_visited) {
+        throw std::invalid_argument("Start city must be set exactly when a city has been visited.");
     }
+
+    ToggleKey(Element::kAgent, agent_idx);
+    agent_idx = agent_idx_;
+    start_city_idx = start_city_idx_;
+    for (std::size_t k = 0; k < cities.size(); ++k) {
+        if (!is_visited(k)) {
+            continue;
+        }
+        const int city_idx = cities[k];
+        visited_cities.set(k);
+        --remaining_cities;
+        ToggleKey(Element::kCityUnvisited, city_idx);
+        ToggleKey(city_idx == start_city_idx ? Element::kStartCity : Element::kCityVisited, city_idx);
+    }
+    ToggleKey(GetAgentElement(), agent_idx);
 }
 
 auto TSPGameState::operator==(const TSPGameState& other) const noexcept -> bool {
-    return rows == other.rows && cols == other.cols && agent_idx == other.agent_idx &&
-           start_city_idx == other.start_city_idx && remaining_cities == other.remaining_cities &&
-           board_is_city == other.board_is_city && visited_flags == other.visited_flags &&
-           board_is_wall == other.board_is_wall;
+    // States on the same level only differ by their dynamic parts
+    if (level != other.level && !level->has_same_layout(*other.level)) {
+        return false;
+    }
+    return agent_idx == other.agent_idx && start_city_idx == other.start_city_idx &&
+           remaining_cities == other.remaining_cities && visited_cities == other.visited_cities;
 }
 
 auto TSPGameState::operator!=(const TSPGameState& other) const noexcept -> bool {
@@ -134,39 +121,191 @@ auto TSPGameState::operator!=(const TSPGameState& other) const noexcept -> bool
 // ---------------------------------------------------------------------------
 
 void TSPGameState::apply_action(Action action) {
+    TSP_COUNT(kApplyAction);
+    TSP_TIME(kApplyAction);
     reward_signal = 0;
 
     // Do nothing if move puts agent out of bounds or into wall
-    const auto& [new_idx, in_bounds] = IndexAndBoundsCheck(action);
-    if (!in_bounds || board_is_wall[new_idx]) {
+    const auto new_idx = level->get_neighbor(agent_idx, action);
+    if (new_idx == kNoNeighbor) {
+        TSP_COUNT(kApplyActionNoop);
         return;
     }
 
-    auto get_agent_type = [&]() -> Element {
-        bool on_city = board_is_city[static_cast<std::size_t>(agent_idx)];
-        bool on_start_city = agent_idx == start_city_idx;
-        return on_city ? (on_start_city ? Element::kAgentAtStartCity : Element::kAgentAtCity) : Element::kAgent;
-    };
-
-    // Undo agent hash
-    hash ^= to_local_hash(rows * cols, get_agent_type(), agent_idx);
+    const auto& zobrist = level->get_zobrist_table();
+    const int prev_agent_idx = agent_idx;
+    const Element prev_agent_el = GetAgentElement();
 
     // Move agent
     agent_idx = new_idx;
-    bool on_city = board_is_city[static_cast<std::size_t>(agent_idx)];
-    bool set_visited_city = on_city && !visited_flags[static_cast<std::size_t>(agent_idx)];
+    const int city_id = level->get_city_id(agent_idx);
+    bool on_city = city_id >= 0;
+    bool set_visited_city = on_city && !visited_cities.test(static_cast<std::size_t>(city_id));
     bool set_start_city = on_city && start_city_idx == -1;
     reward_signal = set_visited_city;
     remaining_cities -= set_visited_city;
-    visited_flags[static_cast<std::size_t>(agent_idx)] = true;
+    if (set_visited_city) {
+        visited_cities.set(static_cast<std::size_t>(city_id));
+    }
     // Set start city if on city and start not set yet, else keep same
-    hash ^= set_visited_city ? to_local_hash(rows * cols, Element::kCityUnvisited, agent_idx) : 0;
-    hash ^= (set_visited_city && !set_start_city) ? to_local_hash(rows * cols, Element::kCityVisited, agent_idx) : 0;
-    hash ^= set_start_city ? to_local_hash(rows * cols, Element::kStartCity, agent_idx) : 0;
     start_city_idx = set_start_city ? agent_idx : start_city_idx;
 
-    // Update agent hash
-    hash ^= to_local_hash(rows * cols, get_agent_type(), agent_idx);
+    // Move the agent key, and flip the key of a newly visited city
+    TSP_COUNT(kHashUpdate);
+    TSP_TIME(kHashUpdate);
+    Hash128 delta = zobrist.get_keys(prev_agent_el, prev_agent_idx);
+    delta ^= zobrist.get_keys(GetAgentElement(), agent_idx);
+    if (set_visited_city) {
+        delta ^= zobrist.get_keys(Element::kCityUnvisited, agent_idx);
+        delta ^= zobrist.get_keys(set_start_city ? Element::kStartCity : Element::kCityVisited, agent_idx);
+    }
+    hash ^= delta.lo;
+    hash_hi ^= delta.hi;
+    if constexpr (kCanonicalHash) {
+        ToggleSymmetryKeys(prev_agent_el, prev_agent_idx);
+        ToggleSymmetryKeys(GetAgentElement(), agent_idx);
+        if (set_visited_city) {
+            ToggleSymmetryKeys(Element::kCityUnvisited, agent_idx);
+            ToggleSymmetryKeys(set_start_city ? Element::kStartCity : Element::kCityVisited, agent_idx);
+        }
+    }
+}
+
+auto TSPGameState::apply_action_with_undo(Action action) -> TSPUndoRecord {
+    TSPUndoRecord record{hash, hash_hi, reward_signal, agent_idx, false, false};
+    const bool start_city_unset = start_city_idx == -1;
+    apply_action(action);
+    record.set_visited_city = reward_signal != 0;
+    record.set_start_city = start_city_unset && start_city_idx != -1;
+    return record;
+}
+
+void TSPGameState::undo_action(const TSPUndoRecord& record) noexcept {
+    if constexpr (kCanonicalHash) {
+        // Keys are their own inverse, so the keys toggled by the action are toggled again
+        ToggleSymmetryKeys(GetAgentElement(), agent_idx);
+        if (record.set_visited_city) {
+            ToggleSymmetryKeys(Element::kCityUnvisited, agent_idx);
+            ToggleSymmetryKeys(record.set_start_city ? Element::kStartCity : Element::kCityVisited, agent_idx);
+        }
+    }
+    if (record.set_visited_city) {
+        visited_cities.reset(static_cast<std::size_t>(level->get_city_id(agent_idx)));
+        ++remaining_cities;
+    }
+    if (record.set_start_city) {
+        start_city_idx = -1;
+    }
+    agent_idx = record.prev_agent_idx;
+    hash = record.prev_hash;
+    hash_hi = record.prev_hash_hi;
+    reward_signal = record.prev_reward_signal;
+    if constexpr (kCanonicalHash) {
+        ToggleSymmetryKeys(GetAgentElement(), agent_idx);
+    }
+}
+
+auto TSPGameState::apply_path(int target_idx, std::vector<Action>* actions) -> int {
+    if (target_idx < 0 || target_idx >= level->get_num_cells()) {
+        throw std::invalid_argument("Target index is off the board.");
+    }
+    // The grid is undirected, so the row of the target holds the distance from every cell to it
+    const uint16_t* distances = level->get_distances().get_row(target_idx);
+    if (distances == nullptr) {
+        thread_local std::vector<uint16_t> scratch;
+        scratch.resize(static_cast<std::size_t>(level->get_num_cells()));
+        compute_distances(*level, target_idx, scratch.data());
+        distances = scratch.data();
+    }
+    const int cost = distances[agent_idx];
+    if (cost == kUnreachable) {
+        throw std::invalid_argument("Target can't be reached from the agent.");
+    }
+
+    // The hash only depends on the state, so the agent key is moved once and each newly visited city is flipped
+    TSP_COUNT(kHashUpdate);
+    const auto& zobrist = level->get_zobrist_table();
+    Hash128 delta = zobrist.get_keys(GetAgentElement(), agent_idx);
+    if constexpr (kCanonicalHash) {
+        ToggleSymmetryKeys(GetAgentElement(), agent_idx);
+    }
+    reward_signal = 0;
+    for (int remaining = cost; remaining > 0; --remaining) {
+        // Step to the first neighbour which is one move closer to the target
+        int action = 0;
+        int next_idx = kNoNeighbor;
+        for (; action < kNumActions; ++action) {
+            next_idx = level->get_neighbor(agent_idx, static_cast<Action>(action));
+            if (next_idx != kNoNeighbor && distances[next_idx] == remaining - 1) {
+                break;
+            }
+        }
+        assert(action < kNumActions);
+        agent_idx = next_idx;
+        if (actions != nullptr) {
+            actions->push_back(static_cast<Action>(action));
+        }
+        const int city_id = level->get_city_id(agent_idx);
+        if (city_id >= 0 && !visited_cities.test(static_cast<std::size_t>(city_id))) {
+            const bool set_start_city = start_city_idx == -1;
+            visited_cities.set(static_cast<std::size_t>(city_id));
+            --remaining_cities;
+            ++reward_signal;
+            start_city_idx = set_start_city ? agent_idx : start_city_idx;
+            delta ^= zobrist.get_keys(Element::kCityUnvisited, agent_idx);
+            delta ^= zobrist.get_keys(set_start_city ? Element::kStartCity : Element::kCityVisited, agent_idx);
+            if constexpr (kCanonicalHash) {
+                ToggleSymmetryKeys(Element::kCityUnvisited, agent_idx);
+                ToggleSymmetryKeys(set_start_city ? Element::kStartCity : Element::kCityVisited, agent_idx);
+            }
+        }
+    }
+    delta ^= zobrist.get_keys(GetAgentElement(), agent_idx);
+    hash ^= delta.lo;
+    hash_hi ^= delta.hi;
+    if constexpr (kCanonicalHash) {
+        ToggleSymmetryKeys(GetAgentElement(), agent_idx);
+    }
+    return cost;
+}
+
+auto TSPGameState::apply_macro(int city_id, std::vector<Action>* actions) -> int {
+    const auto& city_indices = level->get_city_indices();
+    if (city_id < 0 || city_id >= static_cast<int>(city_indices.size())) {
+        throw std::invalid_argument("City id out of range.");
+    }
+    return apply_path(city_indices[static_cast<std::size_t>(city_id)], actions);
+}
+
+auto TSPGameState::legal_action_mask() const noexcept -> uint8_t {
+    return level->get_legal_action_mask(agent_idx);
+}
+
+auto TSPGameState::legal_actions() const noexcept -> std::vector<Action> {
+    std::vector<Action> actions;
+    const auto mask = legal_action_mask();
+    for (int a = 0; a < kNumActions; ++a) {
+        if (mask & (1 << a)) {
+            actions.push_back(static_cast<Action>(a));
+        }
+    }
+    return actions;
+}
+
+auto TSPGameState::expand(TSPGameState* children, Action* actions) const -> int {
+    const auto mask = legal_action_mask();
+    int num_children = 0;
+    for (int a = 0; a < kNumActions; ++a) {
+        if (mask & (1 << a)) {
+            children[num_children] = *this;
+            children[num_children].apply_action(static_cast<Action>(a));
+            if (actions != nullptr) {
+                actions[num_children] = static_cast<Action>(a);
+            }
+            ++num_children;
+        }
+    }
+    return num_children;
 }
 
 auto TSPGameState::is_solution() const noexcept -> bool {
@@ -174,83 +313,211 @@ auto TSPGameState::is_solution() const noexcept -> bool {
 }
 
 auto TSPGameState::observation_shape() const noexcept -> std::array<int, 3> {
+    const auto rows = level->get_rows();
+    const auto cols = level->get_cols();
     return {kNumChannels, cols, rows};
 }
 
 auto TSPGameState::get_observation() const noexcept -> std::vector<float> {
-    const auto channel_length = rows * cols;
-    std::vector<float> obs(kNumChannels * channel_length, 0);
+    std::vector<float> obs(static_cast<std::size_t>(kNumChannels * level->get_num_cells()));
+    get_observation(obs.data());
+    return obs;
+}
 
-    bool on_city = board_is_city[static_cast<std::size_t>(agent_idx)];
-    bool on_start_city = agent_idx == start_city_idx;
+void TSPGameState::get_observation(float* obs) const noexcept {
+    get_observation(obs, level->get_num_cells());
+}
 
-    // Fill board (elements which are not empty)
-    for (int i = 0; i < channel_length; ++i) {
-        auto el = Element::kEmpty;
-        el = board_is_wall[static_cast<std::size_t>(i)] ? Element::kWall : el;
-        el = board_is_city[static_cast<std::size_t>(i)]
-                 ? (visited_flags[static_cast<std::size_t>(i)] ? Element::kCityVisited : Element::kCityUnvisited)
-                 : el;
-        el = (i == start_city_idx) ? Element::kStartCity : el;
-        el = (i == agent_idx) ? Element::kAgent : el;
-        el = (i == agent_idx && on_city) ? Element::kAgentAtCity : el;
-        el = (i == agent_idx && on_start_city) ? Element::kAgentAtStartCity : el;
-        obs[static_cast<std::size_t>(el) * channel_length + i] = 1;
-    }
-    return obs;
+void TSPGameState::get_observation(float* obs, int channel_stride) const noexcept {
+    TSP_COUNT(kObservation);
+    TSP_TIME(kObservation);
+    const auto num_cells = level->get_num_cells();
+    uint8_t* codes = ElementCodeScratch(static_cast<std::size_t>(num_cells));
+    get_element_codes(codes);
+    encode_one_hot(codes, num_cells, obs, channel_stride);
 }
 
-auto TSPGameState::image_shape() const noexcept -> std::array<int, 3> {
-    return {rows * SPRITE_HEIGHT, cols * SPRITE_WIDTH, SPRITE_CHANNELS};
+void TSPGameState::get_observation(uint8_t* obs) const noexcept {
+    get_observation(obs, level->get_num_cells());
 }
 
-void fill_sprite(std::vector<uint8_t>& img, int h, int w, int cols, const Pixel& pixel) {
-    const auto img_idx_top_left = h * (SPRITE_DATA_LEN * cols) + (w * SPRITE_DATA_LEN_PER_ROW);
-    for (int r = 0; r < SPRITE_HEIGHT; ++r) {
-        for (int c = 0; c < SPRITE_WIDTH; ++c) {
-            const auto img_idx = static_cast<std::size_t>((r * SPRITE_DATA_LEN_PER_ROW * cols) + (SPRITE_CHANNELS * c) +
-                                                          img_idx_top_left);
-            img[img_idx + 0] = pixel.r;
-            img[img_idx + 1] = pixel.g;
-            img[img_idx + 2] = pixel.b;
+void TSPGameState::get_observation(uint8_t* obs, int channel_stride) const noexcept {
+    TSP_COUNT(kObservation);
+    TSP_TIME(kObservation);
+    const auto num_cells = level->get_num_cells();
+    uint8_t* codes = ElementCodeScratch(static_cast<std::size_t>(num_cells));
+    get_element_codes(codes);
+    encode_one_hot(codes, num_cells, obs, channel_stride);
+}
+
+void TSPGameState::get_observation_bfloat16(uint16_t* obs, int channel_stride) const noexcept {
+    TSP_COUNT(kObservation);
+    TSP_TIME(kObservation);
+    const auto num_cells = level->get_num_cells();
+    uint8_t* codes = ElementCodeScratch(static_cast<std::size_t>(num_cells));
+    get_element_codes(codes);
+    encode_one_hot_bfloat16(codes, num_cells, obs, channel_stride);
+}
+
+void TSPGameState::get_observation_bit_planes(uint64_t* planes) const noexcept {
+    TSP_COUNT(kObservation);
+    TSP_TIME(kObservation);
+    const auto num_cells = level->get_num_cells();
+    const std::size_t num_words = bit_plane_words(num_cells);
+    const uint64_t* walls = level->get_wall_layer().data();
+    const uint64_t* cities = level->get_city_layer().data();
+    const auto plane = [&](Element el) -> uint64_t* {
+        return planes + (static_cast<std::size_t>(el) * num_words);
+    };
+    std::fill_n(planes, kNumChannels * num_words, 0);
+    for (std::size_t w = 0; w < num_words; ++w) {
+        plane(Element::kEmpty)[w] = ~(walls[w] | cities[w]);
+        plane(Element::kWall)[w] = walls[w];
+        plane(Element::kCityUnvisited)[w] = cities[w];
+    }
+    if (num_cells % kBitsPerWord != 0) {
+        plane(Element::kEmpty)[num_words - 1] &= (uint64_t{1} << (num_cells % kBitsPerWord)) - 1;
+    }
+    for_each_visited_city([&](int index) {
+        const uint64_t bit = uint64_t{1} << (static_cast<std::size_t>(index) % kBitsPerWord);
+        plane(Element::kCityUnvisited)[static_cast<std::size_t>(index) / kBitsPerWord] &= ~bit;
+        plane(Element::kCityVisited)[static_cast<std::size_t>(index) / kBitsPerWord] |= bit;
+    });
+
+    // Move the start city and then the agent cell from their layer planes
+    const auto move_cell = [&](int index, Element el) {
+        const uint64_t bit = uint64_t{1} << (static_cast<std::size_t>(index) % kBitsPerWord);
+        for (int c = 0; c < kNumChannels; ++c) {
+            plane(static_cast<Element>(c))[static_cast<std::size_t>(index) / kBitsPerWord] &= ~bit;
         }
+        plane(el)[static_cast<std::size_t>(index) / kBitsPerWord] |= bit;
+    };
+    if (start_city_idx != -1) {
+        move_cell(start_city_idx, Element::kStartCity);
     }
+    move_cell(agent_idx, GetAgentElement());
 }
 
-auto TSPGameState::to_image() const noexcept -> std::vector<uint8_t> {
-    const auto channel_length = rows * cols;
-    std::vector<uint8_t> img(channel_length * SPRITE_DATA_LEN, 0);
+auto TSPGameState::get_observation_sparse(uint32_t* entries) const noexcept -> int {
+    TSP_COUNT(kObservation);
+    TSP_TIME(kObservation);
+    const uint64_t* walls = level->get_wall_layer().data();
+    const uint64_t* cities = level->get_city_layer().data();
+    int num_entries = 0;
+    for (std::size_t w = 0; w < level->get_wall_layer().num_words(); ++w) {
+        uint64_t word = walls[w] | cities[w];
+        word |= static_cast<std::size_t>(agent_idx) / kBitsPerWord == w
+                    ? uint64_t{1} << (static_cast<std::size_t>(agent_idx) % kBitsPerWord)
+                    : 0;
+        for (; word != 0; word &= word - 1) {
+            const int i = static_cast<int>((w * kBitsPerWord) + static_cast<std::size_t>(__builtin_ctzll(word)));
+            entries[num_entries++] = make_sparse_cell(i, static_cast<uint8_t>(GetElement(i)));
+        }
+    }
+    return num_entries;
+}
 
-    bool on_city = board_is_city[static_cast<std::size_t>(agent_idx)];
-    bool on_start_city = agent_idx == start_city_idx;
+void TSPGameState::get_element_codes(uint8_t* codes) const noexcept {
+    const auto& static_codes = level->get_static_element_codes();
+    std::memcpy(codes, static_codes.data(), static_codes.size());
+    for_each_visited_city([&](int i) { codes[i] = static_cast<uint8_t>(Element::kCityVisited); });
+    if (start_city_idx != -1) {
+        codes[start_city_idx] = static_cast<uint8_t>(Element::kStartCity);
+    }
+    codes[agent_idx] = static_cast<uint8_t>(GetAgentElement());
+}
 
-    int i = 0;
-    for (int h = 0; h < rows; ++h) {
-        for (int w = 0; w < cols; ++w) {
-            auto el = Element::kEmpty;
-            el = board_is_wall[static_cast<std::size_t>(i)] ? Element::kWall : el;
-            el = board_is_city[static_cast<std::size_t>(i)]
-                     ? (visited_flags[static_cast<std::size_t>(i)] ? Element::kCityVisited : Element::kCityUnvisited)
-                     : el;
-            el = (i == start_city_idx) ? Element::kStartCity : el;
-            el = (i == agent_idx) ? Element::kAgent : el;
-            el = (i == agent_idx && on_city) ? Element::kAgentAtCity : el;
-            el = (i == agent_idx && on_start_city) ? Element::kAgentAtStartCity : el;
-            fill_sprite(img, h, w, cols, kElementToPixelMap.at(el));
-            ++i;
+void TSPGameState::update_observation(float* obs, int prev_agent_idx) const noexcept {
+    update_observation(obs, prev_agent_idx, level->get_num_cells());
+}
+
+void TSPGameState::update_observation(float* obs, int prev_agent_idx, int channel_stride) const noexcept {
+    // A move only changes the cell the agent left and the cell it entered (visited/start city flags are always set on
+    // the entered cell)
+    for (const auto i : {prev_agent_idx, agent_idx}) {
+        for (int c = 0; c < kNumChannels; ++c) {
+            obs[static_cast<std::ptrdiff_t>(c) * channel_stride + i] = 0;
         }
+        obs[static_cast<std::ptrdiff_t>(GetElement(i)) * channel_stride + i] = 1;
     }
+}
+
+auto TSPGameState::image_shape() const noexcept -> std::array<int, 3> {
+    const auto rows = level->get_rows();
+    const auto cols = level->get_cols();
+    return {rows * SPRITE_HEIGHT, cols * SPRITE_WIDTH, SPRITE_CHANNELS};
+}
+
+auto TSPGameState::to_image() const noexcept -> std::vector<uint8_t> {
+    std::vector<uint8_t> img(static_cast<std::size_t>(level->get_num_cells() * SPRITE_DATA_LEN));
+    to_image(img.data());
     return img;
 }
 
+void TSPGameState::to_image(uint8_t* img) const noexcept {
+    to_image(img, level->get_cols() * SPRITE_DATA_LEN_PER_ROW);
+}
+
+void TSPGameState::to_image(uint8_t* img, int row_stride) const noexcept {
+    static const Renderer renderer(SPRITE_HEIGHT, SPRITE_WIDTH);
+    renderer.render(*this, img, row_stride);
+}
+
+auto TSPGameState::get_element(int index) const noexcept -> Element {
+    return GetElement(index);
+}
+
 auto TSPGameState::get_reward_signal() const noexcept -> uint64_t {
     return reward_signal;
 }
 
 auto TSPGameState::get_hash() const noexcept -> uint64_t {
+    TSP_COUNT(kHashQuery);
     return hash;
 }
 
+auto TSPGameState::get_hash128() const noexcept -> Hash128 {
+    return {.lo = hash, .hi = hash_hi};
+}
+
+auto TSPGameState::get_symmetry_hash(Symmetry symmetry) const -> uint64_t {
+    const uint64_t wall_hash = level->get_symmetry_wall_hash(symmetry);
+    if constexpr (kCanonicalHash) {
+        return wall_hash ^
+               (symmetry == Symmetry::kIdentity ? hash : symmetry_hashes[static_cast<std::size_t>(symmetry) - 1]);
+    }
+    // Same keys as the incremental hash, moved to the transformed cells
+    const auto& table = level->get_symmetry_table();
+    uint64_t result = wall_hash ^ table.get_key(symmetry, GetAgentElement(), agent_idx);
+    const auto& cities = level->get_city_indices();
+    for (std::size_t k = 0; k < cities.size(); ++k) {
+        Element el = Element::kCityUnvisited;
+        if (visited_cities.test(k)) {
+            el = cities[k] == start_city_idx ? Element::kStartCity : Element::kCityVisited;
+        }
+        result ^= table.get_key(symmetry, el, cities[k]);
+    }
+    return result;
+}
+
+auto TSPGameState::get_canonical_symmetry() const -> Symmetry {
+    const int num_symmetries = get_num_symmetries(level->get_rows(), level->get_cols());
+    auto best = Symmetry::kIdentity;
+    uint64_t best_hash = get_symmetry_hash(best);
+    for (int s = 1; s < num_symmetries; ++s) {
+        const uint64_t symmetry_hash = get_symmetry_hash(static_cast<Symmetry>(s));
+        if (symmetry_hash < best_hash) {
+            best = static_cast<Symmetry>(s);
+            best_hash = symmetry_hash;
+        }
+    }
+    return best;
+}
+
+auto TSPGameState::get_canonical_hash() const -> uint64_t {
+    return get_symmetry_hash(get_canonical_symmetry());
+}
+
 auto TSPGameState::get_agent_index() const noexcept -> int {
     return agent_idx;
 }
@@ -261,67 +528,84 @@ auto TSPGameState::get_start_city_index() const noexcept -> int {
 
 auto TSPGameState::get_unvisited_city_indices() const noexcept -> std::vector<int> {
     std::vector<int> indices;
-    for (int i = 0; i < rows * cols; ++i) {
-        bool is_city = board_is_city[static_cast<std::size_t>(i)];
-        bool is_visited = visited_flags[static_cast<std::size_t>(i)];
-        if (is_city && !is_visited) {
-            indices.push_back(i);
-        }
-    }
+    indices.reserve(static_cast<std::size_t>(remaining_cities));
+    for_each_unvisited_city([&](int i) { indices.push_back(i); });
     return indices;
 }
 
+void TSPGameState::get_visited_city_words(uint64_t* words) const noexcept {
+    std::copy_n(visited_cities.data(), visited_cities.num_words(), words);
+}
+
+auto TSPGameState::get_num_unvisited_cities() const noexcept -> int {
+    return remaining_cities;
+}
+
+auto TSPGameState::get_level() const noexcept -> const TSPLevelPtr& {
+    return level;
+}
+
 auto TSPGameState::get_visited_city_indices() const noexcept -> std::vector<int> {
     std::vector<int> indices;
-    for (int i = 0; i < rows * cols; ++i) {
-        bool is_city = board_is_city[static_cast<std::size_t>(i)];
-        bool is_visited = visited_flags[static_cast<std::size_t>(i)];
-        if (is_city && is_visited) {
-            indices.push_back(i);
-        }
-    }
+    indices.reserve(static_cast<std::size_t>(level->get_num_cities() - remaining_cities));
+    for_each_visited_city([&](int i) { indices.push_back(i); });
     return indices;
 }
 
 // ---------------------------------------------------------------------------
 
-auto TSPGameState::IndexAndBoundsCheck(Action action) const noexcept -> std::pair<int, bool> {
-    auto col = agent_idx % cols;
-    auto row = (agent_idx - col) / cols;
-    const auto& offsets = kActionOffsets[static_cast<std::size_t>(action)];    // NOLINT(*-bounds-constant-array-index)
-    col = col + offsets.first;
-    row = row + offsets.second;
-    bool in_bounds = col >= 0 && col < cols && row >= 0 && row < rows;
-    return {(cols * row) + col, in_bounds};
+void TSPGameState::ToggleKey(Element el, int index) noexcept {
+    const auto keys = level->get_zobrist_table().get_keys(el, index);
+    hash ^= keys.lo;
+    hash_hi ^= keys.hi;
+    if constexpr (kCanonicalHash) {
+        ToggleSymmetryKeys(el, index);
+    }
+}
+
+void TSPGameState::ToggleSymmetryKeys(Element el, int index) noexcept {
+    // The table is built when the state is constructed
+    const auto& table = level->get_symmetry_table();
+    for (int s = 1; s < table.get_num_symmetries(); ++s) {
+        symmetry_hashes[static_cast<std::size_t>(s - 1)] ^= table.get_key(static_cast<Symmetry>(s), el, index);
+    }
+}
+
+auto TSPGameState::GetAgentElement() const noexcept -> Element {
+    bool on_city = level->is_city(agent_idx);
+    bool on_start_city = agent_idx == start_city_idx;
+    return on_city ? (on_start_city ? Element::kAgentAtStartCity : Element::kAgentAtCity) : Element::kAgent;
+}
+
+auto TSPGameState::GetElement(int index) const noexcept -> Element {
+    if (index == agent_idx) {
+        return GetAgentElement();
+    }
+    if (index == start_city_idx) {
+        return Element::kStartCity;
+    }
+    const int city_id = level->get_city_id(index);
+    if (city_id >= 0) {
+        return visited_cities.test(static_cast<std::size_t>(city_id)) ? Element::kCityVisited : Element::kCityUnvisited;
+    }
+    return level->is_wall(index) ? Element::kWall : Element::kEmpty;
 }
 
 auto operator<<(std::ostream& os, const TSPGameState& state) -> std::ostream& {
     const auto print_horz_boarder = [&]() {
-        for (int w = 0; w < state.cols + 2; ++w) {
+        for (int w = 0; w < state.level->get_cols() + 2; ++w) {
             os << "-";
         }
         os << std::endl;
     };
 
-    bool on_city = state.board_is_city[static_cast<std::size_t>(state.agent_idx)];
-    bool on_start_city = state.agent_idx == state.start_city_idx;
-
     // Board
     print_horz_boarder();
     int i = 0;
-    for (int row = 0; row < state.rows; ++row) {
+    for (int row = 0; row < state.level->get_rows(); ++row) {
         os << "|";
-        for (int col = 0; col < state.cols; ++col) {
-            auto el = Element::kEmpty;
-            el = state.board_is_wall[static_cast<std::size_t>(i)] ? Element::kWall : el;
-            el = state.board_is_city[static_cast<std::size_t>(i)]
-                     ? (state.visited_flags[static_cast<std::size_t>(i)] ? Element::kCityVisited
-                                                                         : Element::kCityUnvisited)
-                     : el;
-            el = (i == state.start_city_idx) ? Element::kStartCity : el;
-            el = (i == state.agent_idx) ? Element::kAgent : el;
-            el = (i == state.agent_idx && on_city) ? Element::kAgentAtCity : el;
-            el = (i == state.agent_idx && on_start_city) ? Element::kAgentAtStartCity : el;
+        for (int col = 0; col < state.level->get_cols(); ++col) {
+            const auto el = state.GetElement(i);
             os << kElementToStrMap.at(static_cast<std::size_t>(el));
             ++i;
         }
@@ -4,10 +4,16 @@
 #include <array>
 #include <cstdint>
 #include <iostream>
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "bitset.h"
 #include "definitions.h"
+#include "symmetry.h"
+#include "tsp_level.h"
+#include "zobrist.h"
 
 namespace tsp {
 
@@ -18,11 +24,43 @@ constexpr int SPRITE_CHANNELS = 3;
 constexpr int SPRITE_DATA_LEN_PER_ROW = SPRITE_WIDTH * SPRITE_CHANNELS;
 constexpr int SPRITE_DATA_LEN = SPRITE_WIDTH * SPRITE_HEIGHT * SPRITE_CHANNELS;
 
+/**
+ * Information needed to revert a single apply_action.
+ */
+struct TSPUndoRecord {
+    uint64_t prev_hash = 0;
+    uint64_t prev_hash_hi = 0;
+    // apply_path() counts every city visited along the path, so this is as wide as the reward signal itself
+    uint64_t prev_reward_signal = 0;
+    int prev_agent_idx = -1;
+    bool set_visited_city = false;
+    bool set_start_city = false;
+};
+
 class TSPGameState {
 public:
     TSPGameState() = delete;
     TSPGameState(const std::string &board_str);
 
+    /**
+     * Create the initial state for a level which may be shared with other states.
+     * @param level The level to play on
+     */
+    TSPGameState(TSPLevelPtr level);
+
+    /**
+     * Restore a mid-episode state from its dynamic parts, e.g. when loading a state from a binary file.
+     * The hash matches that of any state reached by actions with the same agent, start city, and visited cities, and
+     * the reward signal is 0.
+     * @param level The level to play on
+     * @param agent_idx The agent index
+     * @param start_city_idx The start city index, or -1 if no city has been visited yet
+     * @param visited_city_words Bitmask of the visited cities indexed by city id (see TSPLevel::get_city_indices()),
+     * of (num_cities + 63) / 64 words
+     * @throws std::invalid_argument if the parts are not a reachable combination
+     */
+    TSPGameState(TSPLevelPtr level, int agent_idx, int start_city_idx, const uint64_t *visited_city_words);
+
     bool operator==(const TSPGameState &other) const noexcept;
     bool operator!=(const TSPGameState &other) const noexcept;
 
@@ -32,6 +70,60 @@ public:
      */
     void apply_action(Action action);
 
+    /**
+     * Apply the action to the current state, and return a record which can be used to revert it.
+     * @param action The action to apply, should be one of the legal actions
+     * @return Record to pass to undo_action
+     */
+    [[nodiscard]] auto apply_action_with_undo(Action action) -> TSPUndoRecord;
+
+    /**
+     * Revert the last applied action, restoring the state exactly (including the hash and reward signal).
+     * Records must be undone in the reverse order they were applied.
+     * @param record The record returned by apply_action_with_undo
+     */
+    void undo_action(const TSPUndoRecord &record) noexcept;
+
+    /**
+     * Move the agent along a wall-aware shortest path to the target cell, updating the state exactly as the primitive
+     * actions would. Unvisited cities passed along the way are also visited, and the reward signal is set to the
+     * number of cities visited by the path. Ties between shortest paths are broken in Action order.
+     * @param target_idx The target cell index
+     * @param actions Optional vector which the primitive actions of the path are appended to
+     * @return Number of moves along the path
+     * @throws std::invalid_argument if the target is off the board or can't be reached from the agent
+     */
+    auto apply_path(int target_idx, std::vector<Action> *actions = nullptr) -> int;
+
+    /**
+     * Move the agent along a shortest path to a city, see apply_path().
+     * @param city_id The city id, indexing TSPLevel::get_city_indices()
+     * @param actions Optional vector which the primitive actions of the path are appended to
+     * @return Number of moves along the path
+     * @throws std::invalid_argument if the city id is out of range or the city can't be reached from the agent
+     */
+    auto apply_macro(int city_id, std::vector<Action> *actions = nullptr) -> int;
+
+    /**
+     * Get the actions which move the agent (i.e. do not walk into a wall or off the board), as a bitmask.
+     * @return Mask where bit a is set if static_cast<Action>(a) is legal
+     */
+    [[nodiscard]] auto legal_action_mask() const noexcept -> uint8_t;
+
+    /**
+     * Get the actions which move the agent
+     * @return Vector of legal actions
+     */
+    [[nodiscard]] auto legal_actions() const noexcept -> std::vector<Action>;
+
+    /**
+     * Write the child state of each legal action, skipping actions which would leave the state unchanged.
+     * @param children Array of at least kNumActions existing states which are overwritten with the children
+     * @param actions Optional array of at least kNumActions, which is filled with the action leading to each child
+     * @return Number of children written
+     */
+    auto expand(TSPGameState *children, Action *actions = nullptr) const -> int;
+
     /**
      * Check if the state is in the solution state (agent visited all cities and returned back).
      * @return True if terminal, false otherwise
@@ -59,6 +151,75 @@ public:
      */
     [[nodiscard]] auto get_observation() const noexcept -> std::vector<float>;
 
+    /**
+     * Write the observation into a caller provided buffer, which must hold at least kNumChannels * rows * cols floats.
+     * @param obs The buffer to write into, laid out as observation_shape()
+     */
+    void get_observation(float *obs) const noexcept;
+
+    /**
+     * Write the observation into a caller provided buffer, with a custom distance between the start of each channel.
+     * Only the rows * cols values of each channel are written, so padding between channels is left untouched.
+     * @param obs The buffer to write into
+     * @param channel_stride Number of floats between the start of consecutive channels (>= rows * cols)
+     */
+    void get_observation(float *obs, int channel_stride) const noexcept;
+
+    /**
+     * Write the observation as uint8_t values of 0 and 1, which must hold at least kNumChannels * rows * cols bytes.
+     * @param obs The buffer to write into, laid out as observation_shape()
+     */
+    void get_observation(uint8_t *obs) const noexcept;
+
+    /**
+     * Write the observation as uint8_t values of 0 and 1, with a custom channel stride.
+     * @param obs The buffer to write into
+     * @param channel_stride Number of values between the start of consecutive channels (>= rows * cols)
+     */
+    void get_observation(uint8_t *obs, int channel_stride) const noexcept;
+
+    /**
+     * Write the observation as bfloat16 values (stored as uint16_t bit patterns), with a custom channel stride.
+     * @param obs The buffer to write into, laid out as observation_shape() when channel_stride is rows * cols
+     * @param channel_stride Number of values between the start of consecutive channels (>= rows * cols)
+     */
+    void get_observation_bfloat16(uint16_t *obs, int channel_stride) const noexcept;
+
+    /**
+     * Write the observation as bit-packed channel planes (see encode_bit_planes()), built word by word from the layers.
+     * @param planes The buffer to write into, of kNumChannels * bit_plane_words(rows * cols) words
+     */
+    void get_observation_bit_planes(uint64_t *planes) const noexcept;
+
+    /**
+     * Write the observation as a list of the non-empty cells in increasing cell order (see encode_sparse()).
+     * @param entries The buffer to write into, of at least rows * cols entries
+     * @return Number of entries written
+     */
+    auto get_observation_sparse(uint32_t *entries) const noexcept -> int;
+
+    /**
+     * Write the element code (static_cast<uint8_t>(Element)) of each cell, as given by get_element().
+     * @param codes The buffer to write into, of at least rows * cols bytes
+     */
+    void get_element_codes(uint8_t *codes) const noexcept;
+
+    /**
+     * Update a buffer holding the observation of the previous state, after a single apply_action.
+     * Only the cells the agent left and entered are rewritten.
+     * @param obs The buffer holding the previous observation, laid out as observation_shape()
+     * @param prev_agent_idx The agent index before the action was applied
+     */
+    void update_observation(float *obs, int prev_agent_idx) const noexcept;
+
+    /**
+     * Update a buffer holding the observation of the previous state, with a custom channel stride.
+     * @param obs The buffer holding the previous observation
+     * @param prev_agent_idx The agent index before the action was applied
+     * @param channel_stride Number of floats between the start of consecutive channels (>= rows * cols)
+     */
+    void update_observation(float *obs, int prev_agent_idx, int channel_stride) const noexcept;
+
     /**
      * Get the shape the image should be viewed as.
      * @return array indicating observation HWC
@@ -71,9 +232,30 @@ public:
      */
     [[nodiscard]] auto to_image() const noexcept -> std::vector<uint8_t>;
 
+    /**
+     * Write the flat (HWC) image into a caller provided buffer, which must hold the number of bytes given by
+     * image_shape().
+     * @param img The buffer to write into
+     */
+    void to_image(uint8_t *img) const noexcept;
+
+    /**
+     * Write the image into a caller provided buffer, with a custom distance between the start of each pixel row.
+     * @param img The buffer to write into
+     * @param row_stride Number of bytes between the start of consecutive pixel rows (>= image width * channels)
+     */
+    void to_image(uint8_t *img, int row_stride) const noexcept;
+
+    /**
+     * Get the element drawn at a cell in the current state
+     * @param index The cell index
+     * @return The element
+     */
+    [[nodiscard]] auto get_element(int index) const noexcept -> Element;
+
     /**
      * Get the current reward signal as a result of the previous action taken.
-     * @return 0 if no reward, otherwise 1 if new city visited
+     * @return 0 if no reward, otherwise the number of new cities visited (1 for apply_action)
      */
     [[nodiscard]] auto get_reward_signal() const noexcept -> uint64_t;
 
@@ -83,6 +265,35 @@ public:
      */
     [[nodiscard]] auto get_hash() const noexcept -> uint64_t;
 
+    /**
+     * Get the 128 bit hash for the current state, whose low half is get_hash().
+     * The high half is only tracked when built with TSP_HASH_128, and is 0 otherwise.
+     * @return hash value
+     */
+    [[nodiscard]] auto get_hash128() const noexcept -> Hash128;
+
+    /**
+     * Get the hash of the whole board (walls included) transformed by a symmetry, which matches the identity hash of
+     * the symmetric state on the symmetric level.
+     * This is a lookup when built with TSP_CANONICAL_HASH, and otherwise a pass over the cities.
+     * @param symmetry The symmetry, which must be less than get_num_symmetries(rows, cols)
+     * @return hash value
+     */
+    [[nodiscard]] auto get_symmetry_hash(Symmetry symmetry) const -> uint64_t;
+
+    /**
+     * Get the symmetry with the smallest symmetry hash, which maps every symmetric variant of a state to the same board
+     * @return The symmetry
+     */
+    [[nodiscard]] auto get_canonical_symmetry() const -> Symmetry;
+
+    /**
+     * Get the smallest symmetry hash, which is the same for every rotation and reflection of the state (8 for square
+     * boards and 4 otherwise), e.g. to deduplicate symmetric states
+     * @return hash value
+     */
+    [[nodiscard]] auto get_canonical_hash() const -> uint64_t;
+
     /**
      * Get the agent index position, even if in exit
      * @return Agent index
@@ -96,34 +307,92 @@ public:
     [[nodiscard]] auto get_start_city_index() const noexcept -> int;
 
     /**
-     * Get the indices of the unvisited cities
+     * Get the indices of the unvisited cities, in increasing order
      * @return Vector of unvisited cities
      */
     [[nodiscard]] auto get_unvisited_city_indices() const noexcept -> std::vector<int>;
 
     /**
-     * Get the indices of the visited cities
+     * Get the indices of the visited cities, in increasing order
      * @return Vector of visited cities
      */
     [[nodiscard]] auto get_visited_city_indices() const noexcept -> std::vector<int>;
 
+    /**
+     * Call func(index) for each unvisited city index in increasing order, without allocating
+     * @param func Callable taking the city index
+     */
+    template <typename Func>
+    void for_each_unvisited_city(Func &&func) const {
+        const auto &cities = level->get_city_indices();
+        for_each_clear_bit(visited_cities, [&](int k) { func(cities[static_cast<std::size_t>(k)]); });
+    }
+
+    /**
+     * Call func(index) for each visited city index in increasing order, without allocating
+     * @param func Callable taking the city index
+     */
+    template <typename Func>
+    void for_each_visited_city(Func &&func) const {
+        const auto &cities = level->get_city_indices();
+        for_each_set_bit(visited_cities, 0, visited_cities, 0,
+                         [&](int k) { func(cities[static_cast<std::size_t>(k)]); });
+    }
+
+    /**
+     * Check if a city has been visited
+     * @param city_id The city id, indexing TSPLevel::get_city_indices()
+     * @return True if visited
+     */
+    [[nodiscard]] auto is_city_visited(int city_id) const noexcept -> bool {
+        return visited_cities.test(static_cast<std::size_t>(city_id));
+    }
+
+    /**
+     * Get the visited cities as a bitmask indexed by city id (see TSPLevel::get_city_indices())
+     * @return The bitmask, valid while the state is alive and unchanged
+     */
+    [[nodiscard]] auto get_visited_cities() const noexcept -> const CityBitset & {
+        return visited_cities;
+    }
+
+    /**
+     * Write the visited cities as a bitmask indexed by city id (see TSPLevel::get_city_indices())
+     * @param words Buffer of at least (num_cities + 63) / 64 words to write into
+     */
+    void get_visited_city_words(uint64_t *words) const noexcept;
+
+    /**
+     * Get the number of cities which have not been visited yet
+     * @return Count of unvisited cities
+     */
+    [[nodiscard]] auto get_num_unvisited_cities() const noexcept -> int;
+
+    /**
+     * Get the level the state is played on, which is shared by all copies of the state
+     * @return Shared pointer to the level
+     */
+    [[nodiscard]] auto get_level() const noexcept -> const TSPLevelPtr &;
+
     friend auto operator<<(std::ostream &os, const TSPGameState &state) -> std::ostream &;
 
 private:
-    void ParseBoard();
-    [[nodiscard]] auto IndexFromAction(std::size_t index, Action action) const noexcept -> std::size_t;
-    [[nodiscard]] auto IndexAndBoundsCheck(Action action) const noexcept -> std::pair<int, bool>;
+    [[nodiscard]] auto GetElement(int index) const noexcept -> Element;
+    [[nodiscard]] auto GetAgentElement() const noexcept -> Element;
+    void ToggleKey(Element el, int index) noexcept;
+    void ToggleSymmetryKeys(Element el, int index) noexcept;
 
-    int rows = -1;
-    int cols = -1;
+    TSPLevelPtr level;
     int agent_idx = -1;
     int start_city_idx = -1;
     int remaining_cities = 0;
+    // Hashes of the states transformed by each non-identity symmetry, only tracked when built with TSP_CANONICAL_HASH
+    std::array<uint64_t, kCanonicalHash ? kNumSymmetries - 1 : 0> symmetry_hashes{};
     uint64_t hash = 0;
+    uint64_t hash_hi = 0;
     uint64_t reward_signal = 0;
-    std::vector<bool> board_is_city;
-    std::vector<bool> visited_flags;
-    std::vector<bool> board_is_wall;
+    // Indexed by city id
+    CityBitset visited_cities;
 };
 
 }    // namespace tsp
@@ -0,0 +1,339 @@
+#include <tsp/tsp_c.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "definitions.h"
+#include "serialization.h"
+#include "thread_pool.h"
+#include "tsp_base.h"
+
+static_assert(TSP_NUM_CHANNELS == tsp::kNumChannels, "C API channel count is out of sync");
+static_assert(TSP_NUM_ACTIONS == tsp::kNumActions, "C API action count is out of sync");
+
+struct tsp_env {
+    // Initial state of each level in the sequence, shared by the environments created together
+    std::shared_ptr<const std::vector<tsp::TSPGameState>> levels;
+    tsp::TSPGameState state;
+    std::size_t level_idx;
+    std::size_t level_stride;
+    // Whether the environment has been reset or stepped, after which resets move to the next level
+    bool started = false;
+};
+
+struct tsp_pool {
+    explicit tsp_pool(int num_threads) : pool(num_threads) {}
+    tsp::ThreadPool pool;
+};
+
+namespace {
+
+thread_local std::string last_error;
+
+auto SetError(tsp_status status, const char* message) noexcept -> tsp_status {
+    try {
+        last_error = message;
+    } catch (...) {
+        last_error.clear();
+    }
+    return status;
+}
+
+// Translate the exception being handled into a status, so that no exception crosses the C boundary
+auto HandleException() noexcept -> tsp_status {
+    try {
+        throw;
+    } catch (const std::bad_alloc&) {
+        return SetError(TSP_ERROR_OUT_OF_MEMORY, "Out of memory.");
+    } catch (const std::logic_error& e) {
+        return SetError(TSP_ERROR_INVALID_ARGUMENT, e.what());
+    } catch (const std::runtime_error& e) {
+        return SetError(TSP_ERROR_IO, e.what());
+    } catch (const std::exception& e) {
+        return SetError(TSP_ERROR_INTERNAL, e.what());
+    } catch (...) {
+        return SetError(TSP_ERROR_INTERNAL, "Unknown error.");
+    }
+}
+
+// Run func(begin, end) over [0, count) on the pool, or inline without one, rethrowing the first exception
+template <typename Func>
+void ParallelFor(tsp_pool* pool, int count, const Func& func) {
+    if (pool == nullptr) {
+        func(0, count);
+        return;
+    }
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    pool->pool.parallel_for(count, [&](int begin, int end) {
+        try {
+            func(begin, end);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            error = std::current_exception();
+        }
+    });
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+// Create num_envs environments over the levels, where environment i starts on level i % levels.size()
+void CreateEnvs(std::vector<tsp::TSPGameState> initial_states, int num_envs, tsp_env** envs) {
+    if (initial_states.empty()) {
+        throw std::invalid_argument("At least one level is required.");
+    }
+    if (num_envs <= 0) {
+        throw std::invalid_argument("Number of environments must be positive.");
+    }
+    // Environments move between levels on reset, so the observation size of a batch must not change
+    const auto& first = initial_states[0].get_level();
+    for (const auto& state : initial_states) {
+        if (state.get_level()->get_rows() != first->get_rows() || state.get_level()->get_cols() != first->get_cols()) {
+            throw std::invalid_argument("All levels must have the same board size.");
+        }
+    }
+    const auto levels = std::make_shared<const std::vector<tsp::TSPGameState>>(std::move(initial_states));
+    std::vector<std::unique_ptr<tsp_env>> created;
+    created.reserve(static_cast<std::size_t>(num_envs));
+    for (int i = 0; i < num_envs; ++i) {
+        const auto level_idx = static_cast<std::size_t>(i) % levels->size();
+        created.push_back(std::make_unique<tsp_env>(tsp_env{
+            .levels = levels,
+            .state = (*levels)[level_idx],
+            .level_idx = level_idx,
+            .level_stride = static_cast<std::size_t>(num_envs),
+        }));
+    }
+    for (std::size_t i = 0; i < created.size(); ++i) {
+        envs[i] = created[i].release();
+    }
+}
+
+// Check the handles of a batch, and that they share a board size if observations are written
+auto ValidateBatch(tsp_env* const* envs, int num_envs, bool has_observations) -> tsp_status {
+    if (num_envs < 0) {
+        return SetError(TSP_ERROR_INVALID_ARGUMENT, "Number of environments must be non-negative.");
+    }
+    if (num_envs > 0 && envs == nullptr) {
+        return SetError(TSP_ERROR_INVALID_ARGUMENT, "Environment array is null.");
+    }
+    for (int i = 0; i < num_envs; ++i) {
+        if (envs[i] == nullptr) {
+            return SetError(TSP_ERROR_INVALID_ARGUMENT, "Environment handle is null.");
+        }
+    }
+    if (has_observations) {
+        const auto& first = envs[0]->state.get_level();
+        for (int i = 1; i < num_envs; ++i) {
+            const auto& level = envs[i]->state.get_level();
+            if (level->get_rows() != first->get_rows() || level->get_cols() != first->get_cols()) {
+                return SetError(TSP_ERROR_INVALID_ARGUMENT, "All environments must have the same board size.");
+            }
+        }
+    }
+    return TSP_OK;
+}
+
+auto ObservationSize(tsp_env* const* envs) noexcept -> std::size_t {
+    return static_cast<std::size_t>(tsp::kNumChannels) *
+           static_cast<std::size_t>(envs[0]->state.get_level()->get_num_cells());
+}
+
+void ResetEnv(tsp_env& env) {
+    if (env.started) {
+        env.level_idx = (env.level_idx + env.level_stride) % env.levels->size();
+    }
+    env.started = true;
+    env.state = (*env.levels)[env.level_idx];
+}
+
+}    // namespace
+
+extern "C" {
+
+int tsp_api_version(void) {
+    return TSP_C_API_VERSION;
+}
+
+const char* tsp_last_error(void) {
+    return last_error.c_str();
+}
+
+tsp_status tsp_pool_create(int num_threads, tsp_pool** pool) {
+    if (pool == nullptr) {
+        return SetError(TSP_ERROR_INVALID_ARGUMENT, "Output handle is null.");
+    }
+    try {
+        *pool = new tsp_pool(num_threads);
+        return TSP_OK;
+    } catch (...) {
+        return HandleException();
+    }
+}
+
+void tsp_pool_destroy(tsp_pool* pool) {
+    delete pool;
+}
+
+tsp_status tsp_env_create(const char* board_str, tsp_env** env) {
+    return tsp_env_create_batch(&board_str, 1, 1, env);
+}
+
+tsp_status tsp_env_create_from_file(const char* path, int num_envs, tsp_env** envs) {
+    if (path == nullptr || envs == nullptr) {
+        return SetError(TSP_ERROR_INVALID_ARGUMENT, "Path or output handle array is null.");
+    }
+    try {
+        auto levels = tsp::read_levels(path);
+        std::vector<tsp::TSPGameState> initial_states;
+        initial_states.reserve(levels.size());
+        for (auto& level : levels) {
+            initial_states.emplace_back(std::move(level));
+        }
+        CreateEnvs(std::move(initial_states), num_envs, envs);
+        return TSP_OK;
+    } catch (...) {
+        return HandleException();
+    }
+}
+
+tsp_status tsp_env_create_batch(const char* const* board_strs, int num_levels, int num_envs, tsp_env** envs) {
+    if (board_strs == nullptr || envs == nullptr) {
+        return SetError(TSP_ERROR_INVALID_ARGUMENT, "Level string or output handle array is null.");
+    }
+    try {
+        std::vector<tsp::TSPGameState> initial_states;
+        initial_states.reserve(static_cast<std::size_t>(std::max(num_levels, 0)));
+        for (int i = 0; i < num_levels; ++i) {
+            if (board_strs[i] == nullptr) {
+                return SetError(TSP_ERROR_INVALID_ARGUMENT, "Level string is null.");
+            }
+            initial_states.emplace_back(std::string(board_strs[i]));
+        }
+        CreateEnvs(std::move(initial_states), num_envs, envs);
+        return TSP_OK;
+    } catch (...) {
+        return HandleException();
+    }
+}
+
+void tsp_env_destroy(tsp_env* env) {
+    delete env;
+}
+
+void tsp_env_destroy_batch(tsp_env* const* envs, int num_envs) {
+    for (int i = 0; envs != nullptr && i < num_envs; ++i) {
+        delete envs[i];
+    }
+}
+
+tsp_status tsp_env_observation_shape(const tsp_env* env, int shape[3]) {
+    if (env == nullptr || shape == nullptr) {
+        return SetError(TSP_ERROR_INVALID_ARGUMENT, "Environment handle or shape is null.");
+    }
+    const auto obs_shape = env->state.observation_shape();
+    for (std::size_t i = 0; i < obs_shape.size(); ++i) {
+        shape[i] = obs_shape[i];
+    }
+    return TSP_OK;
+}
+
+tsp_status tsp_env_legal_action_mask(const tsp_env* env, uint8_t* mask) {
+    if (env == nullptr || mask == nullptr) {
+        return SetError(TSP_ERROR_INVALID_ARGUMENT, "Environment handle or mask is null.");
+    }
+    *mask = env->state.legal_action_mask();
+    return TSP_OK;
+}
+
+tsp_status tsp_reset(tsp_pool* pool, tsp_env* const* envs, int num_envs, float* observations, uint64_t* hashes) {
+    const bool has_observations = observations != nullptr && num_envs > 0;
+    if (const auto status = ValidateBatch(envs, num_envs, has_observations); status != TSP_OK) {
+        return status;
+    }
+    try {
+        const std::size_t obs_size = has_observations ? ObservationSize(envs) : 0;
+        ParallelFor(pool, num_envs, [&](int begin, int end) {
+            for (int i = begin; i < end; ++i) {
+                const auto idx = static_cast<std::size_t>(i);
+                auto& env = *envs[i];
+                ResetEnv(env);
+                if (observations != nullptr) {
+                    env.state.get_observation(observations + (idx * obs_size));
+                }
+                if (hashes != nullptr) {
+                    hashes[idx] = env.state.get_hash();
+                }
+            }
+        });
+        return TSP_OK;
+    } catch (...) {
+        return HandleException();
+    }
+}
+
+tsp_status tsp_step(tsp_pool* pool, tsp_env* const* envs, int num_envs, const int32_t* actions, uint32_t flags,
+                    float* observations, float* rewards, uint8_t* dones, uint64_t* hashes) {
+    const bool has_observations = observations != nullptr && num_envs > 0;
+    if (const auto status = ValidateBatch(envs, num_envs, has_observations); status != TSP_OK) {
+        return status;
+    }
+    if (num_envs > 0 && actions == nullptr) {
+        return SetError(TSP_ERROR_INVALID_ARGUMENT, "Action array is null.");
+    }
+    for (int i = 0; i < num_envs; ++i) {
+        if (actions[i] < 0 || actions[i] >= tsp::kNumActions) {
+            return SetError(TSP_ERROR_INVALID_ARGUMENT, "Action out of range.");
+        }
+    }
+    const bool auto_reset = (flags & TSP_STEP_AUTO_RESET) != 0;
+    const bool incremental = (flags & TSP_STEP_INCREMENTAL_OBSERVATIONS) != 0;
+    try {
+        const std::size_t obs_size = has_observations ? ObservationSize(envs) : 0;
+        ParallelFor(pool, num_envs, [&](int begin, int end) {
+            for (int i = begin; i < end; ++i) {
+                const auto idx = static_cast<std::size_t>(i);
+                auto& env = *envs[i];
+                env.started = true;
+                const int prev_agent_idx = env.state.get_agent_index();
+                env.state.apply_action(static_cast<tsp::Action>(actions[i]));
+                const bool solved = env.state.is_solution();
+                if (rewards != nullptr) {
+                    rewards[idx] = static_cast<float>(env.state.get_reward_signal());
+                }
+                if (dones != nullptr) {
+                    dones[idx] = static_cast<uint8_t>(solved);
+                }
+                if (hashes != nullptr) {
+                    hashes[idx] = env.state.get_hash();
+                }
+                const bool reset = auto_reset && solved;
+                if (reset) {
+                    ResetEnv(env);
+                }
+                if (observations != nullptr) {
+                    float* obs = observations + (idx * obs_size);
+                    if (incremental && !reset) {
+                        env.state.update_observation(obs, prev_agent_idx);
+                    } else {
+                        env.state.get_observation(obs);
+                    }
+                }
+            }
+        });
+        return TSP_OK;
+    } catch (...) {
+        return HandleException();
+    }
+}
+
+}    // extern "C"
@@ -0,0 +1,225 @@
+#include "tsp_level.h"
+
+#include <array>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace tsp {
+
+namespace {
+// Direction to offsets (col, row)
+using Offset = std::pair<int, int>;
+constexpr std::array<Offset, kNumActions> kActionOffsets{{
+    {0, -1},    // Action::kUp
+    {1, 0},     // Action::kRight
+    {0, 1},     // Action::kDown
+    {-1, 0},    // Action::kLeft
+}};
+static_assert(kActionOffsets.size() == kNumActions);
+
+constexpr int kDecimalBase = 10;
+
+// Parse the integer at the start of a '|' separated segment, following std::stoi: leading whitespace and a sign are
+// accepted, and anything after the digits is ignored. Advances it past the segment and its separator.
+auto ParseSegment(const char*& it, const char* end) -> int {
+    const char* p = it;
+    while (p != end && *p != '|' && std::isspace(static_cast<unsigned char>(*p))) {
+        ++p;
+    }
+    const bool negative = p != end && *p == '-';
+    p += (p != end && (*p == '-' || *p == '+')) ? 1 : 0;
+    const char* digits_begin = p;
+    int64_t value = 0;
+    while (p != end && *p >= '0' && *p <= '9') {
+        value = (value * kDecimalBase) + (*p - '0');
+        if (value > std::numeric_limits<int>::max()) {
+            throw std::out_of_range("Board value out of range.");
+        }
+        ++p;
+    }
+    if (p == digits_begin) {
+        throw std::invalid_argument("Expected an integer value in board string.");
+    }
+    const auto* separator = static_cast<const char*>(std::memchr(p, '|', static_cast<std::size_t>(end - p)));
+    it = separator == nullptr ? end : separator + 1;
+    return static_cast<int>(negative ? -value : value);
+}
+}    // namespace
+
+TSPLevel::TSPLevel(std::string_view board_str) {
+    const char* it = board_str.data();
+    const char* end = it + board_str.size();
+
+    // Check input
+    if (it == end) {
+        throw std::invalid_argument("Board string should have at minimum 3 values separated by '|'.");
+    }
+    rows = ParseSegment(it, end);
+    if (it == end) {
+        throw std::invalid_argument("Board string should have at minimum 3 values separated by '|'.");
+    }
+    cols = ParseSegment(it, end);
+    // Each cell needs at least one character, which also guards against overflow from bogus sizes
+    const auto num_cells = static_cast<int64_t>(rows) * static_cast<int64_t>(cols);
+    if (rows < 0 || cols < 0 || num_cells > end - it) {
+        throw std::invalid_argument("Supplied rows/cols does not match input board length.");
+    }
+    board_is_city = BoardBitset(static_cast<std::size_t>(num_cells));
+    board_is_wall = BoardBitset(static_cast<std::size_t>(num_cells));
+
+    // Parse
+    int cell_idx = 0;
+    for (; it != end; ++cell_idx) {
+        if (cell_idx >= num_cells) {
+            throw std::invalid_argument("Supplied rows/cols does not match input board length.");
+        }
+        int el_idx = ParseSegment(it, end);
+        if (el_idx < 0 || el_idx > 3) {
+            std::cerr << board_str << std::endl;
+            std::cerr << el_idx << std::endl;
+            throw std::invalid_argument("Unknown element type.");
+        }
+        const auto el = static_cast<Element>(el_idx);
+        bool is_city = el == Element::kCityUnvisited;
+        board_is_city.assign(static_cast<std::size_t>(cell_idx), is_city);
+        num_cities += is_city;
+        board_is_wall.assign(static_cast<std::size_t>(cell_idx), el == Element::kWall);
+        if (el == Element::kAgent) {
+            if (agent_idx != -1) {
+                throw std::invalid_argument("More than one agent.");
+            }
+            agent_idx = cell_idx;
+        }
+    }
+    if (cell_idx != num_cells) {
+        throw std::invalid_argument("Supplied rows/cols does not match input board length.");
+    }
+    if (agent_idx == -1) {
+        throw std::invalid_argument("Missing agent.");
+    }
+    BuildNeighbors();
+    BuildCityIndices();
+    BuildStaticElementCodes();
+    zobrist = ZobristTable::get(get_num_cells());
+}
+
+TSPLevel::TSPLevel(int rows_, int cols_, int agent_idx_, BoardBitset wall_layer, BoardBitset city_layer)
+    : rows(rows_),
+      cols(cols_),
+      agent_idx(agent_idx_),
+      board_is_city(std::move(city_layer)),
+      board_is_wall(std::move(wall_layer)) {
+    const auto num_cells = static_cast<int64_t>(rows) * static_cast<int64_t>(cols);
+    if (rows < 0 || cols < 0 || num_cells > std::numeric_limits<int>::max()) {
+        throw std::invalid_argument("Invalid rows/cols.");
+    }
+    if (board_is_city.size() != static_cast<std::size_t>(num_cells) ||
+        board_is_wall.size() != static_cast<std::size_t>(num_cells)) {
+        throw std::invalid_argument("Supplied rows/cols does not match the layer sizes.");
+    }
+    const uint64_t* city_words = board_is_city.data();
+    const uint64_t* wall_words = board_is_wall.data();
+    for (std::size_t i = 0; i < board_is_city.num_words(); ++i) {
+        if ((city_words[i] & wall_words[i]) != 0) {
+            throw std::invalid_argument("Cell contains both a wall and a city.");
+        }
+    }
+    if (agent_idx < 0 || agent_idx >= num_cells) {
+        throw std::invalid_argument("Missing agent.");
+    }
+    if (is_city(agent_idx) || is_wall(agent_idx)) {
+        throw std::invalid_argument("Agent must start on an empty cell.");
+    }
+    num_cities = static_cast<int>(board_is_city.count());
+    BuildNeighbors();
+    BuildCityIndices();
+    BuildStaticElementCodes();
+    zobrist = ZobristTable::get(get_num_cells());
+}
+
+auto TSPLevel::operator==(const TSPLevel& other) const noexcept -> bool {
+    return agent_idx == other.agent_idx && has_same_layout(other);
+}
+
+auto TSPLevel::operator!=(const TSPLevel& other) const noexcept -> bool {
+    return !(*this == other);
+}
+
+auto TSPLevel::has_same_layout(const TSPLevel& other) const noexcept -> bool {
+    return rows == other.rows && cols == other.cols && board_is_city == other.board_is_city &&
+           board_is_wall == other.board_is_wall;
+}
+
+auto TSPLevel::get_distances() const -> const DistanceCache& {
+    std::call_once(distances_flag, [this]() { distances = std::make_unique<DistanceCache>(*this); });
+    return *distances;
+}
+
+auto TSPLevel::get_symmetry_table() const -> const SymmetryTable& {
+    std::call_once(symmetry_flag, [this]() { BuildSymmetry(); });
+    return *symmetry_table;
+}
+
+auto TSPLevel::get_symmetry_wall_hash(Symmetry symmetry) const -> uint64_t {
+    std::call_once(symmetry_flag, [this]() { BuildSymmetry(); });
+    return symmetry_wall_hashes[static_cast<std::size_t>(symmetry)];
+}
+
+// ---------------------------------------------------------------------------
+
+void TSPLevel::BuildCityIndices() {
+    city_indices.reserve(static_cast<std::size_t>(num_cities));
+    city_ids.assign(static_cast<std::size_t>(get_num_cells()), -1);
+    for_each_set_bit(board_is_city, 0, board_is_city, 0, [&](int i) {
+        city_ids[static_cast<std::size_t>(i)] = static_cast<int>(city_indices.size());
+        city_indices.push_back(i);
+    });
+}
+
+void TSPLevel::BuildStaticElementCodes() {
+    static_element_codes.resize(static_cast<std::size_t>(get_num_cells()));
+    for (int i = 0; i < get_num_cells(); ++i) {
+        const auto el = is_city(i) ? Element::kCityUnvisited : (is_wall(i) ? Element::kWall : Element::kEmpty);
+        static_element_codes[static_cast<std::size_t>(i)] = static_cast<uint8_t>(el);
+    }
+}
+
+void TSPLevel::BuildSymmetry() const {
+    symmetry_table = SymmetryTable::get(rows, cols);
+    for (int s = 0; s < symmetry_table->get_num_symmetries(); ++s) {
+        uint64_t& wall_hash = symmetry_wall_hashes[static_cast<std::size_t>(s)];
+        for_each_set_bit(board_is_wall, 0, board_is_wall, 0, [&](int i) {
+            wall_hash ^= symmetry_table->get_key(static_cast<Symmetry>(s), Element::kWall, i);
+        });
+    }
+}
+
+void TSPLevel::BuildNeighbors() {
+    neighbors.resize(static_cast<std::size_t>(rows * cols));
+    legal_action_masks.resize(static_cast<std::size_t>(rows * cols), 0);
+    for (int row = 0; row < rows; ++row) {
+        for (int col = 0; col < cols; ++col) {
+            const auto idx = static_cast<std::size_t>((row * cols) + col);
+            int a = 0;
+            for (const auto& [col_offset, row_offset] : kActionOffsets) {
+                const int new_col = col + col_offset;
+                const int new_row = row + row_offset;
+                const bool in_bounds = new_col >= 0 && new_col < cols && new_row >= 0 && new_row < rows;
+                const int new_idx = (new_row * cols) + new_col;
+                const bool legal = in_bounds && !is_wall(new_idx);
+                neighbors[idx][static_cast<std::size_t>(a)] = legal ? new_idx : kNoNeighbor;
+                legal_action_masks[idx] |= static_cast<uint8_t>(legal ? (1 << a) : 0);
+                ++a;
+            }
+        }
+    }
+}
+
+}    // namespace tsp
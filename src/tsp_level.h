@@ -0,0 +1,235 @@
+#ifndef TSP_LEVEL_H_
+#define TSP_LEVEL_H_
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+#include "bitset.h"
+#include "definitions.h"
+#include "distance_cache.h"
+#include "symmetry.h"
+#include "zobrist.h"
+
+namespace tsp {
+
+// Neighbor index for moves which go off the board or into a wall
+constexpr int kNoNeighbor = -1;
+
+/**
+ * Static layout of a level (board size, walls, cities, and the initial agent position).
+ * A level never changes after construction, and is shared between all states which are played on it.
+ */
+class TSPLevel {
+public:
+    TSPLevel() = delete;
+    TSPLevel(std::string_view board_str);
+
+    /**
+     * Create a level from its layers, e.g. when loading a level from a binary file.
+     * @param rows Number of rows of the board
+     * @param cols Number of columns of the board
+     * @param agent_idx Starting index of the agent
+     * @param wall_layer Bitset of rows * cols cells where bit i is set if cell i contains a wall
+     * @param city_layer Bitset of rows * cols cells where bit i is set if cell i contains a city
+     * @throws std::invalid_argument if the layers don't match the board size, overlap, or the agent is not on an
+     * empty cell
+     */
+    TSPLevel(int rows, int cols, int agent_idx, BoardBitset wall_layer, BoardBitset city_layer);
+
+    TSPLevel(const TSPLevel &) = delete;
+    TSPLevel(TSPLevel &&) = delete;
+    auto operator=(const TSPLevel &) -> TSPLevel & = delete;
+    auto operator=(TSPLevel &&) -> TSPLevel & = delete;
+
+    bool operator==(const TSPLevel &other) const noexcept;
+    bool operator!=(const TSPLevel &other) const noexcept;
+
+    /**
+     * Check if two levels have the same board layout (size, walls, and cities), ignoring the initial agent position.
+     * @param other The other level to compare against
+     * @return True if the layouts match
+     */
+    [[nodiscard]] auto has_same_layout(const TSPLevel &other) const noexcept -> bool;
+
+    /**
+     * Get the number of rows of the board
+     * @return Number of rows
+     */
+    [[nodiscard]] auto get_rows() const noexcept -> int {
+        return rows;
+    }
+
+    /**
+     * Get the number of columns of the board
+     * @return Number of columns
+     */
+    [[nodiscard]] auto get_cols() const noexcept -> int {
+        return cols;
+    }
+
+    /**
+     * Get the number of cells of the board
+     * @return Number of cells (rows * cols)
+     */
+    [[nodiscard]] auto get_num_cells() const noexcept -> int {
+        return rows * cols;
+    }
+
+    /**
+     * Get the starting index of the agent
+     * @return Agent index
+     */
+    [[nodiscard]] auto get_agent_index() const noexcept -> int {
+        return agent_idx;
+    }
+
+    /**
+     * Get the total number of cities on the board
+     * @return Count of cities
+     */
+    [[nodiscard]] auto get_num_cities() const noexcept -> int {
+        return num_cities;
+    }
+
+    /**
+     * Get the cell indices of the cities, in increasing order.
+     * The position of a city in this list is its city id.
+     * @return Vector of city indices
+     */
+    [[nodiscard]] auto get_city_indices() const noexcept -> const std::vector<int> & {
+        return city_indices;
+    }
+
+    /**
+     * Get the city id of a cell, i.e. its position in get_city_indices()
+     * @param index The cell index
+     * @return The city id, or -1 if the cell is not a city
+     */
+    [[nodiscard]] auto get_city_id(int index) const noexcept -> int {
+        return city_ids[static_cast<std::size_t>(index)];
+    }
+
+    /**
+     * Get the element of each cell ignoring the agent and visits (kEmpty, kWall, or kCityUnvisited), as uint8_t codes
+     * @return Vector of element codes indexed by cell
+     */
+    [[nodiscard]] auto get_static_element_codes() const noexcept -> const std::vector<uint8_t> & {
+        return static_element_codes;
+    }
+
+    /**
+     * Check if the given cell index contains a city
+     * @param index The cell index
+     * @return True if the cell is a city
+     */
+    [[nodiscard]] auto is_city(int index) const noexcept -> bool {
+        return board_is_city.test(static_cast<std::size_t>(index));
+    }
+
+    /**
+     * Check if the given cell index contains a wall
+     * @param index The cell index
+     * @return True if the cell is a wall
+     */
+    [[nodiscard]] auto is_wall(int index) const noexcept -> bool {
+        return board_is_wall.test(static_cast<std::size_t>(index));
+    }
+
+    /**
+     * Get the cell reached by moving from the given cell, if the move is legal
+     * @param index The cell index to move from
+     * @param action The direction to move
+     * @return The neighboring cell index, or kNoNeighbor if the move is off the board or into a wall
+     */
+    [[nodiscard]] auto get_neighbor(int index, Action action) const noexcept -> int {
+        return neighbors[static_cast<std::size_t>(index)][static_cast<std::size_t>(action)];
+    }
+
+    /**
+     * Get the legal moves from the given cell as a bitmask
+     * @param index The cell index to move from
+     * @return Mask where bit a is set if moving in direction static_cast<Action>(a) is legal
+     */
+    [[nodiscard]] auto get_legal_action_mask(int index) const noexcept -> uint8_t {
+        return legal_action_masks[static_cast<std::size_t>(index)];
+    }
+
+    /**
+     * Get the shortest path distances between cells of the level.
+     * The table is built on first use (thread safe) and shared by all states on this level.
+     * @return The distance cache
+     */
+    [[nodiscard]] auto get_distances() const -> const DistanceCache &;
+
+    /**
+     * Get the Zobrist keys used to hash states on this level, which are shared with all levels of the same size
+     * @return The key table
+     */
+    [[nodiscard]] auto get_zobrist_table() const noexcept -> const ZobristTable & {
+        return *zobrist;
+    }
+
+    /**
+     * Get the city layer of the board, where bit i is set if cell i contains a city
+     * @return The city bitset
+     */
+    [[nodiscard]] auto get_city_layer() const noexcept -> const BoardBitset & {
+        return board_is_city;
+    }
+
+    /**
+     * Get the wall layer of the board, where bit i is set if cell i contains a wall
+     * @return The wall bitset
+     */
+    [[nodiscard]] auto get_wall_layer() const noexcept -> const BoardBitset & {
+        return board_is_wall;
+    }
+
+    /**
+     * Get the cell permutations and Zobrist keys of the board shape's symmetries, building them on first use
+     * @return The symmetry table
+     */
+    [[nodiscard]] auto get_symmetry_table() const -> const SymmetryTable &;
+
+    /**
+     * Get the hash of the walls moved by a symmetry, which is combined with the state hash so that canonical hashes
+     * only match between boards with the same walls
+     * @param symmetry The symmetry, which must be less than get_num_symmetries(rows, cols)
+     * @return The hash of the transformed walls
+     */
+    [[nodiscard]] auto get_symmetry_wall_hash(Symmetry symmetry) const -> uint64_t;
+
+private:
+    void BuildNeighbors();
+    void BuildCityIndices();
+    void BuildStaticElementCodes();
+    void BuildSymmetry() const;
+
+    int rows = -1;
+    int cols = -1;
+    int agent_idx = -1;
+    int num_cities = 0;
+    BoardBitset board_is_city;
+    BoardBitset board_is_wall;
+    std::vector<int> city_indices;
+    std::vector<int> city_ids;
+    std::vector<uint8_t> static_element_codes;
+    std::vector<std::array<int, kNumActions>> neighbors;
+    std::vector<uint8_t> legal_action_masks;
+    std::shared_ptr<const ZobristTable> zobrist;
+    mutable std::once_flag distances_flag;
+    mutable std::unique_ptr<DistanceCache> distances;
+    mutable std::once_flag symmetry_flag;
+    mutable std::shared_ptr<const SymmetryTable> symmetry_table;
+    mutable std::array<uint64_t, kNumSymmetries> symmetry_wall_hashes{};
+};
+
+using TSPLevelPtr = std::shared_ptr<const TSPLevel>;
+
+}    // namespace tsp
+
+#endif    // TSP_LEVEL_H_
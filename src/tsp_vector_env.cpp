@@ -0,0 +1,112 @@
+#include "tsp_vector_env.h"
+
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+
+namespace tsp {
+
+TSPVectorEnv::TSPVectorEnv(std::vector<TSPLevelPtr> levels, int num_envs, int num_threads, bool auto_reset_)
+    : auto_reset(auto_reset_), pool(num_threads) {
+    if (levels.empty()) {
+        throw std::invalid_argument("At least one level is required.");
+    }
+    if (num_envs <= 0) {
+        throw std::invalid_argument("Number of environments must be positive.");
+    }
+    for (const auto& level : levels) {
+        if (level->get_rows() != levels[0]->get_rows() || level->get_cols() != levels[0]->get_cols()) {
+            throw std::invalid_argument("All levels must have the same board size.");
+        }
+    }
+
+    initial_states.reserve(levels.size());
+    for (auto& level : levels) {
+        initial_states.emplace_back(std::move(level));
+    }
+    states.reserve(static_cast<std::size_t>(num_envs));
+    for (int i = 0; i < num_envs; ++i) {
+        states.push_back(initial_states[static_cast<std::size_t>(i) % initial_states.size()]);
+    }
+
+    obs_size = kNumChannels * initial_states[0].get_level()->get_num_cells();
+    episode_counts.resize(static_cast<std::size_t>(num_envs), 0);
+    observations.resize(static_cast<std::size_t>(num_envs) * static_cast<std::size_t>(obs_size));
+    rewards.resize(static_cast<std::size_t>(num_envs), 0);
+    solutions.resize(static_cast<std::size_t>(num_envs), 0);
+    hashes.resize(static_cast<std::size_t>(num_envs), 0);
+    reset();
+}
+
+auto TSPVectorEnv::num_envs() const noexcept -> int {
+    return static_cast<int>(states.size());
+}
+
+auto TSPVectorEnv::observation_shape() const noexcept -> std::array<int, 3> {
+    return initial_states[0].observation_shape();
+}
+
+void TSPVectorEnv::reset() {
+    pool.parallel_for(num_envs(), [&](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            const auto idx = static_cast<std::size_t>(i);
+            episode_counts[idx] = 0;
+            ResetEnv(i);
+            rewards[idx] = 0;
+            solutions[idx] = 0;
+            hashes[idx] = states[idx].get_hash();
+        }
+    });
+}
+
+void TSPVectorEnv::step(const Action* actions) {
+    pool.parallel_for(num_envs(), [&](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            const auto idx = static_cast<std::size_t>(i);
+            auto& state = states[idx];
+            const int prev_agent_idx = state.get_agent_index();
+            state.apply_action(actions[idx]);
+            rewards[idx] = static_cast<float>(state.get_reward_signal());
+            solutions[idx] = static_cast<uint8_t>(state.is_solution());
+            hashes[idx] = state.get_hash();
+            if (auto_reset && solutions[idx]) {
+                ++episode_counts[idx];
+                ResetEnv(i);
+            } else {
+                state.update_observation(&observations[idx * static_cast<std::size_t>(obs_size)], prev_agent_idx);
+            }
+        }
+    });
+}
+
+auto TSPVectorEnv::get_observations() const noexcept -> const std::vector<float> & {
+    return observations;
+}
+
+auto TSPVectorEnv::get_rewards() const noexcept -> const std::vector<float> & {
+    return rewards;
+}
+
+auto TSPVectorEnv::get_solutions() const noexcept -> const std::vector<uint8_t> & {
+    return solutions;
+}
+
+auto TSPVectorEnv::get_hashes() const noexcept -> const std::vector<uint64_t> & {
+    return hashes;
+}
+
+auto TSPVectorEnv::get_state(int env_idx) const noexcept -> const TSPGameState & {
+    return states[static_cast<std::size_t>(env_idx)];
+}
+
+// ---------------------------------------------------------------------------
+
+void TSPVectorEnv::ResetEnv(int env_idx) {
+    const auto idx = static_cast<std::size_t>(env_idx);
+    const auto level_idx =
+        (idx + (static_cast<std::size_t>(episode_counts[idx]) * states.size())) % initial_states.size();
+    states[idx] = initial_states[level_idx];
+    states[idx].get_observation(&observations[idx * static_cast<std::size_t>(obs_size)]);
+}
+
+}    // namespace tsp
@@ -0,0 +1,105 @@
+#ifndef TSP_VECTOR_ENV_H_
+#define TSP_VECTOR_ENV_H_
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "definitions.h"
+#include "thread_pool.h"
+#include "tsp_base.h"
+#include "tsp_level.h"
+
+namespace tsp {
+
+/**
+ * A batch of environments which are stepped together over a thread pool.
+ * Per step outputs are stored as contiguous arrays indexed by environment, with the observations stacked as NCHW.
+ */
+class TSPVectorEnv {
+public:
+    TSPVectorEnv() = delete;
+
+    /**
+     * @param levels Levels to play, which must all have the same board size. Environment i starts on level
+     * i % levels.size(), and each reset moves it num_envs levels forward
+     * @param num_envs Number of environments
+     * @param num_threads Number of threads to step with, or <= 0 to use the hardware concurrency
+     * @param auto_reset Reset environments to their next level once the solution is reached
+     */
+    TSPVectorEnv(std::vector<TSPLevelPtr> levels, int num_envs, int num_threads = 1, bool auto_reset = true);
+
+    /**
+     * Get the number of environments
+     * @return Number of environments
+     */
+    [[nodiscard]] auto num_envs() const noexcept -> int;
+
+    /**
+     * Get the shape of the observation for a single environment
+     * @return array indicating observation CHW
+     */
+    [[nodiscard]] auto observation_shape() const noexcept -> std::array<int, 3>;
+
+    /**
+     * Reset all environments to the first level in their sequence, and refresh all outputs.
+     */
+    void reset();
+
+    /**
+     * Apply one action to each environment in parallel, and write the outputs.
+     * If auto reset is enabled, environments which reach the solution are reset to their next level. Their reward,
+     * solution flag and hash describe the step which solved the level, while their observation is of the new level.
+     * @param actions Array of num_envs() actions
+     */
+    void step(const Action *actions);
+
+    /**
+     * Get the stacked observations, viewed as num_envs() x observation_shape()
+     * @return Flat NCHW observations
+     */
+    [[nodiscard]] auto get_observations() const noexcept -> const std::vector<float> &;
+
+    /**
+     * Get the reward signal of each environment from the last step
+     * @return Rewards indexed by environment
+     */
+    [[nodiscard]] auto get_rewards() const noexcept -> const std::vector<float> &;
+
+    /**
+     * Get whether each environment reached the solution on the last step
+     * @return 1 if solved, 0 otherwise, indexed by environment
+     */
+    [[nodiscard]] auto get_solutions() const noexcept -> const std::vector<uint8_t> &;
+
+    /**
+     * Get the state hash of each environment after the last step (before any auto reset)
+     * @return Hashes indexed by environment
+     */
+    [[nodiscard]] auto get_hashes() const noexcept -> const std::vector<uint64_t> &;
+
+    /**
+     * Get the current state of an environment
+     * @param env_idx The environment index
+     * @return The state
+     */
+    [[nodiscard]] auto get_state(int env_idx) const noexcept -> const TSPGameState &;
+
+private:
+    void ResetEnv(int env_idx);
+
+    std::vector<TSPGameState> initial_states;
+    std::vector<TSPGameState> states;
+    std::vector<int> episode_counts;
+    std::vector<float> observations;
+    std::vector<float> rewards;
+    std::vector<uint8_t> solutions;
+    std::vector<uint64_t> hashes;
+    int obs_size = 0;
+    bool auto_reset = true;
+    ThreadPool pool;
+};
+
+}    // namespace tsp
+
+#endif    // TSP_VECTOR_ENV_H_
@@ -0,0 +1,91 @@
+#ifndef TSP_WORK_STEALING_H_
+#define TSP_WORK_STEALING_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace tsp {
+
+/**
+ * Lock-free work stealing scheduler over the indices [0, count).
+ * Each worker starts with an even share of the indices and takes them from the front of its own range. A worker whose
+ * range is empty steals the back half of another worker's range, so uneven work (e.g. rollouts ending at different
+ * depths) balances without a shared counter being touched on every index.
+ */
+class WorkStealingRanges {
+public:
+    WorkStealingRanges() = delete;
+
+    /**
+     * @param count Number of indices, which must fit in 32 bits
+     * @param num_workers Number of workers
+     */
+    WorkStealingRanges(int count, int num_workers_)
+        : num_workers(num_workers_), ranges(new Range[static_cast<std::size_t>(num_workers_)]) {
+        for (int w = 0; w < num_workers; ++w) {
+            const auto begin = static_cast<uint32_t>((static_cast<int64_t>(count) * w) / num_workers);
+            const auto end = static_cast<uint32_t>((static_cast<int64_t>(count) * (w + 1)) / num_workers);
+            ranges[static_cast<std::size_t>(w)].bounds.store(Pack(begin, end), std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * Get the next index for a worker. Each index is handed out exactly once across all workers.
+     * @param worker The worker id, in [0, num_workers)
+     * @param index Set to the next index
+     * @return True if an index was found, false once no work is left
+     */
+    auto next(int worker, int &index) noexcept -> bool {
+        auto &own = ranges[static_cast<std::size_t>(worker)].bounds;
+        uint64_t bounds = own.load(std::memory_order_acquire);
+        while (Begin(bounds) < End(bounds)) {
+            if (own.compare_exchange_weak(bounds, Pack(Begin(bounds) + 1, End(bounds)), std::memory_order_acq_rel)) {
+                index = static_cast<int>(Begin(bounds));
+                return true;
+            }
+        }
+        return Steal(worker, index);
+    }
+
+private:
+    struct alignas(64) Range {
+        std::atomic<uint64_t> bounds{0};
+    };
+
+    static constexpr auto Pack(uint32_t begin, uint32_t end) noexcept -> uint64_t {
+        return (static_cast<uint64_t>(begin) << 32) | end;
+    }
+    static constexpr auto Begin(uint64_t bounds) noexcept -> uint32_t {
+        return static_cast<uint32_t>(bounds >> 32);
+    }
+    static constexpr auto End(uint64_t bounds) noexcept -> uint32_t {
+        return static_cast<uint32_t>(bounds);
+    }
+
+    // Take the back half of the first non-empty range after the worker's own, keeping one index and queueing the rest
+    auto Steal(int worker, int &index) noexcept -> bool {
+        for (int offset = 1; offset < num_workers; ++offset) {
+            auto &victim = ranges[static_cast<std::size_t>((worker + offset) % num_workers)].bounds;
+            uint64_t bounds = victim.load(std::memory_order_acquire);
+            while (Begin(bounds) < End(bounds)) {
+                const uint32_t mid = Begin(bounds) + ((End(bounds) - Begin(bounds)) / 2);
+                if (victim.compare_exchange_weak(bounds, Pack(Begin(bounds), mid), std::memory_order_acq_rel)) {
+                    // Other thieves skip empty ranges and the owner is this thread, so nothing else writes it
+                    ranges[static_cast<std::size_t>(worker)].bounds.store(Pack(mid + 1, End(bounds)),
+                                                                          std::memory_order_release);
+                    index = static_cast<int>(mid);
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    int num_workers;
+    std::unique_ptr<Range[]> ranges;
+};
+
+}    // namespace tsp
+
+#endif    // TSP_WORK_STEALING_H_
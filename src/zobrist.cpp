@@ -0,0 +1,54 @@
+#include "zobrist.h"
+
+#include <mutex>
+#include <unordered_map>
+
+namespace tsp {
+
+namespace {
+// https://en.wikipedia.org/wiki/Xorshift
+// Portable RNG Seed
+constexpr uint64_t SPLIT64_S1 = 30;
+constexpr uint64_t SPLIT64_S2 = 27;
+constexpr uint64_t SPLIT64_S3 = 31;
+constexpr uint64_t SPLIT64_C1 = 0x9E3779B97f4A7C15;
+constexpr uint64_t SPLIT64_C2 = 0xBF58476D1CE4E5B9;
+constexpr uint64_t SPLIT64_C3 = 0x94D049BB133111EB;
+}    // namespace
+
+auto splitmix64(uint64_t seed) noexcept -> uint64_t {
+    uint64_t result = seed + SPLIT64_C1;
+    result = (result ^ (result >> SPLIT64_S1)) * SPLIT64_C2;
+    result = (result ^ (result >> SPLIT64_S2)) * SPLIT64_C3;
+    return result ^ (result >> SPLIT64_S3);
+}
+
+ZobristTable::ZobristTable(int num_cells_) : num_cells(static_cast<std::size_t>(num_cells_)) {
+    // The mixer is a bijection, so every key of both lanes is distinct
+    const std::size_t num_keys = kNumElements * num_cells;
+    keys.resize(num_keys);
+    for (std::size_t i = 0; i < num_keys; ++i) {
+        keys[i] = splitmix64(i);
+    }
+    if constexpr (kHash128) {
+        keys_hi.resize(num_keys);
+        for (std::size_t i = 0; i < num_keys; ++i) {
+            keys_hi[i] = splitmix64(num_keys + i);
+        }
+    }
+}
+
+auto ZobristTable::get(int num_cells) -> std::shared_ptr<const ZobristTable> {
+    static std::mutex mutex;
+    static std::unordered_map<int, std::weak_ptr<const ZobristTable>> tables;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& entry = tables[num_cells];
+    auto table = entry.lock();
+    if (!table) {
+        table = std::make_shared<const ZobristTable>(num_cells);
+        entry = table;
+    }
+    return table;
+}
+
+}    // namespace tsp
@@ -0,0 +1,109 @@
+#ifndef TSP_ZOBRIST_H_
+#define TSP_ZOBRIST_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "definitions.h"
+
+// Set to 1 to additionally track a second 64 bit hash lane in each state (see TSPGameState::get_hash128()), for
+// transposition tables large enough that 64 bit hashes would collide.
+#ifndef TSP_HASH_128
+#define TSP_HASH_128 0
+#endif
+
+namespace tsp {
+
+constexpr bool kHash128 = TSP_HASH_128 != 0;
+
+/**
+ * Portable 64 bit mixer (splitmix64), which is a bijection on its input.
+ * @param seed The value to mix
+ * @return The mixed value
+ */
+[[nodiscard]] auto splitmix64(uint64_t seed) noexcept -> uint64_t;
+
+/**
+ * 128 bit state hash, where lo is the 64 bit hash given by TSPGameState::get_hash()
+ */
+struct Hash128 {
+    uint64_t lo = 0;
+    uint64_t hi = 0;
+
+    bool operator==(const Hash128 &other) const noexcept {
+        return lo == other.lo && hi == other.hi;
+    }
+    bool operator!=(const Hash128 &other) const noexcept {
+        return !(*this == other);
+    }
+    auto operator^=(const Hash128 &other) noexcept -> Hash128 & {
+        lo ^= other.lo;
+        hi ^= other.hi;
+        return *this;
+    }
+};
+
+/**
+ * Zobrist keys for each (element, cell) pair of a board, which are XORed together to hash a state.
+ * Keys only depend on the number of cells, so one table is shared by every level of the same size.
+ */
+class ZobristTable {
+public:
+    ZobristTable() = delete;
+
+    /**
+     * Generate the keys for a board size. Prefer get() to share tables between levels.
+     * @param num_cells Number of cells of the board
+     */
+    explicit ZobristTable(int num_cells);
+
+    /**
+     * Get the shared table for a board size, generating it if no level of that size is alive.
+     * @param num_cells Number of cells of the board
+     * @return The table
+     */
+    [[nodiscard]] static auto get(int num_cells) -> std::shared_ptr<const ZobristTable>;
+
+    /**
+     * Get the key of an element at a cell
+     * @param el The element
+     * @param index The cell index
+     * @return The key
+     */
+    [[nodiscard]] auto get_key(Element el, int index) const noexcept -> uint64_t {
+        return keys[(static_cast<std::size_t>(el) * num_cells) + static_cast<std::size_t>(index)];
+    }
+
+    /**
+     * Get the keys of an element at a cell for both hash lanes
+     * @param el The element
+     * @param index The cell index
+     * @return The keys, where the high lane is 0 unless built with TSP_HASH_128
+     */
+    [[nodiscard]] auto get_keys(Element el, int index) const noexcept -> Hash128 {
+        const std::size_t i = (static_cast<std::size_t>(el) * num_cells) + static_cast<std::size_t>(index);
+        if constexpr (kHash128) {
+            return {.lo = keys[i], .hi = keys_hi[i]};
+        }
+        return {.lo = keys[i], .hi = 0};
+    }
+
+    /**
+     * Get the number of cells the table holds keys for
+     * @return Number of cells
+     */
+    [[nodiscard]] auto get_num_cells() const noexcept -> int {
+        return static_cast<int>(num_cells);
+    }
+
+private:
+    std::size_t num_cells;
+    std::vector<uint64_t> keys;
+    std::vector<uint64_t> keys_hi;
+};
+
+}    // namespace tsp
+
+#endif    // TSP_ZOBRIST_H_
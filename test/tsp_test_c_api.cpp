@@ -0,0 +1,143 @@
+#include <tsp/tsp.h>
+#include <tsp/tsp_c.h>
+
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace tsp;
+
+constexpr int NUM_LEVELS = 5;
+constexpr int NUM_ENVS = 64;
+constexpr int NUM_STEPS = 500;
+constexpr int NUM_THREADS = 3;
+
+namespace {
+const std::string kSmallBoard = "3|3|01|00|03|00|00|00|00|00|00";
+
+// The C API steps the same trajectories as TSPVectorEnv, writing the same outputs into caller buffers
+auto test_matches_vector_env(const std::string &path) -> bool {
+    const GeneratorOptions options{.map_size = 8, .num_cities = 3, .add_walls = true};
+    std::vector<TSPLevelPtr> levels;
+    for (int i = 0; i < NUM_LEVELS; ++i) {
+        levels.push_back(generate_level(options, static_cast<uint64_t>(i)));
+    }
+    write_levels(path, levels);
+    TSPVectorEnv vec_env(levels, NUM_ENVS);
+
+    std::vector<tsp_env *> envs(NUM_ENVS, nullptr);
+    tsp_pool *pool = nullptr;
+    if (tsp_env_create_from_file(path.c_str(), NUM_ENVS, envs.data()) != TSP_OK ||
+        tsp_pool_create(NUM_THREADS, &pool) != TSP_OK) {
+        return false;
+    }
+    int shape[3] = {0, 0, 0};
+    if (tsp_env_observation_shape(envs[0], shape) != TSP_OK || shape[0] != TSP_NUM_CHANNELS ||
+        shape[1] != options.map_size || shape[2] != options.map_size) {
+        return false;
+    }
+
+    const auto obs_size = static_cast<std::size_t>(shape[0] * shape[1] * shape[2]);
+    std::vector<float> observations(NUM_ENVS * obs_size);
+    std::vector<float> rewards(NUM_ENVS);
+    std::vector<uint8_t> dones(NUM_ENVS);
+    std::vector<uint64_t> hashes(NUM_ENVS);
+    bool passed = tsp_reset(pool, envs.data(), NUM_ENVS, observations.data(), hashes.data()) == TSP_OK &&
+                  observations == vec_env.get_observations() && hashes == vec_env.get_hashes();
+
+    std::mt19937 rng(0);
+    std::vector<int32_t> actions(NUM_ENVS);
+    std::vector<Action> vec_actions(NUM_ENVS);
+    int num_solved = 0;
+    for (int step = 0; passed && step < NUM_STEPS; ++step) {
+        for (int i = 0; i < NUM_ENVS; ++i) {
+            actions[static_cast<std::size_t>(i)] = static_cast<int32_t>(rng() % kNumActions);
+            vec_actions[static_cast<std::size_t>(i)] = static_cast<Action>(actions[static_cast<std::size_t>(i)]);
+        }
+        // Alternate between incremental and full observation writes, which must agree
+        const uint32_t flags = TSP_STEP_AUTO_RESET | (step % 2 == 0 ? TSP_STEP_INCREMENTAL_OBSERVATIONS : 0);
+        vec_env.step(vec_actions.data());
+        passed = tsp_step(pool, envs.data(), NUM_ENVS, actions.data(), flags, observations.data(), rewards.data(),
+                          dones.data(), hashes.data()) == TSP_OK &&
+                 observations == vec_env.get_observations() && rewards == vec_env.get_rewards() &&
+                 dones == vec_env.get_solutions() && hashes == vec_env.get_hashes();
+        for (const auto done : dones) {
+            num_solved += done;
+        }
+    }
+
+    tsp_env_destroy_batch(envs.data(), NUM_ENVS);
+    tsp_pool_destroy(pool);
+    return passed && num_solved > 0;
+}
+
+// Without auto reset, a solved environment stays solved until it is reset, and resets replay its level
+auto test_single_env() -> bool {
+    tsp_env *env = nullptr;
+    if (tsp_env_create(kSmallBoard.c_str(), &env) != TSP_OK) {
+        return false;
+    }
+    uint64_t initial_hash = 0;
+    uint8_t mask = 0;
+    bool passed = tsp_reset(nullptr, &env, 1, nullptr, &initial_hash) == TSP_OK &&
+                  tsp_env_legal_action_mask(env, &mask) == TSP_OK && mask == ((1 << 1) | (1 << 2));
+    const int32_t right = static_cast<int32_t>(Action::kRight);
+    float reward = 0;
+    uint8_t done = 0;
+    uint64_t hash = 0;
+    for (int i = 0; i < 2; ++i) {
+        passed = passed && tsp_step(nullptr, &env, 1, &right, 0, nullptr, &reward, &done, &hash) == TSP_OK;
+    }
+    passed = passed && done == 1 && reward == 1 && hash != initial_hash;
+    uint64_t reset_hash = 0;
+    passed = passed && tsp_reset(nullptr, &env, 1, nullptr, &reset_hash) == TSP_OK && reset_hash == initial_hash;
+    tsp_env_destroy(env);
+    return passed;
+}
+
+// Errors are reported by status and message, and leave the environments unchanged
+auto test_errors(const std::string &path) -> bool {
+    tsp_env *env = nullptr;
+    if (tsp_env_create("3|3|00", &env) != TSP_ERROR_INVALID_ARGUMENT || env != nullptr ||
+        std::string(tsp_last_error()).empty()) {
+        return false;
+    }
+    std::remove(path.c_str());
+    if (tsp_env_create_from_file(path.c_str(), 1, &env) != TSP_ERROR_IO || env != nullptr) {
+        return false;
+    }
+
+    const char *board_strs[] = {kSmallBoard.c_str(), "2|2|01|00|00|03"};
+    std::vector<tsp_env *> envs(2, nullptr);
+    if (tsp_env_create_batch(board_strs, 2, 2, envs.data()) != TSP_ERROR_INVALID_ARGUMENT ||
+        tsp_env_create_batch(board_strs + 1, 1, 1, &envs[1]) != TSP_OK ||
+        tsp_env_create(kSmallBoard.c_str(), &envs[0]) != TSP_OK) {
+        return false;
+    }
+    std::vector<uint64_t> before(2);
+    std::vector<uint64_t> after(2);
+    std::vector<float> observations(2 * TSP_NUM_CHANNELS * 9);
+    const std::vector<int32_t> bad_actions{1, TSP_NUM_ACTIONS};
+    const bool passed =
+        tsp_reset(nullptr, envs.data(), 2, nullptr, before.data()) == TSP_OK &&
+        tsp_step(nullptr, envs.data(), 2, bad_actions.data(), 0, nullptr, nullptr, nullptr, nullptr) ==
+            TSP_ERROR_INVALID_ARGUMENT &&
+        tsp_reset(nullptr, envs.data(), 2, observations.data(), nullptr) == TSP_ERROR_INVALID_ARGUMENT &&
+        tsp_step(nullptr, envs.data(), 0, nullptr, 0, nullptr, nullptr, nullptr, nullptr) == TSP_OK &&
+        tsp_step(nullptr, envs.data(), 2, bad_actions.data(), 0, nullptr, nullptr, nullptr, after.data()) != TSP_OK &&
+        tsp_reset(nullptr, envs.data(), 2, nullptr, after.data()) == TSP_OK && before == after;
+    tsp_env_destroy_batch(envs.data(), 2);
+    return passed;
+}
+}    // namespace
+
+int main() {
+    const std::string path = "tsp_test_c_api.bin";
+    const bool passed = tsp_api_version() == TSP_C_API_VERSION && test_matches_vector_env(path) &&
+                        test_single_env() && test_errors(path);
+    std::remove(path.c_str());
+    std::cout << (passed ? "passed" : "failed") << std::endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,64 @@
+#include <tsp/tsp.h>
+
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace tsp;
+
+constexpr int NUM_STEPS = 4000;
+
+namespace {
+// City queries match a scan over every cell of the board
+auto check_cities(const TSPGameState &state) -> bool {
+    const auto &level = *state.get_level();
+    std::vector<int> expected_unvisited;
+    std::vector<int> expected_visited;
+    for (int i = 0; i < level.get_num_cells(); ++i) {
+        const int city_id = level.get_city_id(i);
+        if (level.is_city(i) != (city_id >= 0) ||
+            (city_id >= 0 && level.get_city_indices()[static_cast<std::size_t>(city_id)] != i)) {
+            return false;
+        }
+        const auto el = state.get_element(i);
+        if (el == Element::kCityUnvisited) {
+            expected_unvisited.push_back(i);
+        } else if (level.is_city(i)) {
+            expected_visited.push_back(i);
+        }
+    }
+    std::vector<int> visited;
+    state.for_each_visited_city([&](int i) { visited.push_back(i); });
+    int num_flagged = 0;
+    for (int k = 0; k < level.get_num_cities(); ++k) {
+        num_flagged += state.is_city_visited(k) ? 1 : 0;
+    }
+    return state.get_unvisited_city_indices() == expected_unvisited &&
+           state.get_visited_city_indices() == expected_visited && visited == expected_visited &&
+           num_flagged == static_cast<int>(expected_visited.size()) &&
+           static_cast<int>(state.get_visited_cities().count()) == num_flagged &&
+           state.get_num_unvisited_cities() == static_cast<int>(expected_unvisited.size());
+}
+
+auto test_random_play(const GeneratorOptions &options) -> bool {
+    std::mt19937 rng(0);
+    TSPGameState state(generate_level(options, 0));
+    for (int step = 0; step < NUM_STEPS; ++step) {
+        if (step % 100 == 0 && !check_cities(state)) {
+            std::cerr << "City lists differ on a " << options.map_size << "x" << options.map_size << " board after "
+                      << step << " steps" << std::endl;
+            return false;
+        }
+        state.apply_action(static_cast<Action>(rng() % kNumActions));
+    }
+    return check_cities(state);
+}
+}    // namespace
+
+int main() {
+    // Large sparse board, and a board with more cities than are stored inline
+    bool passed = test_random_play({.map_size = 128, .num_cities = 12, .add_walls = true});
+    passed = passed && test_random_play({.map_size = 16, .num_cities = 200});
+    std::cout << (passed ? "passed" : "failed") << std::endl;
+    return passed ? 0 : 1;
+}
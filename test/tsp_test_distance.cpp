@@ -0,0 +1,111 @@
+#include <tsp/tsp.h>
+
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace tsp;
+
+namespace {
+// Reference BFS over row/col coordinates, independent of the level neighbor table
+auto reference_distances(const TSPLevel &level, int source) -> std::vector<int> {
+    const int rows = level.get_rows();
+    const int cols = level.get_cols();
+    std::vector<int> distances(static_cast<std::size_t>(rows * cols), kUnreachable);
+    if (level.is_wall(source)) {
+        return distances;
+    }
+    std::vector<int> queue{source};
+    distances[static_cast<std::size_t>(source)] = 0;
+    for (std::size_t head = 0; head < queue.size(); ++head) {
+        const int idx = queue[head];
+        const int row = idx / cols;
+        const int col = idx % cols;
+        const std::vector<std::pair<int, int>> moves{{row - 1, col}, {row, col + 1}, {row + 1, col}, {row, col - 1}};
+        for (const auto &[r, c] : moves) {
+            const int n = (r * cols) + c;
+            if (r >= 0 && r < rows && c >= 0 && c < cols && !level.is_wall(n) &&
+                distances[static_cast<std::size_t>(n)] == kUnreachable) {
+                distances[static_cast<std::size_t>(n)] = distances[static_cast<std::size_t>(idx)] + 1;
+                queue.push_back(n);
+            }
+        }
+    }
+    return distances;
+}
+
+auto test_distances(const std::string &board_str) -> bool {
+    const auto level = std::make_shared<const TSPLevel>(board_str);
+    const DistanceCache cities_only(*level, {.max_bytes = 0, .num_threads = 1});
+    const DistanceCache parallel(*level, {.max_bytes = std::size_t{1} << 30, .num_threads = 4});
+    const auto &shared = level->get_distances();
+    if (cities_only.has_all_pairs() || !parallel.has_all_pairs()) {
+        std::cerr << "Unexpected memory bound" << std::endl;
+        return false;
+    }
+
+    for (int from = 0; from < level->get_num_cells(); ++from) {
+        const auto expected = reference_distances(*level, from);
+        for (int to = 0; to < level->get_num_cells(); ++to) {
+            const int d = expected[static_cast<std::size_t>(to)];
+            if (shared.distance(from, to) != d || parallel.distance(from, to) != d ||
+                cities_only.distance(from, to) != d) {
+                std::cerr << "Distance mismatch from " << from << " to " << to << std::endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Distances of kUnreachable or more moves can't be stored, so boards with such paths are rejected
+auto test_long_corridor() -> bool {
+    const auto make_corridor = [](int length) {
+        std::string board_str = "1|" + std::to_string(length) + "|01";
+        for (int i = 1; i < length; ++i) {
+            board_str += i == length - 1 ? "|03" : "|00";
+        }
+        return std::make_shared<const TSPLevel>(board_str);
+    };
+    // The far end is kUnreachable - 1 moves away, the longest distance which fits
+    const auto longest = make_corridor(kUnreachable);
+    std::vector<uint16_t> distances(static_cast<std::size_t>(longest->get_num_cells()));
+    compute_distances(*longest, 0, distances.data());
+    const DistanceCache cache(*longest);
+    if (distances.back() != kUnreachable - 1 || cache.distance(0, kUnreachable - 1) != kUnreachable - 1) {
+        return false;
+    }
+
+    const auto too_long = make_corridor(kUnreachable + 1);
+    distances.resize(static_cast<std::size_t>(too_long->get_num_cells()));
+    for (int num_threads : {1, 2}) {
+        try {
+            const DistanceCache cache(*too_long, {.num_threads = num_threads});
+            return false;
+        } catch (const std::invalid_argument &) {
+        }
+    }
+    try {
+        compute_distances(*too_long, 0, distances.data());
+        return false;
+    } catch (const std::invalid_argument &) {
+    }
+    return true;
+}
+}    // namespace
+
+int main() {
+    const std::string board_str =
+        "12|12|02|00|00|00|00|00|00|00|00|00|00|02|00|02|00|00|00|00|00|00|00|00|02|00|00|00|02|00|00|00|00|00|00|02|"
+        "00|00|00|00|00|02|00|00|00|00|02|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|"
+        "00|00|00|00|00|00|00|00|00|00|00|00|03|00|00|03|00|00|00|00|00|00|00|00|00|00|00|00|00|02|00|03|00|00|02|00|"
+        "00|00|00|00|02|00|00|00|00|00|00|02|00|00|00|02|00|00|00|03|00|00|01|00|02|00|02|00|00|00|00|00|00|00|00|00|"
+        "00|02";
+    // Enclosed city in the top left corner
+    const std::string walled_str = "4|4|03|02|00|00|02|00|00|03|00|00|01|00|00|00|00|00";
+    const bool passed = test_distances(board_str) && test_distances(walled_str) && test_long_corridor();
+    std::cout << (passed ? "passed" : "failed") << std::endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,116 @@
+#include <tsp/tsp.h>
+
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <set>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+using namespace tsp;
+
+constexpr std::size_t MAX_STATES_PER_LEVEL = 4096;
+constexpr int TRUNCATED_BITS = 16;
+constexpr double MAX_COLLISION_RATIO = 1.1;
+constexpr double COLLISION_SLACK = 10;
+
+namespace {
+struct StateHash {
+    auto operator()(const TSPGameState &state) const noexcept -> std::size_t {
+        return static_cast<std::size_t>(state.get_hash());
+    }
+};
+
+struct CollisionStats {
+    uint64_t num_states = 0;
+    uint64_t collisions = 0;
+    uint64_t collisions_128 = 0;
+    uint64_t collisions_low = 0;
+    uint64_t collisions_high = 0;
+    double expected_truncated = 0;
+};
+
+// Distinct states reachable from the initial state in breadth first order, compared exactly
+auto enumerate_states(const TSPLevelPtr &level) -> std::vector<TSPGameState> {
+    std::unordered_set<TSPGameState, StateHash> seen;
+    std::deque<TSPGameState> open{TSPGameState(level)};
+    std::vector<TSPGameState> states;
+    seen.insert(open.front());
+    while (!open.empty() && states.size() < MAX_STATES_PER_LEVEL) {
+        states.push_back(open.front());
+        open.pop_front();
+        for (int a = 0; a < kNumActions; ++a) {
+            auto child = states.back();
+            child.apply_action(static_cast<Action>(a));
+            if (seen.insert(child).second) {
+                open.push_back(child);
+            }
+        }
+    }
+    return states;
+}
+
+// Number of values which land in an occupied bucket when throwing n values into m buckets
+auto expected_collisions(double n, double m) -> double {
+    return n - (m * (1.0 - std::pow(1.0 - (1.0 / m), n)));
+}
+
+void add_level(const TSPLevelPtr &level, CollisionStats &stats) {
+    const auto states = enumerate_states(level);
+    std::unordered_set<uint64_t> hashes;
+    std::set<std::pair<uint64_t, uint64_t>> hashes_128;
+    std::unordered_set<uint64_t> low_bits;
+    std::unordered_set<uint64_t> high_bits;
+    for (const auto &state : states) {
+        const auto hash = state.get_hash128();
+        hashes.insert(hash.lo);
+        hashes_128.emplace(hash.lo, hash.hi);
+        low_bits.insert(hash.lo & ((uint64_t{1} << TRUNCATED_BITS) - 1));
+        high_bits.insert(hash.lo >> (64 - TRUNCATED_BITS));
+    }
+    const auto n = states.size();
+    stats.num_states += n;
+    stats.collisions += n - hashes.size();
+    stats.collisions_128 += n - hashes_128.size();
+    stats.collisions_low += n - low_bits.size();
+    stats.collisions_high += n - high_bits.size();
+    stats.expected_truncated += expected_collisions(static_cast<double>(n), std::pow(2.0, TRUNCATED_BITS));
+}
+
+auto test_collisions(const std::vector<std::string> &paths) -> bool {
+    CollisionStats stats;
+    for (const auto &path : paths) {
+        const LevelSet level_set(path);
+        for (const auto &level : level_set.load_all()) {
+            add_level(level, stats);
+        }
+    }
+
+    std::cout << "States: " << stats.num_states << ", 64 bit collisions: " << stats.collisions
+              << ", 128 bit collisions: " << stats.collisions_128 << std::endl;
+    std::cout << TRUNCATED_BITS << " bit truncated collisions (low/high/expected): " << stats.collisions_low << "/"
+              << stats.collisions_high << "/" << stats.expected_truncated << std::endl;
+    const double max_truncated = (MAX_COLLISION_RATIO * stats.expected_truncated) + COLLISION_SLACK;
+    if (stats.collisions != 0 || (kHash128 && stats.collisions_128 != 0)) {
+        std::cerr << "Full hash collisions found" << std::endl;
+        return false;
+    }
+    if (static_cast<double>(stats.collisions_low) > max_truncated ||
+        static_cast<double>(stats.collisions_high) > max_truncated) {
+        std::cerr << "Truncated hashes collide more often than random keys would" << std::endl;
+        return false;
+    }
+    return true;
+}
+}    // namespace
+
+int main() {
+    const std::string level_dir = TSP_LEVEL_DIR;
+    const bool passed =
+        test_collisions({level_dir + "/train.txt", level_dir + "/test.txt", level_dir + "/tsp_test.txt"});
+    std::cout << (passed ? "passed" : "failed") << std::endl;
+    return passed ? 0 : 1;
+}
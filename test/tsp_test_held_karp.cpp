@@ -0,0 +1,94 @@
+#include <tsp/tsp.h>
+
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace tsp;
+
+constexpr int NUM_LEVELS = 20;
+constexpr int NUM_TRIALS = 20;
+constexpr int MAX_DEPTH = 32;
+
+namespace {
+// Moving to each city of the tour in order solves the state with the reported cost
+auto replay_solves(const TSPGameState &state, const TourResult &result) -> bool {
+    auto replay_state = state;
+    int cost = 0;
+    for (const int city : result.tour) {
+        cost += replay_state.apply_path(city);
+    }
+    return replay_state.is_solution() && cost == result.cost;
+}
+
+// Held-Karp matches the grid search on initial and mid-episode states
+auto test_optimal() -> bool {
+    const GeneratorOptions options{.map_size = 8, .num_cities = 5, .num_random_walls = 12, .require_reachable = true};
+    std::mt19937 rng(0);
+    for (uint64_t seed = 0; seed < NUM_LEVELS; ++seed) {
+        const auto level = generate_level(options, seed);
+        for (int trial = 0; trial < NUM_TRIALS; ++trial) {
+            TSPGameState state(level);
+            const auto depth = trial == 0 ? 0 : static_cast<int>(rng() % MAX_DEPTH);
+            for (int i = 0; i < depth; ++i) {
+                state.apply_action(static_cast<Action>(rng() % kNumActions));
+            }
+            const auto expected = solve(state);
+            const auto result = solve_tour(state);
+            if (!expected.solved || !result.solved || result.cost != expected.cost || !replay_solves(state, result)) {
+                std::cerr << "Held-Karp cost " << result.cost << " differs from search cost " << expected.cost
+                          << std::endl;
+                std::cerr << state;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Large enough for the DP layers to be split across threads
+auto test_threads() -> bool {
+    const GeneratorOptions options{.map_size = 24, .num_cities = 16, .add_walls = true, .num_random_walls = 60};
+    const auto level = generate_level(options, 0);
+    const TSPGameState state(level);
+    const auto single = solve_tour(state);
+    const auto parallel = solve_tour(state, {.num_threads = 4});
+    if (!single.solved || single.cost != parallel.cost || !replay_solves(state, parallel)) {
+        std::cerr << "Parallel cost " << parallel.cost << " differs from " << single.cost << std::endl;
+        return false;
+    }
+    // Too little memory for the table
+    return !solve_tour(state, {.max_bytes = 1024}).solved;
+}
+
+auto test_unsolvable() -> bool {
+    // City in the top left corner is walled off, and a board without cities can't be solved
+    const auto walled = solve_tour("4|4|03|02|00|00|02|00|00|00|00|01|00|03|00|00|00|00");
+    const auto empty = solve_tour("3|3|00|00|00|00|01|00|00|00|00");
+    return !walled.solved && walled.cost == -1 && !empty.solved;
+}
+
+auto test_levels() -> bool {
+    std::vector<std::string> board_strs;
+    const GeneratorOptions options{.map_size = 10, .num_cities = 8, .add_walls = true};
+    for (uint64_t seed = 0; seed < NUM_LEVELS; ++seed) {
+        board_strs.push_back(generate_board_str(options, seed));
+    }
+    const auto results = solve_tour_levels(board_strs, {.num_threads = 4});
+    for (std::size_t i = 0; i < board_strs.size(); ++i) {
+        if (results[i].cost != solve_tour(board_strs[i]).cost) {
+            return false;
+        }
+    }
+    return true;
+}
+}    // namespace
+
+int main() {
+    bool passed = test_optimal();
+    passed = passed && test_threads();
+    passed = passed && test_unsolvable();
+    passed = passed && test_levels();
+    std::cout << (passed ? "passed" : "failed") << std::endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,87 @@
+#include <tsp/tsp.h>
+
+#include <iostream>
+#include <random>
+#include <unordered_set>
+#include <vector>
+
+using namespace tsp;
+
+constexpr int NUM_SAMPLES = 200;
+constexpr int MAX_WALK = 20;
+
+namespace {
+struct KeyHasher {
+    std::size_t operator()(const TSPGameState &s) const {
+        return s.get_hash();
+    }
+};
+
+// Exact number of moves to reach the solution, using breadth first search
+auto optimal_cost(const TSPGameState &state) -> int {
+    std::unordered_set<TSPGameState, KeyHasher> seen{state};
+    std::vector<TSPGameState> layer{state};
+    std::vector<TSPGameState> children(kNumActions, state);
+    for (int depth = 0; !layer.empty(); ++depth) {
+        std::vector<TSPGameState> next_layer;
+        for (const auto &s : layer) {
+            if (s.is_solution()) {
+                return depth;
+            }
+            const int num_children = s.expand(children.data());
+            for (int i = 0; i < num_children; ++i) {
+                if (seen.insert(children[static_cast<std::size_t>(i)]).second) {
+                    next_layer.push_back(children[static_cast<std::size_t>(i)]);
+                }
+            }
+        }
+        layer = std::move(next_layer);
+    }
+    return kUnreachable;
+}
+
+auto test_heuristic(const std::string &board_str) -> bool {
+    const TSPGameState init_state(board_str);
+    std::mt19937 rng(0);
+    const std::vector<HeuristicType> types{HeuristicType::kFarthestCity, HeuristicType::kMST, HeuristicType::kMax};
+
+    for (int sample = 0; sample < NUM_SAMPLES; ++sample) {
+        auto state = init_state;
+        std::vector<TSPHeuristic> heuristics(types.begin(), types.end());
+        std::vector<HeuristicInfo> infos;
+        for (auto &heuristic : heuristics) {
+            infos.push_back(heuristic.compute(state));
+        }
+        const auto walk_length = static_cast<int>(rng() % MAX_WALK);
+        for (int i = 0; i < walk_length && !state.is_solution(); ++i) {
+            state.apply_action(static_cast<Action>(rng() % kNumActions));
+            for (std::size_t h = 0; h < heuristics.size(); ++h) {
+                infos[h] = heuristics[h].update(infos[h], state);
+            }
+        }
+
+        const int cost = optimal_cost(state);
+        for (std::size_t h = 0; h < heuristics.size(); ++h) {
+            const auto scratch = heuristics[h].compute(state);
+            if (scratch.value != infos[h].value || scratch.city_mst != infos[h].city_mst) {
+                std::cerr << "Incremental mismatch for heuristic " << h << std::endl << state;
+                return false;
+            }
+            if (infos[h].value > cost) {
+                std::cerr << "Inadmissible heuristic " << h << ": " << infos[h].value << " > " << cost << std::endl
+                          << state;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+}    // namespace
+
+int main() {
+    const std::string open_str = "5|5|03|00|00|00|00|00|00|03|00|00|00|00|01|00|00|00|00|00|00|03|03|00|00|00|00";
+    const std::string walled_str = "5|5|03|00|02|00|03|00|00|02|00|00|02|00|01|02|00|00|00|00|02|00|00|00|03|00|00";
+    const bool passed = test_heuristic(open_str) && test_heuristic(walled_str);
+    std::cout << (passed ? "passed" : "failed") << std::endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,73 @@
+#include <tsp/tsp.h>
+
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace tsp;
+
+constexpr int NUM_THREADS = 4;
+constexpr int NUM_OBSERVATIONS = 3;
+
+namespace {
+const std::string kBoardStr = "5|5|03|00|02|00|03|00|00|02|00|00|02|00|01|02|00|00|00|00|02|00|00|00|03|00|00";
+
+// From the agent at (2, 2), left and up twice are legal, then up goes off the board and right walks into a wall
+const std::vector<Action> kActions{Action::kLeft, Action::kUp, Action::kUp, Action::kUp, Action::kRight};
+constexpr uint64_t kNumNoops = 2;
+
+void run_ops() {
+    TSPGameState state(kBoardStr);
+    for (const auto action : kActions) {
+        state.apply_action(action);
+    }
+    for (int i = 0; i < NUM_OBSERVATIONS; ++i) {
+        (void)state.get_observation();
+    }
+    (void)state.to_image();
+    (void)state.get_hash();
+}
+
+auto test_counts() -> bool {
+    reset_instrumentation();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < NUM_THREADS; ++i) {
+        threads.emplace_back(run_ops);
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    run_ops();
+    const auto snapshot = get_instrumentation_snapshot();
+    std::cout << snapshot.to_string();
+
+    // Counts of the exited threads are kept, alongside those of the main thread
+    const uint64_t num_runs = kInstrumentationEnabled ? NUM_THREADS + 1 : 0;
+    const bool passed =
+        snapshot.get_count(InstrumentationCounter::kConstruct) == num_runs &&
+        snapshot.get_count(InstrumentationCounter::kApplyAction) == num_runs * kActions.size() &&
+        snapshot.get_count(InstrumentationCounter::kApplyActionNoop) == num_runs * kNumNoops &&
+        snapshot.get_count(InstrumentationCounter::kHashUpdate) == num_runs * (kActions.size() - kNumNoops) &&
+        snapshot.get_count(InstrumentationCounter::kHashQuery) == num_runs &&
+        snapshot.get_count(InstrumentationCounter::kObservation) == num_runs * NUM_OBSERVATIONS &&
+        snapshot.get_count(InstrumentationCounter::kImage) == num_runs &&
+        (kInstrumentationTimersEnabled || snapshot.get_cycles(InstrumentationTimer::kApplyAction) == 0);
+    if (!passed) {
+        std::cerr << "Unexpected counts" << std::endl;
+        return false;
+    }
+
+    reset_instrumentation();
+    if (get_instrumentation_snapshot().get_count(InstrumentationCounter::kApplyAction) != 0) {
+        std::cerr << "Counts not reset" << std::endl;
+        return false;
+    }
+    return true;
+}
+}    // namespace
+
+int main() {
+    const bool passed = test_counts();
+    std::cout << (passed ? "passed" : "failed") << std::endl;
+    return passed ? 0 : 1;
+}
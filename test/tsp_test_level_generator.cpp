@@ -0,0 +1,136 @@
+#include <tsp/tsp.h>
+
+#include <iostream>
+#include <sstream>
+#include <string>
+
+using namespace tsp;
+
+namespace {
+constexpr int NUM_LEVELS = 2000;
+constexpr int MAP_SIZE = 10;
+constexpr int NUM_CITIES = 6;
+constexpr int NUM_RANDOM_WALLS = 30;
+
+auto test_layout() -> bool {
+    const GeneratorOptions options{.map_size = MAP_SIZE, .num_cities = NUM_CITIES, .add_walls = true};
+    for (uint64_t seed = 0; seed < NUM_LEVELS; ++seed) {
+        const std::string board_str = generate_board_str(options, seed);
+        if (board_str != generate_board_str(options, seed)) {
+            std::cerr << "Seed " << seed << " is not deterministic" << std::endl;
+            return false;
+        }
+        const TSPLevel level(board_str);
+        if (level.get_rows() != MAP_SIZE || level.get_cols() != MAP_SIZE || level.get_num_cities() != NUM_CITIES) {
+            std::cerr << "Unexpected layout " << board_str << std::endl;
+            return false;
+        }
+        // Diagonal walls from each corner towards the center
+        for (int i = 0; i < MAP_SIZE / 2 - 1; ++i) {
+            const int corner = MAP_SIZE - 1 - i;
+            if (!level.is_wall((i * MAP_SIZE) + i) || !level.is_wall((i * MAP_SIZE) + corner) ||
+                !level.is_wall((corner * MAP_SIZE) + i) || !level.is_wall((corner * MAP_SIZE) + corner)) {
+                std::cerr << "Missing diagonal wall " << board_str << std::endl;
+                return false;
+            }
+        }
+        if (*generate_level(options, seed) != level) {
+            std::cerr << "Level and board string differ for seed " << seed << std::endl;
+            return false;
+        }
+    }
+    return generate_board_str(options, 0) != generate_board_str(options, 1);
+}
+
+auto test_reachable() -> bool {
+    // City in the top left corner is walled off
+    if (all_cities_reachable(TSPLevel("4|4|03|02|00|00|02|00|00|00|00|01|00|03|00|00|00|00")) ||
+        !all_cities_reachable(TSPLevel("4|4|03|00|00|00|02|00|00|00|00|01|00|03|00|00|00|00"))) {
+        std::cerr << "Reachability check failed" << std::endl;
+        return false;
+    }
+
+    GeneratorOptions options{
+        .map_size = MAP_SIZE, .num_cities = NUM_CITIES, .add_walls = true, .num_random_walls = NUM_RANDOM_WALLS};
+    int num_unreachable = 0;
+    for (uint64_t seed = 0; seed < NUM_LEVELS; ++seed) {
+        num_unreachable += all_cities_reachable(*generate_level(options, seed)) ? 0 : 1;
+    }
+    options.require_reachable = true;
+    for (uint64_t seed = 0; seed < NUM_LEVELS; ++seed) {
+        if (!all_cities_reachable(*generate_level(options, seed))) {
+            std::cerr << "Filtered level has an unreachable city" << std::endl;
+            return false;
+        }
+    }
+    // The filter has to have something to remove for the test to mean anything
+    return num_unreachable > 0;
+}
+
+auto test_difficulty() -> bool {
+    const GeneratorOptions options{.map_size = 6, .num_cities = 3, .num_random_walls = 4, .require_reachable = true};
+    for (uint64_t seed = 0; seed < 20; ++seed) {
+        const auto level = generate_level(options, seed);
+        const auto difficulty = compute_difficulty(level);
+        const auto result = solve(TSPGameState(level));
+        // The city rows alone give the same bound as the level's full table
+        if (difficulty.lower_bound != TSPHeuristic(HeuristicType::kMax).compute(TSPGameState(level)).value) {
+            std::cerr << "Lower bound differs from the heuristic" << std::endl;
+            return false;
+        }
+        if (!result.solved || difficulty.lower_bound > result.cost || difficulty.greedy_cost < result.cost) {
+            std::cerr << "Cost " << result.cost << " outside of bounds [" << difficulty.lower_bound << ", "
+                      << difficulty.greedy_cost << "]" << std::endl;
+            return false;
+        }
+    }
+    const auto unreachable = std::make_shared<const TSPLevel>("4|4|03|02|00|00|02|00|00|00|00|01|00|03|00|00|00|00");
+    return compute_difficulty(unreachable).lower_bound == kUnreachable;
+}
+
+auto test_stream() -> bool {
+    // Output doesn't depend on the number of threads or the batch size
+    GeneratorOptions options{.map_size = MAP_SIZE, .num_cities = NUM_CITIES, .num_random_walls = NUM_RANDOM_WALLS};
+    std::ostringstream expected;
+    std::ostringstream expected_difficulty;
+    for (uint64_t seed = 0; seed < NUM_LEVELS; ++seed) {
+        const auto level = generate_level(options, seed + 1);
+        const auto difficulty = compute_difficulty(level);
+        expected << generate_board_str(options, seed + 1) << "\n";
+        expected_difficulty << difficulty.lower_bound << " " << difficulty.greedy_cost << "\n";
+    }
+    for (const int num_threads : {1, 4}) {
+        for (const int batch_size : {1, 7, 1 << 14}) {
+            options.num_threads = num_threads;
+            options.batch_size = batch_size;
+            std::ostringstream out;
+            std::ostringstream difficulty_out;
+            write_generated_levels(options, 1, NUM_LEVELS, out, &difficulty_out);
+            if (out.str() != expected.str() || difficulty_out.str() != expected_difficulty.str()) {
+                std::cerr << "Streamed levels differ with " << num_threads << " threads" << std::endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+auto test_invalid() -> bool {
+    try {
+        (void)generate_board_str({.map_size = 3, .num_cities = 9}, 0);
+    } catch (const std::invalid_argument &) {
+        return true;
+    }
+    return false;
+}
+}    // namespace
+
+int main() {
+    bool passed = test_layout();
+    passed = passed && test_reachable();
+    passed = passed && test_difficulty();
+    passed = passed && test_stream();
+    passed = passed && test_invalid();
+    std::cout << (passed ? "passed" : "failed") << std::endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,75 @@
+#include <tsp/tsp.h>
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+using namespace tsp;
+
+using std::chrono::duration;
+using std::chrono::high_resolution_clock;
+
+constexpr int NUM_LEVELS = 100000;
+constexpr int MILLISECONDS_PER_SECOND = 1000;
+
+namespace {
+const std::vector<std::string> kBoardStrs{
+    "10|10|02|00|00|00|00|00|00|00|00|02|00|02|00|00|00|00|00|00|02|00|00|00|02|00|00|00|00|02|01|00|00|00|00|02|"
+    "00|00|02|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|03|00|02|00|00|02|00|00|00|"
+    "00|00|02|00|00|00|00|02|00|00|00|02|00|03|00|00|00|00|02|00|02|00|00|00|00|00|00|00|00|02",
+    "12|12|02|00|00|00|00|00|00|00|00|00|00|02|00|02|00|00|00|00|00|00|00|00|02|00|00|00|02|00|00|00|00|00|00|02|"
+    "00|00|00|00|00|02|00|00|00|00|02|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|"
+    "00|00|00|00|00|00|00|00|00|00|00|00|03|00|00|03|00|00|00|00|00|00|00|00|00|00|00|00|00|02|00|03|00|00|02|00|"
+    "00|00|00|00|02|00|00|00|00|00|00|02|00|00|00|02|00|00|00|03|00|00|01|00|02|00|02|00|00|00|00|00|00|00|00|00|"
+    "00|02",
+    "5|5|03|00|02|00|03|00|00|02|00|00|02|00|01|02|00|00|00|00|02|00|00|00|03|00|00",
+};
+
+auto test_level_set(const std::string &path) -> bool {
+    // Mix of line endings and blank lines
+    {
+        std::ofstream file(path, std::ios::binary);
+        for (int i = 0; i < NUM_LEVELS; ++i) {
+            file << kBoardStrs[static_cast<std::size_t>(i) % kBoardStrs.size()] << (i % 2 == 0 ? "\n" : "\r\n");
+            if (i % 1000 == 0) {
+                file << "\n";
+            }
+        }
+    }
+
+    const auto t1 = high_resolution_clock::now();
+    const LevelSet level_set(path);
+    const auto levels = level_set.load_all(0);
+    const auto t2 = high_resolution_clock::now();
+
+    if (level_set.size() != NUM_LEVELS || levels.size() != NUM_LEVELS) {
+        std::cerr << "Expected " << NUM_LEVELS << " levels, found " << level_set.size() << std::endl;
+        return false;
+    }
+    int64_t num_cells = 0;
+    for (std::size_t i = 0; i < levels.size(); ++i) {
+        const TSPLevel expected(kBoardStrs[i % kBoardStrs.size()]);
+        if (*levels[i] != expected || level_set.get_board_str(i) != kBoardStrs[i % kBoardStrs.size()]) {
+            std::cerr << "Level " << i << " does not match" << std::endl;
+            return false;
+        }
+        num_cells += levels[i]->get_num_cells();
+    }
+
+    const duration<double, std::milli> ms_double = t2 - t1;
+    std::cout << "Loaded " << NUM_LEVELS << " levels in " << ms_double.count() / MILLISECONDS_PER_SECOND << "s ("
+              << static_cast<double>(num_cells) / (ms_double.count() / MILLISECONDS_PER_SECOND) << " cells/sec)"
+              << std::endl;
+    return true;
+}
+}    // namespace
+
+int main() {
+    const std::string path = "tsp_test_level_set.txt";
+    const bool passed = test_level_set(path);
+    std::remove(path.c_str());
+    std::cout << (passed ? "passed" : "failed") << std::endl;
+    return passed ? 0 : 1;
+}
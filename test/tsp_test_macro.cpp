@@ -0,0 +1,105 @@
+#include <tsp/tsp.h>
+
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using namespace tsp;
+
+constexpr int NUM_TRIALS = 2000;
+constexpr int MAX_DEPTH = 32;
+
+namespace {
+// Random walk from the initial state
+auto random_state(const TSPLevelPtr &level, std::mt19937 &rng) -> TSPGameState {
+    TSPGameState state(level);
+    const auto depth = static_cast<int>(rng() % MAX_DEPTH);
+    for (int i = 0; i < depth; ++i) {
+        state.apply_action(static_cast<Action>(rng() % kNumActions));
+    }
+    return state;
+}
+
+// Paths give the same state as replaying their primitive actions
+auto test_path(const TSPLevelPtr &level) -> bool {
+    std::mt19937 rng(0);
+    const auto &distances = level->get_distances();
+    for (int trial = 0; trial < NUM_TRIALS; ++trial) {
+        const auto state = random_state(level, rng);
+        const auto target = static_cast<int>(rng() % static_cast<uint32_t>(level->get_num_cells()));
+        const int expected_cost = distances.distance(state.get_agent_index(), target);
+
+        auto path_state = state;
+        std::vector<Action> actions;
+        int cost = 0;
+        try {
+            cost = path_state.apply_path(target, &actions);
+        } catch (const std::invalid_argument &) {
+            if (expected_cost != kUnreachable) {
+                std::cerr << "Reachable target " << target << " was rejected" << std::endl;
+                return false;
+            }
+            continue;
+        }
+
+        auto replay_state = state;
+        uint64_t num_visited = 0;
+        for (const auto action : actions) {
+            replay_state.apply_action(action);
+            num_visited += replay_state.get_reward_signal();
+        }
+        if (cost != expected_cost || static_cast<int>(actions.size()) != cost ||
+            path_state.get_agent_index() != target || path_state != replay_state ||
+            path_state.get_hash128() != replay_state.get_hash128() || path_state.get_reward_signal() != num_visited) {
+            std::cerr << "Path mismatch on trial " << trial << std::endl;
+            std::cerr << path_state << replay_state;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Visiting the cities in order with macros and then returning to the start city solves the level
+auto test_macro_tour(const TSPLevelPtr &level) -> bool {
+    TSPGameState state(level);
+    std::vector<Action> actions;
+    int cost = 0;
+    for (int city_id = 0; city_id < level->get_num_cities(); ++city_id) {
+        cost += state.apply_macro(city_id, &actions);
+    }
+    cost += state.apply_path(state.get_start_city_index(), &actions);
+
+    TSPGameState replay_state(level);
+    for (const auto action : actions) {
+        replay_state.apply_action(action);
+    }
+    if (!state.is_solution() || !replay_state.is_solution() || cost != static_cast<int>(actions.size()) ||
+        state.get_hash() != replay_state.get_hash()) {
+        std::cerr << "Macro tour did not solve the level" << std::endl;
+        return false;
+    }
+    try {
+        (void)state.apply_macro(level->get_num_cities());
+    } catch (const std::invalid_argument &) {
+        return true;
+    }
+    return false;
+}
+}    // namespace
+
+int main() {
+    bool passed = true;
+    // The largest board doesn't store all pairs distances, so paths to empty cells run their own search
+    for (const int map_size : {10, 32, 128}) {
+        const GeneratorOptions options{.map_size = map_size,
+                                       .num_cities = 8,
+                                       .add_walls = true,
+                                       .num_random_walls = map_size * map_size / 4,
+                                       .require_reachable = true};
+        const auto level = generate_level(options, 0);
+        passed = passed && test_path(level) && test_macro_tour(level);
+    }
+    std::cout << (passed ? "passed" : "failed") << std::endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,105 @@
+#include <tsp/tsp.h>
+
+#include <algorithm>
+#include <iostream>
+#include <mutex>
+#include <numeric>
+#include <unordered_set>
+#include <vector>
+
+using namespace tsp;
+
+constexpr int NUM_SIMULATIONS = 2000;
+constexpr int BATCH_SIZE = 8;
+
+namespace {
+auto total_visits(const MCTSResult &result) -> uint64_t {
+    return std::accumulate(result.visit_counts.begin(), result.visit_counts.end(), uint64_t{0});
+}
+
+// The only city is to the left, under every tree policy and kind of parallelism
+auto test_corridor() -> bool {
+    const TSPGameState state("1|5|03|00|01|00|00");
+    for (const auto tree_policy : {TreePolicy::kUCT, TreePolicy::kPUCT}) {
+        for (const auto parallelism : {MCTSParallelism::kTree, MCTSParallelism::kRoot}) {
+            for (const int num_threads : {1, 4}) {
+                const MCTSOptions options{.num_simulations = 200,
+                                          .tree_policy = tree_policy,
+                                          .parallelism = parallelism,
+                                          .num_threads = num_threads};
+                const auto result = search_mcts(state, options);
+                if (result.action != Action::kLeft || result.visit_counts[static_cast<int>(Action::kUp)] != 0 ||
+                    result.num_simulations != 200) {
+                    std::cerr << "Wrong action with policy " << static_cast<int>(tree_policy) << ", parallelism "
+                              << static_cast<int>(parallelism) << ", " << num_threads << " threads" << std::endl;
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+// The search moves towards the nearest city, along an optimal tour
+auto test_optimal_move() -> bool {
+    const TSPGameState state("4|4|00|00|00|00|00|00|00|03|00|01|00|00|00|00|00|00");
+    const int cost = solve(state).cost;
+    const MCTSOptions options{.num_simulations = NUM_SIMULATIONS, .tree_policy = TreePolicy::kUCT};
+    const auto result = search_mcts(state, options);
+    auto child = state;
+    child.apply_action(result.action);
+    // Every simulation backs up through a root edge apart from the root expansion and collisions
+    return solve(child).cost == cost - 1 &&
+           total_visits(result) + result.num_collisions + 1 == result.num_simulations &&
+           result.num_nodes <= result.num_simulations + 1;
+}
+
+// The evaluator sees batches of distinct leaves, no larger than the batch size
+auto test_evaluator() -> bool {
+    const GeneratorOptions generator_options{.map_size = 10, .num_cities = 6, .add_walls = true};
+    const TSPGameState state(generate_level(generator_options, 0));
+    std::mutex mutex;
+    bool batches_ok = true;
+    uint64_t num_evaluated = 0;
+    const LeafEvaluator evaluator = [&](const TSPGameState *const *states, int batch_size, float *policies,
+                                        float *values) {
+        std::unordered_set<uint64_t> hashes;
+        for (int i = 0; i < batch_size; ++i) {
+            hashes.insert(states[i]->get_hash());
+            std::fill(policies + (i * kNumActions), policies + ((i + 1) * kNumActions), 0.25F);
+            values[i] = static_cast<float>(states[i]->get_level()->get_num_cities() -
+                                           states[i]->get_num_unvisited_cities());
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        batches_ok = batches_ok && batch_size <= BATCH_SIZE && static_cast<int>(hashes.size()) == batch_size;
+        num_evaluated += static_cast<uint64_t>(batch_size);
+    };
+    for (const auto parallelism : {MCTSParallelism::kTree, MCTSParallelism::kRoot}) {
+        const MCTSOptions options{
+            .num_simulations = NUM_SIMULATIONS, .parallelism = parallelism, .num_threads = 4, .batch_size = BATCH_SIZE};
+        num_evaluated = 0;
+        const auto result = search_mcts(state, options, evaluator);
+        if (!batches_ok || num_evaluated == 0 || result.num_evaluator_calls * BATCH_SIZE < num_evaluated ||
+            total_visits(result) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+auto test_solved_root() -> bool {
+    auto state = TSPGameState("1|3|03|01|00");
+    state.apply_action(Action::kLeft);
+    const auto result = search_mcts(state, {.num_simulations = 10});
+    return state.is_solution() && total_visits(result) == 0 && result.num_nodes == 1;
+}
+}    // namespace
+
+int main() {
+    bool passed = test_corridor();
+    passed = passed && test_optimal_move();
+    passed = passed && test_evaluator();
+    passed = passed && test_solved_root();
+    std::cout << (passed ? "passed" : "failed") << std::endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,271 @@
+#include <tsp/tsp.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace tsp;
+
+using std::chrono::duration;
+using std::chrono::high_resolution_clock;
+
+constexpr int NUM_STEPS = 20000;
+constexpr int NUM_UNDO_STEPS = 4000;
+constexpr int IMAGE_INTERVAL = 16;
+constexpr int ROW_PADDING = 5;
+constexpr int CHANNEL_PADDING = 7;
+constexpr int MAX_KERNEL_CELLS = 100;
+constexpr uint8_t SENTINEL = 0xAB;
+constexpr int MILLISECONDS_PER_SECOND = 1000;
+
+namespace {
+const std::vector<std::string> kBoardStrs{
+    "12|12|02|00|00|00|00|00|00|00|00|00|00|02|00|02|00|00|00|00|00|00|00|00|02|00|00|00|02|00|00|00|00|00|00|02|"
+    "00|00|00|00|00|02|00|00|00|00|02|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|"
+    "00|00|00|00|00|00|00|00|00|00|00|00|03|00|00|03|00|00|00|00|00|00|00|00|00|00|00|00|00|02|00|03|00|00|02|00|"
+    "00|00|00|00|02|00|00|00|00|00|00|02|00|00|00|02|00|00|00|03|00|00|01|00|02|00|02|00|00|00|00|00|00|00|00|00|"
+    "00|02",
+    "5|5|03|00|02|00|03|00|00|02|00|00|02|00|01|02|00|00|00|00|02|00|00|00|03|00|00",
+};
+
+// Reference one-hot encoding built cell by cell
+auto reference_observation(const TSPGameState &state, int channel_stride) -> std::vector<float> {
+    const int num_cells = state.get_level()->get_num_cells();
+    std::vector<float> obs(static_cast<std::size_t>(kNumChannels * channel_stride));
+    for (int i = 0; i < num_cells; ++i) {
+        obs[static_cast<std::size_t>((static_cast<int>(state.get_element(i)) * channel_stride) + i)] = 1;
+    }
+    return obs;
+}
+
+// Compare the written cells of each channel, and check the padding after them is untouched
+template <typename T>
+auto matches_reference(const std::vector<float> &expected, const std::vector<T> &obs, int num_cells,
+                       int channel_stride, T one) -> bool {
+    for (int c = 0; c < kNumChannels; ++c) {
+        for (int i = 0; i < channel_stride; ++i) {
+            const auto idx = static_cast<std::size_t>((c * channel_stride) + i);
+            T value{};
+            if (i < num_cells) {
+                value = expected[idx] != 0 ? one : T{0};
+            } else {
+                std::memset(&value, SENTINEL, sizeof(T));
+            }
+            if (std::memcmp(&obs[idx], &value, sizeof(T)) != 0) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+template <typename T>
+auto make_buffer(std::size_t size) -> std::vector<T> {
+    std::vector<T> buffer(size);
+    std::memset(buffer.data(), SENTINEL, size * sizeof(T));
+    return buffer;
+}
+
+auto test_kernel() -> bool {
+    std::mt19937 rng(0);
+    for (int num_cells = 0; num_cells <= MAX_KERNEL_CELLS; ++num_cells) {
+        std::vector<uint8_t> codes(static_cast<std::size_t>(num_cells));
+        std::vector<float> expected(static_cast<std::size_t>(kNumChannels * (num_cells + CHANNEL_PADDING)));
+        const int stride = num_cells + CHANNEL_PADDING;
+        for (int i = 0; i < num_cells; ++i) {
+            codes[static_cast<std::size_t>(i)] = static_cast<uint8_t>(rng() % kNumChannels);
+            expected[static_cast<std::size_t>((codes[static_cast<std::size_t>(i)] * stride) + i)] = 1;
+        }
+        auto obs_float = make_buffer<float>(expected.size());
+        auto obs_uint8 = make_buffer<uint8_t>(expected.size());
+        auto obs_bfloat16 = make_buffer<uint16_t>(expected.size());
+        encode_one_hot(codes.data(), num_cells, obs_float.data(), stride);
+        encode_one_hot(codes.data(), num_cells, obs_uint8.data(), stride);
+        encode_one_hot_bfloat16(codes.data(), num_cells, obs_bfloat16.data(), stride);
+        if (!matches_reference(expected, obs_float, num_cells, stride, 1.0F) ||
+            !matches_reference(expected, obs_uint8, num_cells, stride, uint8_t{1}) ||
+            !matches_reference(expected, obs_bfloat16, num_cells, stride, kBFloat16One)) {
+            std::cerr << "Kernel mismatch for " << num_cells << " cells" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+auto test_observation(const std::string &board_str) -> bool {
+    const TSPGameState init_state(board_str);
+    const int num_cells = init_state.get_level()->get_num_cells();
+    const int stride = num_cells + CHANNEL_PADDING;
+    std::mt19937 rng(0);
+    auto state = init_state;
+    std::vector<float> obs(static_cast<std::size_t>(kNumChannels * num_cells));
+    double encode_ms = 0;
+    for (int i = 0; i < NUM_STEPS; ++i) {
+        state.apply_action(static_cast<Action>(rng() % kNumActions));
+        if (state.is_solution()) {
+            state = init_state;
+        }
+        const auto t1 = high_resolution_clock::now();
+        state.get_observation(obs.data());
+        encode_ms += duration<double, std::milli>(high_resolution_clock::now() - t1).count();
+
+        auto obs_float = make_buffer<float>(static_cast<std::size_t>(kNumChannels * stride));
+        auto obs_uint8 = make_buffer<uint8_t>(obs_float.size());
+        auto obs_bfloat16 = make_buffer<uint16_t>(obs_float.size());
+        state.get_observation(obs_float.data(), stride);
+        state.get_observation(obs_uint8.data(), stride);
+        state.get_observation_bfloat16(obs_bfloat16.data(), stride);
+        if (obs != reference_observation(state, num_cells) ||
+            !matches_reference(reference_observation(state, stride), obs_float, num_cells, stride, 1.0F) ||
+            !matches_reference(reference_observation(state, stride), obs_uint8, num_cells, stride, uint8_t{1}) ||
+            !matches_reference(reference_observation(state, stride), obs_bfloat16, num_cells, stride, kBFloat16One)) {
+            std::cerr << "Observation mismatch on step " << i << std::endl;
+            std::cerr << state;
+            return false;
+        }
+    }
+    std::cout << "SIMD level " << static_cast<int>(get_simd_level()) << ": "
+              << NUM_STEPS / (encode_ms / MILLISECONDS_PER_SECOND) << " observations/sec" << std::endl;
+    return true;
+}
+auto test_encodings(const std::string &board_str) -> bool {
+    const TSPGameState init_state(board_str);
+    const int num_cells = init_state.get_level()->get_num_cells();
+    const std::size_t num_plane_words = kNumChannels * bit_plane_words(num_cells);
+    std::mt19937 rng(0);
+    auto state = init_state;
+    std::vector<float> dense(static_cast<std::size_t>(kNumChannels * num_cells));
+    std::vector<uint8_t> dense_uint8(dense.size());
+    std::vector<float> decoded(dense.size());
+    std::vector<uint8_t> decoded_uint8(dense.size());
+    std::vector<uint8_t> codes(static_cast<std::size_t>(num_cells));
+    std::vector<uint8_t> decoded_codes(codes.size());
+    std::vector<uint64_t> planes(num_plane_words);
+    std::vector<uint64_t> state_planes(num_plane_words);
+    std::vector<uint32_t> entries(codes.size());
+    std::vector<uint32_t> state_entries(codes.size());
+    std::size_t sparse_bytes = 0;
+    for (int i = 0; i < NUM_STEPS; ++i) {
+        state.apply_action(static_cast<Action>(rng() % kNumActions));
+        if (state.is_solution()) {
+            state = init_state;
+        }
+        state.get_observation(dense.data());
+        state.get_observation(dense_uint8.data());
+        state.get_element_codes(codes.data());
+
+        // Per-cell index form
+        decode_one_hot(dense.data(), num_cells, num_cells, decoded_codes.data());
+        encode_one_hot(codes.data(), num_cells, decoded.data(), num_cells);
+        bool passed = decoded_codes == codes && decoded == dense;
+
+        // Bit-plane form
+        encode_bit_planes(codes.data(), num_cells, planes.data());
+        state.get_observation_bit_planes(state_planes.data());
+        decode_bit_planes(planes.data(), num_cells, decoded.data(), num_cells);
+        decode_bit_planes(planes.data(), num_cells, decoded_uint8.data(), num_cells);
+        passed = passed && planes == state_planes && decoded == dense && decoded_uint8 == dense_uint8;
+
+        // Sparse form
+        const int num_entries = encode_sparse(codes.data(), num_cells, entries.data());
+        const int num_state_entries = state.get_observation_sparse(state_entries.data());
+        decode_sparse(entries.data(), num_entries, num_cells, decoded.data(), num_cells);
+        decode_sparse(entries.data(), num_entries, num_cells, decoded_uint8.data(), num_cells);
+        passed = passed && num_entries == num_state_entries &&
+                 std::equal(entries.begin(), entries.begin() + num_entries, state_entries.begin()) &&
+                 decoded == dense && decoded_uint8 == dense_uint8;
+        sparse_bytes += static_cast<std::size_t>(num_entries) * sizeof(uint32_t);
+
+        if (!passed) {
+            std::cerr << "Encoding mismatch on step " << i << std::endl;
+            std::cerr << state;
+            return false;
+        }
+    }
+    std::cout << "Bytes per observation: dense " << dense.size() * sizeof(float) << ", bit planes "
+              << num_plane_words * sizeof(uint64_t) << ", index " << codes.size() << ", sparse (mean) "
+              << static_cast<double>(sparse_bytes) / NUM_STEPS << std::endl;
+    return true;
+}
+
+// Write the vector returned by get_observation() with a channel stride, leaving the padding as the sentinel
+auto strided_observation(const TSPGameState &state, int channel_stride) -> std::vector<float> {
+    const auto obs = state.get_observation();
+    const int num_cells = state.get_level()->get_num_cells();
+    auto strided = make_buffer<float>(static_cast<std::size_t>(kNumChannels * channel_stride));
+    for (int c = 0; c < kNumChannels; ++c) {
+        std::copy_n(obs.begin() + (c * num_cells), num_cells, strided.begin() + (c * channel_stride));
+    }
+    return strided;
+}
+
+// The buffer overloads agree with the vector returning versions, and incremental updates stay in sync through a
+// sequence of random moves and undos
+auto test_buffer_overloads(const std::string &board_str) -> bool {
+    TSPGameState state(board_str);
+    const int num_cells = state.get_level()->get_num_cells();
+    const int stride = num_cells + CHANNEL_PADDING;
+    const auto image_shape = state.image_shape();
+    const int row_bytes = image_shape[1] * image_shape[2];
+    const int row_stride = row_bytes + ROW_PADDING;
+    std::mt19937 rng(0);
+
+    auto obs = state.get_observation();
+    auto obs_strided = strided_observation(state, stride);
+    std::vector<TSPUndoRecord> records;
+    for (int i = 0; i < NUM_UNDO_STEPS; ++i) {
+        const int prev_agent_idx = state.get_agent_index();
+        if (!records.empty() && rng() % 3 == 0) {
+            state.undo_action(records.back());
+            records.pop_back();
+        } else {
+            records.push_back(state.apply_action_with_undo(static_cast<Action>(rng() % kNumActions)));
+        }
+        state.update_observation(obs.data(), prev_agent_idx);
+        state.update_observation(obs_strided.data(), prev_agent_idx, stride);
+
+        auto obs_written = make_buffer<float>(static_cast<std::size_t>(kNumChannels * stride));
+        state.get_observation(obs_written.data(), stride);
+        const auto expected = strided_observation(state, stride);
+        if (obs != state.get_observation() || obs_strided != expected || obs_written != expected) {
+            std::cerr << "Observation buffer mismatch on step " << i << std::endl;
+            std::cerr << state;
+            return false;
+        }
+
+        if (i % IMAGE_INTERVAL != 0) {
+            continue;
+        }
+        const auto img = state.to_image();
+        std::vector<uint8_t> img_written(img.size());
+        state.to_image(img_written.data());
+        auto img_strided = make_buffer<uint8_t>(static_cast<std::size_t>(image_shape[0] * row_stride));
+        state.to_image(img_strided.data(), row_stride);
+        bool passed = img_written == img;
+        for (int row = 0; row < image_shape[0] && passed; ++row) {
+            const auto row_begin = img_strided.begin() + (row * row_stride);
+            const auto is_padding = [](uint8_t value) { return value == SENTINEL; };
+            passed = std::equal(row_begin, row_begin + row_bytes, img.begin() + (row * row_bytes)) &&
+                     std::all_of(row_begin + row_bytes, row_begin + row_stride, is_padding);
+        }
+        if (!passed) {
+            std::cerr << "Image buffer mismatch on step " << i << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+}    // namespace
+
+int main() {
+    bool passed = test_kernel();
+    for (const auto &board_str : kBoardStrs) {
+        passed = passed && test_observation(board_str) && test_encodings(board_str) && test_buffer_overloads(board_str);
+    }
+    std::cout << (passed ? "passed" : "failed") << std::endl;
+    return passed ? 0 : 1;
+}
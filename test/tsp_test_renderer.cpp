@@ -0,0 +1,107 @@
+#include <tsp/tsp.h>
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace tsp;
+
+using std::chrono::duration;
+using std::chrono::high_resolution_clock;
+
+constexpr int NUM_STEPS = 20000;
+constexpr int SPRITE_SIZE = 4;
+constexpr int ROW_PADDING = 5;
+constexpr int MILLISECONDS_PER_SECOND = 1000;
+
+namespace {
+// Each sprite of the large image should be a solid block of the matching pixel of the 1x1 image
+auto matches_downsampled(const std::vector<uint8_t> &small, const std::vector<uint8_t> &large, int rows, int cols,
+                         int large_row_stride) -> bool {
+    for (int h = 0; h < rows * SPRITE_SIZE; ++h) {
+        for (int w = 0; w < cols * SPRITE_SIZE; ++w) {
+            const int small_idx = ((h / SPRITE_SIZE) * cols) + (w / SPRITE_SIZE);
+            const auto *small_pixel = &small[static_cast<std::size_t>(small_idx * 3)];
+            const auto *large_pixel = &large[static_cast<std::size_t>((h * large_row_stride) + (w * 3))];
+            if (std::memcmp(small_pixel, large_pixel, 3) != 0) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+auto test_renderer(const std::string &board_str) -> bool {
+    const TSPGameState init_state(board_str);
+    const int rows = init_state.get_level()->get_rows();
+    const int cols = init_state.get_level()->get_cols();
+    const Renderer small_renderer;
+    Renderer dirty_renderer(SPRITE_SIZE, SPRITE_SIZE);
+    const int row_stride = (cols * SPRITE_SIZE * 3) + ROW_PADDING;
+
+    // The default 32x32 renderer matches to_image()
+    if (Renderer(SPRITE_HEIGHT, SPRITE_WIDTH).image_shape(init_state) != init_state.image_shape()) {
+        std::cerr << "Image shape does not match to_image()" << std::endl;
+        return false;
+    }
+
+    std::vector<uint8_t> small(static_cast<std::size_t>(rows * cols * 3));
+    std::vector<uint8_t> full(static_cast<std::size_t>(rows * SPRITE_SIZE * row_stride));
+    std::vector<uint8_t> dirty(full.size());
+    std::mt19937 rng(0);
+    auto state = init_state;
+    double full_ms = 0;
+    double dirty_ms = 0;
+    for (int i = 0; i < NUM_STEPS; ++i) {
+        if (state.is_solution() || i % 500 == 0) {
+            state = init_state;
+        }
+        state.apply_action(static_cast<Action>(rng() % kNumActions));
+        small_renderer.render(state, small.data());
+
+        const auto t1 = high_resolution_clock::now();
+        dirty_renderer.render(state, full.data(), row_stride);
+        const auto t2 = high_resolution_clock::now();
+        dirty_renderer.render_dirty(state, dirty.data(), row_stride);
+        const auto t3 = high_resolution_clock::now();
+        full_ms += duration<double, std::milli>(t2 - t1).count();
+        dirty_ms += duration<double, std::milli>(t3 - t2).count();
+
+        if (!matches_downsampled(small, full, rows, cols, row_stride)) {
+            std::cerr << "Sprite image does not match 1x1 image on step " << i << std::endl;
+            return false;
+        }
+        // Padding between rows is never written, so compare the image rows only
+        for (int h = 0; h < rows * SPRITE_SIZE; ++h) {
+            const auto offset = static_cast<std::size_t>(h * row_stride);
+            if (std::memcmp(&full[offset], &dirty[offset], static_cast<std::size_t>(cols * SPRITE_SIZE * 3)) != 0) {
+                std::cerr << "Dirty image does not match full image on step " << i << std::endl;
+                return false;
+            }
+        }
+        if (i % 500 != 0 && dirty_renderer.get_num_cells_drawn() > 4 + init_state.get_level()->get_num_cities()) {
+            std::cerr << "Dirty render drew " << dirty_renderer.get_num_cells_drawn() << " cells" << std::endl;
+            return false;
+        }
+    }
+
+    std::cout << "Full render: " << NUM_STEPS / (full_ms / MILLISECONDS_PER_SECOND)
+              << " frames/sec, dirty render: " << NUM_STEPS / (dirty_ms / MILLISECONDS_PER_SECOND) << " frames/sec"
+              << std::endl;
+    return true;
+}
+}    // namespace
+
+int main() {
+    const std::string board_str =
+        "12|12|02|00|00|00|00|00|00|00|00|00|00|02|00|02|00|00|00|00|00|00|00|00|02|00|00|00|02|00|00|00|00|00|00|02|"
+        "00|00|00|00|00|02|00|00|00|00|02|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|"
+        "00|00|00|00|00|00|00|00|00|00|00|00|03|00|00|03|00|00|00|00|00|00|00|00|00|00|00|00|00|02|00|03|00|00|02|00|"
+        "00|00|00|00|02|00|00|00|00|00|00|02|00|00|00|02|00|00|00|03|00|00|01|00|02|00|02|00|00|00|00|00|00|00|00|00|"
+        "00|02";
+    const bool passed = test_renderer(board_str);
+    std::cout << (passed ? "passed" : "failed") << std::endl;
+    return passed ? 0 : 1;
+}
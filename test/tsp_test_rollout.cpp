@@ -0,0 +1,75 @@
+#include <tsp/tsp.h>
+
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+using namespace tsp;
+
+constexpr int NUM_ROLLOUTS = 500;
+constexpr int MAX_STEPS = 300;
+
+namespace {
+auto make_states() -> std::vector<TSPGameState> {
+    const GeneratorOptions options{.map_size = 10, .num_cities = 6, .add_walls = true};
+    std::vector<TSPGameState> states;
+    for (int i = 0; i < NUM_ROLLOUTS; ++i) {
+        states.emplace_back(generate_level(options, static_cast<uint64_t>(i % 5)));
+    }
+    return states;
+}
+
+// Results are the same on any number of threads, and match single rollouts with the same seed
+auto test_deterministic() -> bool {
+    const auto states = make_states();
+    const RolloutOptions options{.max_steps = MAX_STEPS, .seed = 7};
+    const auto single = run_rollouts(states, options);
+    auto parallel_options = options;
+    parallel_options.num_threads = 4;
+    const auto parallel = run_rollouts(states, parallel_options);
+    if (single.total_steps != parallel.total_steps) {
+        return false;
+    }
+    for (std::size_t i = 0; i < states.size(); ++i) {
+        auto state = states[i];
+        const auto result = rollout(state, options, options.seed + i);
+        const auto &a = single.results[i];
+        const auto &b = parallel.results[i];
+        // Undiscounted rewards count the cities visited
+        const int visited = states[i].get_num_unvisited_cities() - state.get_num_unvisited_cities();
+        if (a.steps != b.steps || a.total_reward != b.total_reward || a.solved != b.solved ||
+            result.steps != a.steps || result.solved != state.is_solution() || result.steps > MAX_STEPS ||
+            result.total_reward != visited || (!result.solved && result.steps != MAX_STEPS)) {
+            std::cerr << "Rollout " << i << " differs" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+auto test_policy() -> bool {
+    const std::vector<TSPGameState> states(4, TSPGameState("1|5|03|00|01|00|00"));
+    const RolloutOptions options{.discount = 0.5, .solution_reward = 2.0};
+    const auto batch = run_rollouts(states, options, [](const TSPGameState &, uint64_t) { return Action::kLeft; });
+    for (const auto &result : batch.results) {
+        // The city is reached on the second step, for 0.5 * (1 + 2)
+        if (!result.solved || result.steps != 2 || result.total_reward != 1.5) {
+            return false;
+        }
+    }
+    try {
+        (void)run_rollouts(states, {.num_threads = 2},
+                           [](const TSPGameState &, uint64_t) -> Action { throw std::runtime_error("policy"); });
+    } catch (const std::runtime_error &) {
+        return true;
+    }
+    return false;
+}
+}    // namespace
+
+int main() {
+    bool passed = test_deterministic();
+    passed = passed && test_policy();
+    std::cout << (passed ? "passed" : "failed") << std::endl;
+    return passed ? 0 : 1;
+}
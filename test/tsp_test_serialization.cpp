@@ -0,0 +1,141 @@
+#include <tsp/tsp.h>
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace tsp;
+
+using std::chrono::duration;
+using std::chrono::high_resolution_clock;
+
+constexpr int NUM_TRIALS = 2000;
+constexpr int MAX_DEPTH = 128;
+constexpr int DENSE_BOARD_SIZE = 11;
+constexpr int DENSE_BOARD_WALL_PERIOD = 7;
+constexpr int MILLISECONDS_PER_SECOND = 1000;
+
+namespace {
+const std::vector<std::string> kBoardStrs{
+    "10|10|02|00|00|00|00|00|00|00|00|02|00|02|00|00|00|00|00|00|02|00|00|00|02|00|00|00|00|02|01|00|00|00|00|02|"
+    "00|00|02|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|03|00|02|00|00|02|00|00|00|"
+    "00|00|02|00|00|00|00|02|00|00|00|02|00|03|00|00|00|00|02|00|02|00|00|00|00|00|00|00|00|02",
+    "5|5|03|00|02|00|03|00|00|02|00|00|02|00|01|02|00|00|00|00|02|00|00|00|03|00|00",
+};
+
+// Board with more than 64 cities, so that visited cities span several words
+auto make_dense_board() -> std::string {
+    std::string board_str = std::to_string(DENSE_BOARD_SIZE) + "|" + std::to_string(DENSE_BOARD_SIZE);
+    for (int i = 0; i < DENSE_BOARD_SIZE * DENSE_BOARD_SIZE; ++i) {
+        board_str += i == 0 ? "|01" : (i % DENSE_BOARD_WALL_PERIOD == 0 ? "|02" : "|03");
+    }
+    return board_str;
+}
+
+auto test_round_trip(const std::vector<std::string> &board_strs, const std::string &path) -> bool {
+    std::mt19937 rng(0);
+    std::vector<TSPGameState> states;
+    for (const auto &board_str : board_strs) {
+        const TSPGameState init_state(board_str);
+        for (int trial = 0; trial < NUM_TRIALS; ++trial) {
+            auto state = init_state;
+            const auto depth = static_cast<int>(rng() % MAX_DEPTH);
+            for (int i = 0; i < depth; ++i) {
+                state.apply_action(static_cast<Action>(rng() % kNumActions));
+            }
+            states.push_back(state);
+        }
+    }
+
+    const auto t1 = high_resolution_clock::now();
+    write_states(path, states);
+    const auto t2 = high_resolution_clock::now();
+    const BinaryReader reader(path);
+    const auto restored = reader.load_all_states();
+    const auto t3 = high_resolution_clock::now();
+
+    if (reader.get_num_levels() != board_strs.size() || restored.size() != states.size()) {
+        std::cerr << "Expected " << states.size() << " states, found " << restored.size() << std::endl;
+        return false;
+    }
+    for (std::size_t i = 0; i < states.size(); ++i) {
+        const auto record = reader.get_record(i);
+        if (restored[i] != states[i] || restored[i].get_hash() != states[i].get_hash() ||
+            record.hash != states[i].get_hash() || record.agent_idx != states[i].get_agent_index() ||
+            restored[i].get_observation() != states[i].get_observation()) {
+            std::cerr << "State " << i << " does not match" << std::endl;
+            std::cerr << restored[i] << states[i];
+            return false;
+        }
+    }
+    // Restored states share their level, and keep playing the same as the originals
+    for (std::size_t i = 0; i < states.size(); ++i) {
+        auto state = states[i];
+        auto restored_state = restored[i];
+        for (int a = 0; a < kNumActions; ++a) {
+            state.apply_action(static_cast<Action>(a));
+            restored_state.apply_action(static_cast<Action>(a));
+        }
+        if (restored_state != state || restored_state.get_hash() != state.get_hash() ||
+            restored_state.get_level() != reader.get_level(reader.get_record(i).level_index)) {
+            std::cerr << "State " << i << " does not play the same after restoring" << std::endl;
+            return false;
+        }
+    }
+
+    const duration<double, std::milli> write_ms = t2 - t1;
+    const duration<double, std::milli> read_ms = t3 - t2;
+    std::cout << "Wrote " << states.size() << " states in " << write_ms.count() / MILLISECONDS_PER_SECOND
+              << "s, read in " << read_ms.count() / MILLISECONDS_PER_SECOND << "s" << std::endl;
+    return true;
+}
+
+auto test_levels(const std::vector<std::string> &board_strs, const std::string &path) -> bool {
+    std::vector<TSPLevelPtr> levels;
+    for (const auto &board_str : board_strs) {
+        levels.push_back(std::make_shared<const TSPLevel>(board_str));
+    }
+    write_levels(path, levels);
+    const auto restored = read_levels(path);
+    if (restored.size() != levels.size()) {
+        std::cerr << "Expected " << levels.size() << " levels, found " << restored.size() << std::endl;
+        return false;
+    }
+    for (std::size_t i = 0; i < levels.size(); ++i) {
+        if (*restored[i] != *levels[i] || TSPGameState(restored[i]) != TSPGameState(levels[i]) ||
+            TSPGameState(restored[i]).get_hash() != TSPGameState(levels[i]).get_hash()) {
+            std::cerr << "Level " << i << " does not match" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+auto test_invalid(const std::string &path) -> bool {
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << kBoardStrs[0];
+    }
+    try {
+        const BinaryReader reader(path);
+        std::cerr << "Expected a board string to be rejected" << std::endl;
+        return false;
+    } catch (const std::runtime_error &) {
+        return true;
+    }
+}
+}    // namespace
+
+int main() {
+    const std::string path = "tsp_test_serialization.bin";
+    auto board_strs = kBoardStrs;
+    board_strs.push_back(make_dense_board());
+    const bool passed = test_round_trip(board_strs, path) && test_levels(board_strs, path) && test_invalid(path);
+    std::remove(path.c_str());
+    std::cout << (passed ? "passed" : "failed") << std::endl;
+    return passed ? 0 : 1;
+}
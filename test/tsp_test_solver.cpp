@@ -0,0 +1,115 @@
+#include <tsp/tsp.h>
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace tsp;
+
+constexpr uint64_t NUM_BOUNDED_LEVELS = 20;
+
+namespace {
+auto replay_solves(TSPGameState state, const SolverResult &result) -> bool {
+    for (const auto &action : result.actions) {
+        state.apply_action(action);
+    }
+    return state.is_solution() && static_cast<int>(result.actions.size()) == result.cost;
+}
+
+auto test_solver(const std::string &board_str) -> bool {
+    const auto bfs = solve(board_str, {.algorithm = SearchAlgorithm::kBFS});
+    if (!bfs.solved || !replay_solves(board_str, bfs)) {
+        std::cerr << "BFS failed to solve" << std::endl;
+        return false;
+    }
+
+    for (int num_threads : {1, 4}) {
+        for (const auto heuristic : {HeuristicType::kFarthestCity, HeuristicType::kMST, HeuristicType::kMax}) {
+            const auto astar = solve(board_str, {.heuristic = heuristic, .num_threads = num_threads});
+            if (!astar.solved || !replay_solves(board_str, astar) || astar.cost != bfs.cost) {
+                std::cerr << "A* cost " << astar.cost << " differs from BFS cost " << bfs.cost << std::endl;
+                return false;
+            }
+        }
+        const double weight = 2.0;
+        const SolverOptions weighted_options{
+            .algorithm = SearchAlgorithm::kWeightedAStar, .weight = weight, .num_threads = num_threads};
+        const auto wastar = solve(board_str, weighted_options);
+        if (!wastar.solved || !replay_solves(board_str, wastar) || wastar.cost > weight * bfs.cost) {
+            std::cerr << "Weighted A* cost " << wastar.cost << " exceeds bound" << std::endl;
+            return false;
+        }
+    }
+
+    const auto bounded = solve(board_str, {.algorithm = SearchAlgorithm::kBFS, .max_nodes = 10});
+    if (bounded.solved) {
+        std::cerr << "Search should fail when out of nodes" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Running out of nodes part way through a batch of children or messages fails the search cleanly
+auto test_out_of_nodes() -> bool {
+    const GeneratorOptions options{.map_size = 10, .num_cities = 4, .add_walls = true};
+    for (uint64_t seed = 0; seed < NUM_BOUNDED_LEVELS; ++seed) {
+        const TSPGameState state(generate_level(options, seed));
+        for (int num_threads : {1, 4}) {
+            for (std::size_t max_nodes : {1, 2, 7, 50, 300}) {
+                const auto result = solve(state, {.num_threads = num_threads, .max_nodes = max_nodes});
+                if (result.solved && !replay_solves(state, result)) {
+                    std::cerr << "Bounded search returned an invalid solution" << std::endl;
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+// Errors raised by a search on a pool thread reach the caller instead of terminating
+auto test_levels_error() -> bool {
+    // Distances along a corridor longer than 65535 cells don't fit in the distance cache
+    std::string too_long = "1|" + std::to_string(kUnreachable + 1) + "|01";
+    for (int i = 1; i < kUnreachable + 1; ++i) {
+        too_long += i == kUnreachable ? "|03" : "|00";
+    }
+    // The first board takes long enough that the second is picked up by a pool thread rather than the caller
+    const GeneratorOptions options{.map_size = 16, .num_cities = 8, .add_walls = true};
+    const std::vector<std::string> board_strs{generate_board_str(options, 0), too_long};
+    try {
+        (void)solve_levels(board_strs, {.num_threads = 2});
+        return false;
+    } catch (const std::invalid_argument &) {
+        return true;
+    }
+}
+}    // namespace
+
+int main() {
+    const std::vector<std::string> board_strs{
+        "10|10|02|00|00|00|00|00|00|00|00|02|00|02|00|00|00|00|00|00|02|00|00|00|02|00|00|00|00|02|01|00|00|00|00|02|"
+        "00|00|02|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|03|00|02|00|00|02|00|00|00|"
+        "00|00|02|00|00|00|00|02|00|00|00|02|00|03|00|00|00|00|02|00|02|00|00|00|00|00|00|00|00|02",
+        "12|12|02|00|00|00|00|00|00|00|00|00|00|02|00|02|00|00|00|00|00|00|00|00|02|00|00|00|02|00|00|00|00|00|00|02|"
+        "00|00|00|00|00|02|00|00|00|00|02|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|"
+        "00|00|00|00|00|00|00|00|00|00|00|00|03|00|00|03|00|00|00|00|00|00|00|00|00|00|00|00|00|02|00|03|00|00|02|00|"
+        "00|00|00|00|02|00|00|00|00|00|00|02|00|00|00|02|00|00|00|03|00|00|01|00|02|00|02|00|00|00|00|00|00|00|00|00|"
+        "00|02",
+        "5|5|03|00|02|00|03|00|00|02|00|00|02|00|01|02|00|00|00|00|02|00|00|00|03|00|00",
+    };
+    bool passed = true;
+    for (const auto &board_str : board_strs) {
+        passed = passed && test_solver(board_str);
+    }
+
+    // Level sets give the same costs as solving one at a time
+    const auto results = solve_levels(board_strs, {.num_threads = 2});
+    for (std::size_t i = 0; i < board_strs.size() && passed; ++i) {
+        passed = results[i].cost == solve(board_strs[i]).cost;
+    }
+    passed = passed && test_out_of_nodes() && test_levels_error();
+    std::cout << (passed ? "passed" : "failed") << std::endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,112 @@
+#include <tsp/tsp.h>
+
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using namespace tsp;
+
+constexpr int NUM_NODES = 20000;
+constexpr std::size_t NUM_MEMORY_NODES = std::size_t{1} << 18;
+// Node records plus checkpoints, amortized over full pages, which must stay under 16 bytes
+constexpr double MAX_BYTES_PER_NODE = 15.0;
+
+namespace {
+// Grow a random tree by extending random nodes, keeping the full state of each node to compare against
+auto build_tree(StateArena &arena, std::vector<TSPGameState> &states, std::size_t num_nodes, std::mt19937 &rng)
+    -> void {
+    states.assign(1, arena.get_root());
+    while (states.size() < num_nodes) {
+        // Favour recent nodes so that the tree grows deep enough to pass several checkpoints
+        const auto recent = std::min<std::size_t>(states.size(), 64);
+        const auto parent = static_cast<StateArena::NodeIndex>(states.size() - 1 - (rng() % recent));
+        const auto action = static_cast<Action>(rng() % kNumActions);
+        auto child = states[parent];
+        child.apply_action(action);
+        if (arena.add_child(parent, action, child) != states.size()) {
+            throw std::logic_error("Nodes should be indexed in the order they are added");
+        }
+        states.push_back(std::move(child));
+    }
+}
+
+// Rematerialized states match the states the nodes were added with
+auto test_rematerialize(int checkpoint_interval) -> bool {
+    const GeneratorOptions options{.map_size = 10, .num_cities = 8, .add_walls = true, .num_random_walls = 10};
+    std::mt19937 rng(0);
+    StateArena arena(TSPGameState(generate_level(options, 0)), checkpoint_interval);
+    std::vector<TSPGameState> states;
+    build_tree(arena, states, NUM_NODES, rng);
+    for (std::size_t i = 0; i < states.size(); ++i) {
+        const auto index = static_cast<StateArena::NodeIndex>(i);
+        const auto &expected = states[i];
+        const auto state = arena.rematerialize(index);
+        auto replayed = arena.get_root();
+        const auto actions = arena.get_actions(index);
+        for (const auto action : actions) {
+            replayed.apply_action(action);
+        }
+        const int new_city = arena.get_new_city(index);
+        const bool new_city_ok = new_city == -1 ? expected.get_reward_signal() == 0
+                                                : expected.get_level()->get_city_indices()[new_city] ==
+                                                      expected.get_agent_index();
+        if (state != expected || state.get_hash() != expected.get_hash() ||
+            state.get_reward_signal() != expected.get_reward_signal() || arena.get_hash(index) != expected.get_hash() ||
+            replayed != expected || arena.get_g(index) != static_cast<int>(actions.size()) || !new_city_ok) {
+            std::cerr << "Node " << i << " at depth " << arena.get_g(index) << " differs" << std::endl;
+            std::cerr << expected << state;
+            return false;
+        }
+    }
+    return true;
+}
+
+auto test_memory() -> bool {
+    const GeneratorOptions options{.map_size = 10, .num_cities = 8, .add_walls = true};
+    std::mt19937 rng(0);
+    StateArena arena(TSPGameState(generate_level(options, 0)));
+    std::vector<TSPGameState> states;
+    build_tree(arena, states, NUM_MEMORY_NODES, rng);
+    const double bytes_per_node = static_cast<double>(arena.memory_bytes()) / static_cast<double>(arena.size());
+    if (bytes_per_node > MAX_BYTES_PER_NODE) {
+        std::cerr << "Arena uses " << bytes_per_node << " bytes per node" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+auto test_clear() -> bool {
+    const TSPGameState root("3|3|03|00|00|00|01|00|00|00|03");
+    StateArena arena(root, 1);
+    auto child = root;
+    child.apply_action(Action::kLeft);
+    const auto first = arena.add_child(StateArena::kRootIndex, Action::kLeft, child);
+    child.apply_action(Action::kUp);
+    const auto second = arena.add_child(first, Action::kUp, child);
+    if (arena.get_new_city(second) != 0 || arena.rematerialize(second) != child || arena.get_g(second) != 2) {
+        return false;
+    }
+    arena.clear();
+    return arena.size() == 1 && arena.rematerialize(StateArena::kRootIndex) == root &&
+           arena.get_parent(StateArena::kRootIndex) == StateArena::kNoParent;
+}
+
+auto test_invalid() -> bool {
+    try {
+        const StateArena arena(TSPGameState("3|3|03|00|00|00|01|00|00|00|00"), 0);
+    } catch (const std::invalid_argument &) {
+        return true;
+    }
+    return false;
+}
+}    // namespace
+
+int main() {
+    bool passed = test_rematerialize(1) && test_rematerialize(5) && test_rematerialize(64);
+    passed = passed && test_memory();
+    passed = passed && test_clear();
+    passed = passed && test_invalid();
+    std::cout << (passed ? "passed" : "failed") << std::endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,151 @@
+#include <tsp/tsp.h>
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace tsp;
+
+constexpr int NUM_TRIALS = 200;
+constexpr int MAX_DEPTH = 48;
+
+namespace {
+// Board string of a level transformed by a symmetry
+auto transform_board_str(const TSPLevel &level, Symmetry symmetry) -> std::string {
+    const auto &table = level.get_symmetry_table();
+    std::vector<uint8_t> codes(level.get_static_element_codes());
+    codes[static_cast<std::size_t>(level.get_agent_index())] = static_cast<uint8_t>(Element::kAgent);
+    std::vector<uint8_t> transformed(codes.size());
+    for (int i = 0; i < level.get_num_cells(); ++i) {
+        transformed[static_cast<std::size_t>(table.get_cell(symmetry, i))] = codes[static_cast<std::size_t>(i)];
+    }
+    std::string board_str = std::to_string(level.get_rows()) + "|" + std::to_string(level.get_cols());
+    for (const auto code : transformed) {
+        board_str += "|0" + std::to_string(code);
+    }
+    return board_str;
+}
+
+// Every symmetric variant of a state has the matching symmetry hash and canonical hash, and its observation is the
+// augmented observation of the original
+auto test_symmetric_states(const std::string &board_str) -> bool {
+    const auto level = std::make_shared<const TSPLevel>(board_str);
+    const int num_symmetries = get_num_symmetries(level->get_rows(), level->get_cols());
+    const auto obs_size = static_cast<std::size_t>(kNumChannels * level->get_num_cells());
+    std::mt19937 rng(0);
+
+    std::vector<TSPLevelPtr> levels;
+    for (int s = 0; s < num_symmetries; ++s) {
+        levels.push_back(std::make_shared<const TSPLevel>(transform_board_str(*level, static_cast<Symmetry>(s))));
+    }
+    for (int trial = 0; trial < NUM_TRIALS; ++trial) {
+        std::vector<Action> actions(static_cast<std::size_t>(rng() % MAX_DEPTH));
+        for (auto &action : actions) {
+            action = static_cast<Action>(rng() % kNumActions);
+        }
+        std::vector<Action> augmented_actions(actions.size() * static_cast<std::size_t>(num_symmetries));
+        augment_actions(actions.data(), static_cast<int>(actions.size()), num_symmetries, augmented_actions.data());
+
+        TSPGameState state(level);
+        for (const auto action : actions) {
+            state.apply_action(action);
+        }
+        const auto obs = state.get_observation();
+        std::vector<float> augmented_obs(obs_size * static_cast<std::size_t>(num_symmetries));
+        augment_observations(obs.data(), 1, kNumChannels, level->get_rows(), level->get_cols(), augmented_obs.data());
+
+        for (int s = 0; s < num_symmetries; ++s) {
+            const auto symmetry = static_cast<Symmetry>(s);
+            TSPGameState symmetric_state(levels[static_cast<std::size_t>(s)]);
+            for (std::size_t i = 0; i < actions.size(); ++i) {
+                symmetric_state.apply_action(augmented_actions[(i * static_cast<std::size_t>(num_symmetries)) +
+                                                               static_cast<std::size_t>(s)]);
+            }
+            const auto expected_begin = augmented_obs.begin() + static_cast<std::ptrdiff_t>(obs_size * s);
+            const auto expected_end = expected_begin + static_cast<std::ptrdiff_t>(obs_size);
+            const std::vector<float> expected_obs(expected_begin, expected_end);
+            if (symmetric_state.get_symmetry_hash(Symmetry::kIdentity) != state.get_symmetry_hash(symmetry) ||
+                symmetric_state.get_canonical_hash() != state.get_canonical_hash() ||
+                symmetric_state.get_observation() != expected_obs) {
+                std::cerr << "Symmetry " << s << " mismatch on trial " << trial << std::endl;
+                std::cerr << state << symmetric_state;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Tracked symmetry hashes survive undo and match a state restored from scratch
+auto test_undo(const std::string &board_str) -> bool {
+    const auto level = std::make_shared<const TSPLevel>(board_str);
+    const int num_symmetries = get_num_symmetries(level->get_rows(), level->get_cols());
+    std::mt19937 rng(0);
+    for (int trial = 0; trial < NUM_TRIALS; ++trial) {
+        TSPGameState state(level);
+        std::vector<TSPUndoRecord> records;
+        const auto depth = static_cast<int>(rng() % MAX_DEPTH) + 1;
+        for (int i = 0; i < depth; ++i) {
+            records.push_back(state.apply_action_with_undo(static_cast<Action>(rng() % kNumActions)));
+        }
+        for (std::size_t i = 0; i < records.size() / 2; ++i) {
+            state.undo_action(records.back());
+            records.pop_back();
+        }
+        std::vector<uint64_t> words(static_cast<std::size_t>(level->get_num_cities() + 63) / 64);
+        state.get_visited_city_words(words.data());
+        const TSPGameState restored(level, state.get_agent_index(), state.get_start_city_index(), words.data());
+        for (int s = 0; s < num_symmetries; ++s) {
+            const auto symmetry = static_cast<Symmetry>(s);
+            if (state.get_symmetry_hash(symmetry) != restored.get_symmetry_hash(symmetry)) {
+                std::cerr << "Symmetry hash " << s << " differs after undo" << std::endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Boards which are not symmetric images of each other get different canonical hashes
+auto test_distinct() -> bool {
+    const TSPGameState state("3|3|03|00|00|00|01|00|00|00|00");
+    const TSPGameState corner_city("3|3|00|00|03|00|01|00|00|00|00");
+    const TSPGameState edge_city("3|3|00|03|00|00|01|00|00|00|00");
+    const TSPGameState wall("3|3|03|00|00|00|01|00|00|00|02");
+    return state.get_canonical_hash() == corner_city.get_canonical_hash() &&
+           state.get_canonical_hash() != edge_city.get_canonical_hash() &&
+           state.get_canonical_hash() != wall.get_canonical_hash();
+}
+
+auto test_policies() -> bool {
+    const std::vector<float> policy{0.1F, 0.2F, 0.3F, 0.4F};
+    std::vector<float> augmented(kNumSymmetries * kNumActions);
+    augment_policies(policy.data(), 1, kNumSymmetries, augmented.data());
+    for (int s = 0; s < kNumSymmetries; ++s) {
+        for (int a = 0; a < kNumActions; ++a) {
+            const auto new_action = transform_action(static_cast<Symmetry>(s), static_cast<Action>(a));
+            if (augmented[static_cast<std::size_t>((s * kNumActions) + static_cast<int>(new_action))] !=
+                policy[static_cast<std::size_t>(a)]) {
+                return false;
+            }
+        }
+    }
+    // Rotating a quarter turn clockwise turns up into right
+    return transform_action(Symmetry::kRotate90, Action::kUp) == Action::kRight &&
+           transform_action(Symmetry::kTranspose, Action::kUp) == Action::kLeft;
+}
+}    // namespace
+
+int main() {
+    const GeneratorOptions options{.map_size = 10, .num_cities = 6, .add_walls = true, .num_random_walls = 20};
+    const std::string square_board_str = generate_board_str(options, 0);
+    const std::string rect_board_str =
+        "4|6|03|00|02|00|00|03|00|00|02|00|00|00|00|01|00|00|02|00|03|00|00|00|02|00";
+    bool passed = test_symmetric_states(square_board_str) && test_symmetric_states(rect_board_str);
+    passed = passed && test_undo(square_board_str) && test_undo(rect_board_str);
+    passed = passed && test_distinct();
+    passed = passed && test_policies();
+    std::cout << (passed ? "passed" : "failed") << std::endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,68 @@
+#include <tsp/tsp.h>
+
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace tsp;
+
+constexpr int NUM_TRIALS = 1000;
+constexpr int MAX_DEPTH = 64;
+constexpr int LONG_PATH_CITIES = 300;
+
+namespace {
+auto test_undo(const std::string &board_str) -> bool {
+    const TSPGameState init_state(board_str);
+    std::mt19937 rng(0);
+
+    for (int trial = 0; trial < NUM_TRIALS; ++trial) {
+        auto state = init_state;
+        std::vector<TSPGameState> history;
+        std::vector<TSPUndoRecord> records;
+        const auto depth = static_cast<int>(rng() % MAX_DEPTH) + 1;
+        for (int i = 0; i < depth; ++i) {
+            history.push_back(state);
+            records.push_back(state.apply_action_with_undo(static_cast<Action>(rng() % kNumActions)));
+        }
+        while (!records.empty()) {
+            state.undo_action(records.back());
+            const auto &expected = history.back();
+            if (state != expected || state.get_hash128() != expected.get_hash128() ||
+                state.get_reward_signal() != expected.get_reward_signal() ||
+                state.get_observation() != expected.get_observation()) {
+                std::cerr << "Undo mismatch on trial " << trial << std::endl;
+                std::cerr << state << expected;
+                return false;
+            }
+            records.pop_back();
+            history.pop_back();
+        }
+    }
+    return true;
+}
+
+// A path through more than 255 cities gives a reward signal which must survive an undo
+auto test_undo_after_long_path() -> bool {
+    std::string board_str = "1|" + std::to_string(LONG_PATH_CITIES + 1) + "|01";
+    for (int i = 0; i < LONG_PATH_CITIES; ++i) {
+        board_str += "|03";
+    }
+    TSPGameState state(board_str);
+    state.apply_path(LONG_PATH_CITIES);
+    const auto expected = state;
+    const auto record = state.apply_action_with_undo(Action::kLeft);
+    state.undo_action(record);
+    return expected.get_reward_signal() == static_cast<uint64_t>(LONG_PATH_CITIES) && state == expected &&
+           state.get_reward_signal() == expected.get_reward_signal();
+}
+}    // namespace
+
+int main() {
+    const std::string board_str =
+        "10|10|02|00|00|00|00|00|00|00|00|02|00|02|00|00|00|00|00|00|02|00|00|00|02|00|00|00|00|02|01|00|00|00|00|02|"
+        "00|00|02|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|03|00|02|00|00|02|00|00|00|"
+        "00|00|02|00|00|00|00|02|00|00|00|02|00|03|00|00|00|00|02|00|02|00|00|00|00|00|00|00|00|02";
+    const bool passed = test_undo(board_str) && test_undo_after_long_path();
+    std::cout << (passed ? "passed" : "failed") << std::endl;
+    return passed ? 0 : 1;
+}
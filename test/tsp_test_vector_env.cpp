@@ -0,0 +1,113 @@
+#include <tsp/tsp.h>
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace tsp;
+
+constexpr int NUM_LEVELS = 3;
+constexpr int NUM_ENVS = 10;
+constexpr int NUM_THREADS = 3;
+constexpr int NUM_STEPS = 2000;
+
+namespace {
+auto make_levels() -> std::vector<TSPLevelPtr> {
+    const GeneratorOptions options{.map_size = 5, .num_cities = 2, .require_reachable = true};
+    std::vector<TSPLevelPtr> levels;
+    for (int i = 0; i < NUM_LEVELS; ++i) {
+        levels.push_back(generate_level(options, static_cast<uint64_t>(i)));
+    }
+    return levels;
+}
+
+// Step the batch alongside a replica of each environment, which is reset by hand to the level expected next
+auto test_against_replicas(bool auto_reset) -> bool {
+    const auto levels = make_levels();
+    TSPVectorEnv env(levels, NUM_ENVS, NUM_THREADS, auto_reset);
+    const auto obs_size = static_cast<std::size_t>(kNumChannels * levels[0]->get_num_cells());
+
+    std::vector<TSPGameState> replicas;
+    std::vector<int> episode_counts(NUM_ENVS, 0);
+    for (int i = 0; i < NUM_ENVS; ++i) {
+        replicas.emplace_back(levels[static_cast<std::size_t>(i % NUM_LEVELS)]);
+    }
+    // Observations kept up to date incrementally from the replicas, which must match the batch as well
+    std::vector<float> incremental_obs(NUM_ENVS * obs_size);
+    for (std::size_t i = 0; i < replicas.size(); ++i) {
+        replicas[i].get_observation(&incremental_obs[i * obs_size]);
+    }
+    if (env.get_observations() != incremental_obs) {
+        std::cerr << "Initial observations differ" << std::endl;
+        return false;
+    }
+
+    std::mt19937 rng(0);
+    std::vector<Action> actions(NUM_ENVS);
+    int num_solved = 0;
+    for (int step = 0; step < NUM_STEPS; ++step) {
+        for (auto &action : actions) {
+            action = static_cast<Action>(rng() % kNumActions);
+        }
+        env.step(actions.data());
+        for (std::size_t i = 0; i < replicas.size(); ++i) {
+            auto &replica = replicas[i];
+            float *obs = &incremental_obs[i * obs_size];
+            const int prev_agent_idx = replica.get_agent_index();
+            replica.apply_action(actions[i]);
+            const bool solved = replica.is_solution();
+            if (env.get_rewards()[i] != static_cast<float>(replica.get_reward_signal()) ||
+                env.get_solutions()[i] != static_cast<uint8_t>(solved) || env.get_hashes()[i] != replica.get_hash()) {
+                std::cerr << "Step outputs differ for env " << i << " on step " << step << std::endl;
+                return false;
+            }
+            num_solved += solved ? 1 : 0;
+            if (auto_reset && solved) {
+                // Environment i plays levels i, i + NUM_ENVS, i + 2 * NUM_ENVS, ... in order
+                const auto level_idx = (i + (static_cast<std::size_t>(++episode_counts[i]) * NUM_ENVS)) % NUM_LEVELS;
+                replica = TSPGameState(levels[level_idx]);
+                replica.get_observation(obs);
+                if (env.get_state(static_cast<int>(i)).get_level() != levels[level_idx]) {
+                    std::cerr << "Env " << i << " reset to the wrong level" << std::endl;
+                    return false;
+                }
+            } else {
+                replica.update_observation(obs, prev_agent_idx);
+            }
+            if (env.get_state(static_cast<int>(i)) != replica) {
+                std::cerr << "State differs for env " << i << " on step " << step << std::endl;
+                return false;
+            }
+            const auto full_obs = replica.get_observation();
+            if (!std::equal(full_obs.begin(), full_obs.end(), env.get_observations().begin() + (i * obs_size)) ||
+                !std::equal(full_obs.begin(), full_obs.end(), obs)) {
+                std::cerr << "Observation differs for env " << i << " on step " << step << std::endl;
+                return false;
+            }
+        }
+    }
+    if (num_solved == 0) {
+        std::cerr << "No environment reached the solution" << std::endl;
+        return false;
+    }
+
+    // Reset returns every environment to the first level in its sequence
+    env.reset();
+    for (int i = 0; i < NUM_ENVS; ++i) {
+        const auto idx = static_cast<std::size_t>(i);
+        if (env.get_state(i) != TSPGameState(levels[idx % NUM_LEVELS]) || env.get_rewards()[idx] != 0 ||
+            env.get_solutions()[idx] != 0) {
+            std::cerr << "Reset did not restore env " << i << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+}    // namespace
+
+int main() {
+    const bool passed = test_against_replicas(true) && test_against_replicas(false);
+    std::cout << (passed ? "passed" : "failed") << std::endl;
+    return passed ? 0 : 1;
+}
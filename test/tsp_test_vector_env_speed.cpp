@@ -0,0 +1,58 @@
+#include <tsp/tsp.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace tsp;
+
+using std::chrono::duration;
+using std::chrono::high_resolution_clock;
+
+constexpr int NUM_ENVS = 4096;
+constexpr int NUM_STEPS = 500;
+constexpr int MILLISECONDS_PER_SECOND = 1000;
+
+namespace {
+void test_speed(const TSPLevelPtr &level, const std::vector<Action> &actions, int num_threads) {
+    TSPVectorEnv env({level}, NUM_ENVS, num_threads);
+
+    const auto t1 = high_resolution_clock::now();
+    uint64_t h = 0;
+    for (int i = 0; i < NUM_STEPS; ++i) {
+        env.step(&actions[static_cast<std::size_t>(i) * NUM_ENVS]);
+        h ^= env.get_hashes()[0];
+    }
+    const auto t2 = high_resolution_clock::now();
+    const duration<double, std::milli> ms_double = t2 - t1;
+    const double seconds = ms_double.count() / MILLISECONDS_PER_SECOND;
+    std::cout << "threads: " << num_threads << ", steps/sec: " << (NUM_STEPS * static_cast<double>(NUM_ENVS)) / seconds
+              << " (" << h << ")" << std::endl;
+}
+}    // namespace
+
+int main() {
+    const std::string board_str =
+        "12|12|02|00|00|00|00|00|00|00|00|00|00|02|00|02|00|00|00|00|00|00|00|00|02|00|00|00|02|00|00|00|00|00|00|02|"
+        "00|00|00|00|00|02|00|00|00|00|02|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|00|"
+        "00|00|00|00|00|00|00|00|00|00|00|00|03|00|00|03|00|00|00|00|00|00|00|00|00|00|00|00|00|02|00|03|00|00|02|00|"
+        "00|00|00|00|02|00|00|00|00|00|00|02|00|00|00|02|00|00|00|03|00|00|01|00|02|00|02|00|00|00|00|00|00|00|00|00|"
+        "00|02";
+    const auto level = std::make_shared<const TSPLevel>(board_str);
+
+    std::mt19937 rng(0);
+    std::vector<Action> actions(static_cast<std::size_t>(NUM_STEPS) * NUM_ENVS);
+    for (auto &action : actions) {
+        action = static_cast<Action>(rng() % kNumActions);
+    }
+
+    const int max_threads = static_cast<int>(std::max(1U, std::thread::hardware_concurrency()));
+    for (int num_threads = 1; num_threads < max_threads; num_threads *= 2) {
+        test_speed(level, actions, num_threads);
+    }
+    test_speed(level, actions, max_threads);
+}
@@ -0,0 +1,113 @@
+// Generate train and test level sets, with the same options as scripts/generate_levelset.py
+#include <tsp/tsp.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+
+using namespace tsp;
+
+namespace {
+void print_usage(const char *program) {
+    std::cerr << "Usage: " << program << " --num_cities N --export_path PATH [options]\n"
+              << "  --num_train N          Number of maps in train set (default 10000)\n"
+              << "  --num_test N           Number of maps in test set (default 1000)\n"
+              << "  --map_size N           Size of map width/height (default 10)\n"
+              << "  --num_cities N         Number of cities\n"
+              << "  --add_walls            Add the diagonal wall pattern\n"
+              << "  --num_random_walls N   Number of walls placed on random cells (default 0)\n"
+              << "  --require_reachable    Resample levels where a city can't be reached\n"
+              << "  --difficulty           Also write {train,test}_difficulty.txt with the bounds of each level\n"
+              << "  --seed N               Seed of the first level (default 0)\n"
+              << "  --num_threads N        Number of threads, or 0 for the hardware concurrency (default 0)\n"
+              << "  --export_path PATH     Export path for the level set files\n";
+}
+
+void write_split(const GeneratorOptions &options, const std::filesystem::path &export_path, const std::string &name,
+                 uint64_t first_seed, std::size_t count, bool difficulty) {
+    std::ofstream out(export_path / (name + ".txt"), std::ios::binary);
+    std::unique_ptr<std::ofstream> difficulty_out;
+    if (difficulty) {
+        difficulty_out = std::make_unique<std::ofstream>(export_path / (name + "_difficulty.txt"), std::ios::binary);
+    }
+    if (!out || (difficulty_out && !*difficulty_out)) {
+        throw std::runtime_error("Could not open the output files in " + export_path.string());
+    }
+    write_generated_levels(options, first_seed, count, out, difficulty_out.get());
+    if (!out || (difficulty_out && !*difficulty_out)) {
+        throw std::runtime_error("Could not write the output files in " + export_path.string());
+    }
+}
+}    // namespace
+
+int main(int argc, char **argv) {
+    GeneratorOptions options;
+    options.num_threads = 0;
+    std::size_t num_train = 10000;
+    std::size_t num_test = 1000;
+    uint64_t seed = 0;
+    bool has_num_cities = false;
+    bool difficulty = false;
+    std::string export_path;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            const auto next_value = [&]() -> std::string {
+                if (i + 1 >= argc) {
+                    throw std::invalid_argument("Missing value for " + arg);
+                }
+                return argv[++i];
+            };
+            if (arg == "--num_train") {
+                num_train = std::stoull(next_value());
+            } else if (arg == "--num_test") {
+                num_test = std::stoull(next_value());
+            } else if (arg == "--map_size") {
+                options.map_size = std::stoi(next_value());
+            } else if (arg == "--num_cities") {
+                options.num_cities = std::stoi(next_value());
+                has_num_cities = true;
+            } else if (arg == "--add_walls") {
+                options.add_walls = true;
+            } else if (arg == "--num_random_walls") {
+                options.num_random_walls = std::stoi(next_value());
+            } else if (arg == "--require_reachable") {
+                options.require_reachable = true;
+            } else if (arg == "--difficulty") {
+                difficulty = true;
+            } else if (arg == "--seed") {
+                seed = std::stoull(next_value());
+            } else if (arg == "--num_threads") {
+                options.num_threads = std::stoi(next_value());
+            } else if (arg == "--export_path") {
+                export_path = next_value();
+            } else {
+                throw std::invalid_argument("Unknown argument " + arg);
+            }
+        }
+        if (!has_num_cities || export_path.empty()) {
+            throw std::invalid_argument("--num_cities and --export_path are required");
+        }
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    try {
+        // Train levels use the first seeds and test levels the following ones
+        std::filesystem::create_directories(export_path);
+        write_split(options, export_path, "train", seed, num_train, difficulty);
+        write_split(options, export_path, "test", seed + num_train, num_test, difficulty);
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,103 @@
+// Label each level of a level set file with its optimal solution cost
+#include <tsp/tsp.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace tsp;
+
+namespace {
+// Number of levels solved between writes
+constexpr std::size_t BATCH_SIZE = 1 << 14;
+constexpr std::size_t BYTES_PER_MB = std::size_t{1} << 20;
+
+void print_usage(const char *program) {
+    std::cerr << "Usage: " << program << " --input PATH --output PATH [options]\n"
+              << "  --input PATH       Level set file, with one board string per line\n"
+              << "  --output PATH      Output file, with the optimal cost of each level per line (-1 if unsolved)\n"
+              << "  --tour             Also write the cell indices of the cities in visit order after each cost\n"
+              << "  --max_memory_mb N  Memory budget of each solve in MB (default 1024)\n"
+              << "  --num_threads N    Number of threads, or 0 for the hardware concurrency (default 0)\n";
+}
+}    // namespace
+
+int main(int argc, char **argv) {
+    TourSolverOptions options;
+    options.num_threads = 0;
+    std::string input_path;
+    std::string output_path;
+    bool write_tour = false;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            const auto next_value = [&]() -> std::string {
+                if (i + 1 >= argc) {
+                    throw std::invalid_argument("Missing value for " + arg);
+                }
+                return argv[++i];
+            };
+            if (arg == "--input") {
+                input_path = next_value();
+            } else if (arg == "--output") {
+                output_path = next_value();
+            } else if (arg == "--tour") {
+                write_tour = true;
+            } else if (arg == "--max_memory_mb") {
+                options.max_bytes = std::stoull(next_value()) * BYTES_PER_MB;
+            } else if (arg == "--num_threads") {
+                options.num_threads = std::stoi(next_value());
+            } else {
+                throw std::invalid_argument("Unknown argument " + arg);
+            }
+        }
+        if (input_path.empty() || output_path.empty()) {
+            throw std::invalid_argument("--input and --output are required");
+        }
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    try {
+        const LevelSet level_set(input_path);
+        std::ofstream out(output_path, std::ios::binary);
+        if (!out) {
+            throw std::runtime_error("Could not open " + output_path);
+        }
+        std::size_t num_unsolved = 0;
+        std::vector<std::string> board_strs;
+        for (std::size_t batch_begin = 0; batch_begin < level_set.size(); batch_begin += BATCH_SIZE) {
+            const std::size_t batch_end = std::min(batch_begin + BATCH_SIZE, level_set.size());
+            board_strs.clear();
+            for (std::size_t i = batch_begin; i < batch_end; ++i) {
+                board_strs.emplace_back(level_set.get_board_str(i));
+            }
+            for (const auto &result : solve_tour_levels(board_strs, options)) {
+                num_unsolved += result.solved ? 0 : 1;
+                out << result.cost;
+                if (write_tour) {
+                    for (const int city : result.tour) {
+                        out << ' ' << city;
+                    }
+                }
+                out << '\n';
+            }
+        }
+        if (!out.flush()) {
+            throw std::runtime_error("Could not write " + output_path);
+        }
+        std::cout << "Labelled " << level_set.size() << " levels, " << num_unsolved << " unsolved" << std::endl;
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}